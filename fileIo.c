@@ -17,6 +17,11 @@
 /* fileIo.c file i/o needed to load and save. */
 /* this version support 32/64 bit systems, file size up to 4 GB */
 
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <strings.h>
+
 #include "fileIo.h"
 
 #define MaxSize32 ((((unsigned long int)1)<<31)-1) /* 2^31-1 = 2147483647 */
@@ -118,12 +123,13 @@ off_t getFileSize(char* fileName, FILE** filePtrPtr) {
    return len;
 } // getFileSize()
 
-/* support 64 bit systems, but not file size greather than 4 GB, require C99 */
+/* support 64 bit systems and any file size that fit in RAM, require C99 */
 /* open and copy a file in RAM and return allocated bufferPtr, buffer size or ERROR */
 /* Then the file is closed. The user must free the bufferPtr at end of use */
 off_t readFile(char* fileName, char** bufferPtrPtr) {
    FILE* filePtr;
    off_t len;                             /* SUS: off_t is signed long long */
+   off_t done;
    size_t Nch;          /* U32: like an unsigned int, not an unsigned long! */
    int out;
    if (fileName==NULL) {
@@ -140,27 +146,29 @@ off_t readFile(char* fileName, char** bufferPtrPtr) {
       return ERROR;
    }
    if (dbgLev>=PRINTVERBOSE) printf("file length:\"%s\" is %lld\n", fileName, (s64)len);
-   if (len>MaxSize32) { /* limit memory allocation to 2 GB */
+   if ((u64)len >= (u64)SIZE_MAX) { /* 32 bit systems: no more than size_t */
       if (dbgLev>=PRINTERROR) printf("ERROR %s: file \"%s\" too big:%lld\n", __FUNCTION__, fileName, (s64)len);
+      fclose(filePtr);
       return ERROR;
    }
    *bufferPtrPtr = (char*) malloc(len+1);               /* room for NULL */
    //printf("allocated %lld Bytes @%p\n", (s64)len+1, *bufferPtrPtr);
    if (*bufferPtrPtr==NULL) {
       if (dbgLev>=PRINTERROR) printf("ERROR %s: cannot allocate %lld bytes of memory\n", __FUNCTION__, (s64)len);
+      fclose(filePtr);
       return ERROR;
    }
    if (dbgLev>=PRINTVERBOSE) printf("%s: buffer allocated at %p\n", __FUNCTION__, *bufferPtrPtr);
-   if (len >= MaxSize32) {
-      if (dbgLev>=PRINTERROR) printf("ERROR %s: cannot read so much:%lld with size_t fread(3)\n", __FUNCTION__, (s64)len);
-      return ERROR;
-   }
-   Nch = fread(*bufferPtrPtr, 1, len, filePtr);
-   if (Nch != len) {
-      if (dbgLev>=PRINTERROR) printf("ERROR %s: cannot read Nch/len:%zu/%lld from file:\"%s\"\n", __FUNCTION__, Nch, (s64)len, fileName);
-      return Nch;
+   for (done=0; done<len; done+=Nch) { /* fread(3) in chunks, no 2 GB limit */
+      size_t want = (len-done < ChunkLen) ? (size_t)(len-done) : ChunkLen;
+      Nch = fread(*bufferPtrPtr+done, 1, want, filePtr);
+      if (Nch != want) {
+         if (dbgLev>=PRINTERROR) printf("ERROR %s: cannot read Nch/len:%lld/%lld from file:\"%s\"\n", __FUNCTION__, (s64)(done+Nch), (s64)len, fileName);
+         fclose(filePtr);
+         return done+Nch;
+      }
    }
-   if (dbgLev>=PRINTVERBOSE) printf("%s(): file:'%s' of '%zu' chars readed in buffer\n", __FUNCTION__, fileName, Nch);
+   if (dbgLev>=PRINTVERBOSE) printf("%s(): file:'%s' of '%lld' chars readed in buffer\n", __FUNCTION__, fileName, (s64)len);
    //if (dbgLev>=PRINTVERBOSE) printNchar( ((*bufferPtrPtr)+len-5), 5 );
    *((*bufferPtrPtr)+len) = TERM; /* insert terminator */
    if (dbgLev>=PRINTVERBOSE) printf("%s() line:%u\n", __FUNCTION__, __LINE__);
@@ -172,6 +180,168 @@ off_t readFile(char* fileName, char** bufferPtrPtr) {
    return len;
 } // readFile()
 
+/* open a file to read it in chunks of size bytes. Return OK or ERROR */
+errOk openChunk(char* fileName, chunkTy* chunkPtr, size_t size) {
+   if (chunkPtr==NULL || size==0) {
+      if (dbgLev>=PRINTERROR) printf("ERROR %s: chunkPtr NULL or size zero\n", __FUNCTION__);
+      return ERROR;
+   }
+   memset(chunkPtr, 0, sizeof(chunkTy));
+   chunkPtr->len = getFileSize(fileName, &chunkPtr->filePtr);
+   if (chunkPtr->len<0) {
+      if (dbgLev>=PRINTERROR) printf("ERROR %s: getFileSize returned:%lld on File:\"%s\"\n", __FUNCTION__, (s64)chunkPtr->len, fileName);
+      return ERROR;
+   }
+   chunkPtr->bufPtr = malloc(size+1);                   /* room for NULL */
+   if (chunkPtr->bufPtr==NULL) {
+      if (dbgLev>=PRINTERROR) printf("ERROR %s: cannot allocate %zu bytes of memory\n", __FUNCTION__, size);
+      fclose(chunkPtr->filePtr);
+      return ERROR;
+   }
+   chunkPtr->size = size;
+   *chunkPtr->bufPtr = TERM;
+   return OK;
+} // openChunk()
+
+/* move the bytes not used yet at chunk start and fill it from file */
+/* return bytes available from pos, 0 at end of file */
+size_t readChunk(chunkTy* chunkPtr) {
+   size_t Nch;
+   if (chunkPtr==NULL || chunkPtr->bufPtr==NULL) return 0;
+   chunkPtr->fill -= chunkPtr->pos;
+   memmove(chunkPtr->bufPtr, chunkPtr->bufPtr+chunkPtr->pos, chunkPtr->fill);
+   chunkPtr->pos = 0;
+   if (!chunkPtr->eof && chunkPtr->fill<chunkPtr->size) {
+      Nch = fread(chunkPtr->bufPtr+chunkPtr->fill, 1, chunkPtr->size-chunkPtr->fill, chunkPtr->filePtr);
+      chunkPtr->fill += Nch;
+      chunkPtr->done += Nch;
+      if (Nch==0 || chunkPtr->done>=chunkPtr->len) chunkPtr->eof = 1;
+   }
+   *(chunkPtr->bufPtr+chunkPtr->fill) = TERM; /* insert terminator */
+   return chunkPtr->fill;
+} // readChunk()
+
+/* close a file read in chunks and free its buffer */
+void closeChunk(chunkTy* chunkPtr) {
+   if (chunkPtr==NULL) return;
+   if (chunkPtr->filePtr) fclose(chunkPtr->filePtr);
+   free(chunkPtr->bufPtr);
+   memset(chunkPtr, 0, sizeof(chunkTy));
+} // closeChunk()
+
+/* read an INI file in RAM and split it in sections and keys, in one pass */
+/* arrays of the previous file are reused. Return OK or ERROR */
+errOk iniRead(char* fileName, iniTy* iniPtr) {
+   if (iniPtr==NULL) {
+      if (dbgLev>=PRINTERROR) printf("ERROR %s: iniPtr point to NULL\n", __FUNCTION__);
+      return ERROR;
+   }
+   free(iniPtr->bufPtr);
+   iniPtr->bufPtr=NULL;
+   iniPtr->sects=0;
+   iniPtr->keys=0;
+   char* bufPtr;
+   off_t len=readFile(fileName, &bufPtr);
+   if (len<0) return ERROR;
+   iniPtr->bufPtr=bufPtr;
+   char* endPtr=bufPtr+len;
+   char* nextPtr;
+   int line=0;
+   for (char* chPtr=bufPtr; chPtr<endPtr; chPtr=nextPtr) { /* one line at a time */
+      line++;
+      nextPtr=memchr(chPtr, '\n', endPtr-chPtr);
+      if (nextPtr) *nextPtr=TERM; else nextPtr=endPtr;
+      char* lastPtr=nextPtr-1; /* trim both ends, CR too */
+      nextPtr++;
+      while (chPtr<=lastPtr && isspace((unsigned char)*chPtr)) chPtr++;
+      while (lastPtr>=chPtr && isspace((unsigned char)*lastPtr)) *lastPtr--=TERM;
+      if (*chPtr==TERM || *chPtr==';' || *chPtr=='#') continue; /* empty or comment */
+      if (*chPtr=='[') { /* "[name] ; comment" */
+         char* closePtr=strchr(chPtr, ']');
+         if (closePtr) {
+            char* cmtPtr=closePtr+1;
+            while (isspace((unsigned char)*cmtPtr)) cmtPtr++;
+            if (*cmtPtr==TERM || *cmtPtr==';' || *cmtPtr=='#') { /* only a comment after ']' */
+               *(closePtr+1)=TERM;
+               lastPtr=closePtr;
+            }
+         }
+      }
+      if (*chPtr=='[' && *lastPtr==']') { /* "[name]" */
+         *lastPtr--=TERM;
+         for (chPtr++; isspace((unsigned char)*chPtr); chPtr++);
+         while (lastPtr>=chPtr && isspace((unsigned char)*lastPtr)) *lastPtr--=TERM;
+         for (char* lowPtr=chPtr; *lowPtr; lowPtr++) *lowPtr=tolower((unsigned char)*lowPtr);
+         if (iniPtr->sects==iniPtr->sectMax) {
+            int max=iniPtr->sectMax ? 2*iniPtr->sectMax : 64;
+            iniSectTy* sectPtr=realloc(iniPtr->sect, max*sizeof(iniSectTy));
+            if (sectPtr==NULL) goto noMem;
+            iniPtr->sect=sectPtr;
+            iniPtr->sectMax=max;
+         }
+         iniSectTy* sectPtr=&iniPtr->sect[iniPtr->sects++];
+         sectPtr->name=chPtr;
+         sectPtr->first=iniPtr->keys;
+         sectPtr->keys=0;
+         continue;
+      }
+      char* valPtr=strchr(chPtr, '='); /* "key = value ; comment" */
+      if (valPtr==NULL || valPtr==chPtr) {
+         if (dbgLev>=PRINTERROR) printf("ERROR %s: syntax error in file:\"%s\" line:%d\n", __FUNCTION__, fileName, line);
+         return ERROR;
+      }
+      *valPtr++=TERM;
+      for (char* keyEndPtr=valPtr-1; keyEndPtr>chPtr && isspace((unsigned char)keyEndPtr[-1]); keyEndPtr--) keyEndPtr[-1]=TERM;
+      while (isspace((unsigned char)*valPtr)) valPtr++;
+      if (*valPtr=='"' || *valPtr=='\'') { /* quoted: comment chars are kept */
+         char* quotePtr=strchr(valPtr+1, *valPtr);
+         valPtr++;
+         if (quotePtr) *quotePtr=TERM;
+      } else {
+         char* cmtPtr=strpbrk(valPtr, ";#");
+         if (cmtPtr) {
+            *cmtPtr=TERM;
+            while (cmtPtr>valPtr && isspace((unsigned char)cmtPtr[-1])) *--cmtPtr=TERM;
+         }
+      }
+      if (iniPtr->sects==0) continue; /* keys before the first section are not used */
+      if (iniPtr->keys==iniPtr->keyMax) {
+         int max=iniPtr->keyMax ? 2*iniPtr->keyMax : 256;
+         iniKeyTy* keyPtr=realloc(iniPtr->key, max*sizeof(iniKeyTy));
+         if (keyPtr==NULL) goto noMem;
+         iniPtr->key=keyPtr;
+         iniPtr->keyMax=max;
+      }
+      iniPtr->key[iniPtr->keys].key=chPtr;
+      iniPtr->key[iniPtr->keys].val=valPtr;
+      iniPtr->keys++;
+      iniPtr->sect[iniPtr->sects-1].keys++;
+   }
+   return OK;
+   noMem:
+   if (dbgLev>=PRINTERROR) printf("ERROR %s: cannot allocate memory for file:\"%s\"\n", __FUNCTION__, fileName);
+   return ERROR;
+} // iniRead()
+
+/* value of key in section sect, last one when repeated, NULL when none */
+char* iniGet(const iniTy* iniPtr, int sect, const char* keyPtr) {
+   if (iniPtr==NULL || sect<0 || sect>=iniPtr->sects) return NULL;
+   const iniSectTy* sectPtr=&iniPtr->sect[sect];
+   for (int k=sectPtr->first+sectPtr->keys-1; k>=sectPtr->first; k--) {
+      if (strcasecmp(iniPtr->key[k].key, keyPtr)==0) return iniPtr->key[k].val;
+   }
+   return NULL;
+} // iniGet()
+
+/* free an INI file read by iniRead() */
+void iniFree(iniTy* iniPtr) {
+   if (iniPtr==NULL) return;
+   free(iniPtr->bufPtr);
+   free(iniPtr->sect);
+   free(iniPtr->key);
+   memset(iniPtr, 0, sizeof(iniTy));
+} // iniFree()
+
 /* support 64 bit systems, but not file size greather than 4 GB, require C99 */
 /* copy RAM on created file and return written bytes or ERROR */
 size_t writeFile(char* fileName, char* bufferPtr) { /* copy from RAM to file */
@@ -217,6 +387,340 @@ size_t writeFile(char* fileName, char* bufferPtr) { /* copy from RAM to file */
    return Nblk;
 } // writeFile()
 
+/* shortest round trip double to decimal by Grisu2 (Loitsch 2010) */
+/* the digits are always inside the rounding interval, so they read back */
+/* the same double. Very few values get a digit more than the shortest */
+typedef struct diyFpTy { /* f*2^e */
+   u64 f;
+   int e;
+} diyFpTy;
+
+static const diyFpTy cachedPow[87] = { /* 10^(8i-348) normalized, rounded */
+   {0xfa8fd5a0081c0288ull,-1220}, {0xbaaee17fa23ebf76ull,-1193}, {0x8b16fb203055ac76ull,-1166},
+   {0xcf42894a5dce35eaull,-1140}, {0x9a6bb0aa55653b2dull,-1113}, {0xe61acf033d1a45dfull,-1087},
+   {0xab70fe17c79ac6caull,-1060}, {0xff77b1fcbebcdc4full,-1034}, {0xbe5691ef416bd60cull,-1007},
+   {0x8dd01fad907ffc3cull,-980}, {0xd3515c2831559a83ull,-954}, {0x9d71ac8fada6c9b5ull,-927},
+   {0xea9c227723ee8bcbull,-901}, {0xaecc49914078536dull,-874}, {0x823c12795db6ce57ull,-847},
+   {0xc21094364dfb5637ull,-821}, {0x9096ea6f3848984full,-794}, {0xd77485cb25823ac7ull,-768},
+   {0xa086cfcd97bf97f4ull,-741}, {0xef340a98172aace5ull,-715}, {0xb23867fb2a35b28eull,-688},
+   {0x84c8d4dfd2c63f3bull,-661}, {0xc5dd44271ad3cdbaull,-635}, {0x936b9fcebb25c996ull,-608},
+   {0xdbac6c247d62a584ull,-582}, {0xa3ab66580d5fdaf6ull,-555}, {0xf3e2f893dec3f126ull,-529},
+   {0xb5b5ada8aaff80b8ull,-502}, {0x87625f056c7c4a8bull,-475}, {0xc9bcff6034c13053ull,-449},
+   {0x964e858c91ba2655ull,-422}, {0xdff9772470297ebdull,-396}, {0xa6dfbd9fb8e5b88full,-369},
+   {0xf8a95fcf88747d94ull,-343}, {0xb94470938fa89bcfull,-316}, {0x8a08f0f8bf0f156bull,-289},
+   {0xcdb02555653131b6ull,-263}, {0x993fe2c6d07b7facull,-236}, {0xe45c10c42a2b3b06ull,-210},
+   {0xaa242499697392d3ull,-183}, {0xfd87b5f28300ca0eull,-157}, {0xbce5086492111aebull,-130},
+   {0x8cbccc096f5088ccull,-103}, {0xd1b71758e219652cull,-77}, {0x9c40000000000000ull,-50},
+   {0xe8d4a51000000000ull,-24}, {0xad78ebc5ac620000ull,3}, {0x813f3978f8940984ull,30},
+   {0xc097ce7bc90715b3ull,56}, {0x8f7e32ce7bea5c70ull,83}, {0xd5d238a4abe98068ull,109},
+   {0x9f4f2726179a2245ull,136}, {0xed63a231d4c4fb27ull,162}, {0xb0de65388cc8ada8ull,189},
+   {0x83c7088e1aab65dbull,216}, {0xc45d1df942711d9aull,242}, {0x924d692ca61be758ull,269},
+   {0xda01ee641a708deaull,295}, {0xa26da3999aef774aull,322}, {0xf209787bb47d6b85ull,348},
+   {0xb454e4a179dd1877ull,375}, {0x865b86925b9bc5c2ull,402}, {0xc83553c5c8965d3dull,428},
+   {0x952ab45cfa97a0b3ull,455}, {0xde469fbd99a05fe3ull,481}, {0xa59bc234db398c25ull,508},
+   {0xf6c69a72a3989f5cull,534}, {0xb7dcbf5354e9beceull,561}, {0x88fcf317f22241e2ull,588},
+   {0xcc20ce9bd35c78a5ull,614}, {0x98165af37b2153dfull,641}, {0xe2a0b5dc971f303aull,667},
+   {0xa8d9d1535ce3b396ull,694}, {0xfb9b7cd9a4a7443cull,720}, {0xbb764c4ca7a44410ull,747},
+   {0x8bab8eefb6409c1aull,774}, {0xd01fef10a657842cull,800}, {0x9b10a4e5e9913129ull,827},
+   {0xe7109bfba19c0c9dull,853}, {0xac2820d9623bf429ull,880}, {0x80444b5e7aa7cf85ull,907},
+   {0xbf21e44003acdd2dull,933}, {0x8e679c2f5e44ff8full,960}, {0xd433179d9c8cb841ull,986},
+   {0x9e19db92b4e31ba9ull,1013}, {0xeb96bf6ebadf77d9ull,1039}, {0xaf87023b9bf0ee6bull,1066},
+};
+
+static const u64 pow10Tab[20] = {
+   1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+   100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+   10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+   100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull
+};
+
+static diyFpTy fpMul(diyFpTy x, diyFpTy y) { /* high 64 bit of the product, rounded */
+   u64 a = x.f>>32, b = x.f&0xFFFFFFFFull, c = y.f>>32, d = y.f&0xFFFFFFFFull;
+   u64 ac = a*c, bc = b*c, ad = a*d, bd = b*d;
+   u64 mid = (bd>>32) + (ad&0xFFFFFFFFull) + (bc&0xFFFFFFFFull) + (1ull<<31);
+   diyFpTy r = { ac + (ad>>32) + (bc>>32) + (mid>>32), x.e + y.e + 64 };
+   return r;
+} // fpMul()
+
+static diyFpTy fpNorm(diyFpTy x) {
+   int s = __builtin_clzll(x.f);
+   x.f <<= s;
+   x.e -= s;
+   return x;
+} // fpNorm()
+
+/* move the last digit down to the closest of the value, still in the interval */
+static void grisuRound(char* bufPtr, int len, u64 delta, u64 rest, u64 tenKappa, u64 wpW) {
+   while (rest<wpW && delta-rest>=tenKappa && (rest+tenKappa<wpW || wpW-rest>rest+tenKappa-wpW)) {
+      bufPtr[len-1]--;
+      rest += tenKappa;
+   }
+} // grisuRound()
+
+/* digits of the positive finite val in bufPtr, return count. val=digits*10^K */
+static int grisu2(double val, char* bufPtr, int* KPtr) {
+   u64 bits;
+   memcpy(&bits, &val, sizeof(bits));
+   u64 hidden = 1ull<<52;
+   int biased = (int)((bits>>52)&0x7FF);
+   diyFpTy v = { bits&(hidden-1), -1074 };
+   if (biased) {
+      v.f += hidden;
+      v.e = biased-1075;
+   }
+   diyFpTy pl = { (v.f<<1)+1, v.e-1 }; /* interval boundaries, normalized */
+   pl = fpNorm(pl);
+   diyFpTy mi = (v.f==hidden) ? (diyFpTy){ (v.f<<2)-1, v.e-2 } : (diyFpTy){ (v.f<<1)-1, v.e-1 };
+   mi.f <<= mi.e-pl.e;
+   mi.e = pl.e;
+   double dk = (-61-pl.e)*0.30102999566398114+347; /* cached power for pl.e in [-60,-32] */
+   int k = (int)dk;
+   if (dk-k>0.0) k++;
+   int index = (k>>3)+1;
+   *KPtr = -(-348+index*8);
+   diyFpTy cMk = cachedPow[index];
+   diyFpTy W = fpMul(fpNorm(v), cMk);
+   diyFpTy Wp = fpMul(pl, cMk);
+   diyFpTy Wm = fpMul(mi, cMk);
+   Wm.f++;
+   Wp.f--;
+   u64 delta = Wp.f-Wm.f;
+   diyFpTy one = { 1ull<<-Wp.e, Wp.e };
+   u64 wpW = Wp.f-W.f;
+   u32 p1 = (u32)(Wp.f>>-one.e);
+   u64 p2 = Wp.f&(one.f-1);
+   int kappa = 10;
+   while (kappa>1 && p1<pow10Tab[kappa-1]) kappa--; /* digits of p1 */
+   int len = 0;
+   while (kappa>0) {
+      u32 d = (u32)(p1/pow10Tab[kappa-1]);
+      p1 %= (u32)pow10Tab[kappa-1];
+      if (d || len) bufPtr[len++] = '0'+d;
+      kappa--;
+      u64 rest = ((u64)p1<<-one.e)+p2;
+      if (rest<=delta) {
+         *KPtr += kappa;
+         grisuRound(bufPtr, len, delta, rest, pow10Tab[kappa]<<-one.e, wpW);
+         return len;
+      }
+   }
+   for (;;) { /* kappa<=0 */
+      p2 *= 10;
+      delta *= 10;
+      char d = (char)(p2>>-one.e);
+      if (d || len) bufPtr[len++] = '0'+d;
+      p2 &= one.f-1;
+      kappa--;
+      if (p2<delta) {
+         *KPtr += kappa;
+         grisuRound(bufPtr, len, delta, p2, one.f, (-kappa<20) ? wpW*pow10Tab[-kappa] : 0);
+         return len;
+      }
+   }
+} // grisu2()
+
+/* shortest decimal of a double that strtod() read back to the same double */
+/* as %g of up to 17 digits: fixed from 1e-4 to 1e17, else d.ddde+XX */
+/* write it NUL terminated in strPtr[DblLen] and return its length */
+int dblStr(char* strPtr, double val) {
+   if (val!=val || val-val!=0) return sprintf(strPtr, "%g", val); /* nan, inf */
+   int len = 0;
+   if (signbit(val)) {
+      strPtr[len++] = '-';
+      val = -val;
+   }
+   if (val==0) {
+      strPtr[len++] = '0';
+      strPtr[len] = TERM;
+      return len;
+   }
+   char dig[20];
+   int K;
+   int n = grisu2(val, dig, &K);
+   int exp10 = n+K-1; /* exponent of the first digit */
+   if (exp10>=-4 && exp10<17) { /* fixed */
+      if (exp10<0) {
+         strPtr[len++] = '0';
+         strPtr[len++] = '.';
+         for (int z=-1; z>exp10; z--) strPtr[len++] = '0';
+         memcpy(strPtr+len, dig, n);
+         len += n;
+      } else if (exp10+1>=n) { /* integer */
+         memcpy(strPtr+len, dig, n);
+         len += n;
+         for (int z=n; z<=exp10; z++) strPtr[len++] = '0';
+      } else {
+         memcpy(strPtr+len, dig, exp10+1);
+         len += exp10+1;
+         strPtr[len++] = '.';
+         memcpy(strPtr+len, dig+exp10+1, n-exp10-1);
+         len += n-exp10-1;
+      }
+      strPtr[len] = TERM;
+      return len;
+   }
+   strPtr[len++] = dig[0];
+   if (n>1) {
+      strPtr[len++] = '.';
+      memcpy(strPtr+len, dig+1, n-1);
+      len += n-1;
+   }
+   len += sprintf(strPtr+len, "e%c%02d", exp10<0 ? '-' : '+', abs(exp10));
+   return len;
+} // dblStr()
+
+/* open a file to write it in chunks of size bytes. Return OK or ERROR */
+errOk openOut(char* fileName, outTy* outPtr, size_t size) {
+   if (outPtr==NULL || size==0) {
+      if (dbgLev>=PRINTERROR) printf("ERROR %s: outPtr NULL or size zero\n", __FUNCTION__);
+      return ERROR;
+   }
+   memset(outPtr, 0, sizeof(outTy));
+   outPtr->bufPtr = malloc(size);
+   if (outPtr->bufPtr==NULL) {
+      if (dbgLev>=PRINTERROR) printf("ERROR %s: cannot allocate %zu bytes of memory\n", __FUNCTION__, size);
+      return ERROR;
+   }
+   outPtr->filePtr = openWrite(fileName);
+   if (outPtr->filePtr==NULL) {
+      free(outPtr->bufPtr);
+      outPtr->bufPtr = NULL;
+      return ERROR;
+   }
+   outPtr->size = size;
+   return OK;
+} // openOut()
+
+/* write the chunk to file and empty it */
+void flushOut(outTy* outPtr) {
+   if (outPtr->fill==0) return;
+   if (!outPtr->err && fwrite(outPtr->bufPtr, 1, outPtr->fill, outPtr->filePtr)!=outPtr->fill) outPtr->err = 1;
+   outPtr->done += outPtr->fill;
+   outPtr->fill = 0;
+} // flushOut()
+
+/* append len bytes, flushed first when the chunk is full */
+void outMem(outTy* outPtr, const char* memPtr, size_t len) {
+   if (outPtr->fill+len>outPtr->size) flushOut(outPtr);
+   if (len>outPtr->size) { /* bigger than a chunk: straight to file */
+      if (!outPtr->err && fwrite(memPtr, 1, len, outPtr->filePtr)!=len) outPtr->err = 1;
+      outPtr->done += len;
+      return;
+   }
+   memcpy(outPtr->bufPtr+outPtr->fill, memPtr, len);
+   outPtr->fill += len;
+} // outMem()
+
+void outStr(outTy* outPtr, const char* strPtr) {
+   outMem(outPtr, strPtr, strlen(strPtr));
+} // outStr()
+
+/* printf in the chunk, the chunk grows for a longer text */
+void outFmt(outTy* outPtr, const char* fmtPtr, ...) {
+   va_list args;
+   for (int pass=0; pass<3; pass++) {
+      va_start(args, fmtPtr);
+      int len = vsnprintf(outPtr->bufPtr+outPtr->fill, outPtr->size-outPtr->fill, fmtPtr, args);
+      va_end(args);
+      if (len<0) {
+         outPtr->err = 1;
+         return;
+      }
+      if ((size_t)len<outPtr->size-outPtr->fill) {
+         outPtr->fill += len;
+         return;
+      }
+      flushOut(outPtr);
+      if ((size_t)len>=outPtr->size) { /* longer than a chunk */
+         char* bufPtr = realloc(outPtr->bufPtr, len+1);
+         if (bufPtr==NULL) {
+            outPtr->err = 1;
+            return;
+         }
+         outPtr->bufPtr = bufPtr;
+         outPtr->size = len+1;
+      }
+   }
+} // outFmt()
+
+void outDbl(outTy* outPtr, double val) {
+   if (outPtr->fill+DblLen>outPtr->size) flushOut(outPtr);
+   outPtr->fill += dblStr(outPtr->bufPtr+outPtr->fill, val);
+} // outDbl()
+
+/* flush and close a file written in chunks, free its buffer. Return bytes or ERROR */
+off_t closeOut(outTy* outPtr) {
+   if (outPtr==NULL || outPtr->filePtr==NULL) return ERROR;
+   flushOut(outPtr);
+   if (fclose(outPtr->filePtr)!=0) outPtr->err = 1;
+   off_t done = outPtr->err ? ERROR : (off_t)outPtr->done;
+   free(outPtr->bufPtr);
+   memset(outPtr, 0, sizeof(outTy));
+   return done;
+} // closeOut()
+
+/* parse a vector of double "v0,v1,...}" starting after its '{'. Return OK or ERROR */
+/* the vector is allocated: remember to free its address after use */
+errOk parseVector(char* chPtr, double** vectorValPtr, u16* sizePtr) {
+   char* chPos;
+   if (chPtr==NULL || vectorValPtr==NULL || sizePtr==NULL) {
+      if (dbgLev>=PRINTERROR) printf("ERROR %s: parameter point to NULL\n", __FUNCTION__);
+      return ERROR;
+   }
+   chPos = strstr(chPtr, "}");
+   if (chPos==NULL) {
+      if (dbgLev>=PRINTERROR) printf("ERROR %s: vector syntax error, miss '}'\n", __FUNCTION__);
+      return ERROR;
+   }
+   u32 sizeChr = chPos-chPtr;
+   char* vectorChr = malloc(sizeChr+1);
+   strncpy(vectorChr, chPtr, sizeChr);
+   *(vectorChr+sizeChr)='\0';
+   //if (dbgLev>=PRINTDEBUG) printf("vector:'%s'\n", vectorChr);
+   chPtr = strchr(vectorChr, ',');
+   u16 size = 0; // count how many commas
+   for (; chPtr; chPtr++) {
+      size++;
+      //if (dbgLev>=PRINTDEBUG) printf("size:%u\n", size);
+      chPtr = strchr(chPtr, ',');
+      if (chPtr==NULL) break;
+      //if (dbgLev>=PRINTDEBUG) printNchar(chPtr, 10);
+   }
+   if (size==0) size=1; // one value, so no comma
+   if (dbgLev>=PRINTDEBUG) printf("size:%u\n", size);
+   double* vectorVal = malloc(size*sizeof(double)); //must be freed by caller
+   chPtr = vectorChr;
+   char val[LineLen];
+   u16 p;
+   for (p=0; p<size; p++) {
+      //if (dbgLev>=PRINTDEBUG) printf("p:%u\n", p);
+      chPos = strchr(chPtr, ',');
+      if (chPos==NULL)
+         strcpy(val, chPtr);
+      else {
+         sizeChr = chPos-chPtr;
+         strncpy(val, chPtr, sizeChr);
+         val[sizeChr]='\0';
+      }
+      //if (dbgLev>=PRINTDEBUG) printf("val:'%s'\n", val);
+      vectorVal[p] = strtod(val, &chPos);
+      if (vectorVal[p]==0 && chPos==val) {
+         if (dbgLev>=PRINTERROR) printf("ERROR %s: cannot find digits in val='%s'\n", __FUNCTION__, val);
+         free(vectorVal);
+         free(vectorChr);
+         return ERROR;
+      }
+      chPtr = chPtr+sizeChr+1;
+   }
+   free(vectorChr);
+   for (p=0; p<size; p++) {
+      if (dbgLev>=PRINTDEBUG) printf("vectorVal[%02u]:%g\n", p, vectorVal[p]);
+   }
+   *vectorValPtr = vectorVal;
+   *sizePtr = size;
+   return OK;
+} // parseVector()
+
 /* parse of configuration buffer for parameter value. Return value or ERROR */
 /* vectors parameter: remember to free its address after use */
 errOk parseConf(char* bufPtr, char* paramPtr, char paramValue[LineLen]) {
@@ -272,49 +776,9 @@ errOk parseConf(char* bufPtr, char* paramPtr, char paramValue[LineLen]) {
       chPtr++;
       if (*(chPtr)=='{') chPtr++;
       //if (dbgLev>=PRINTDEBUG) printNchar(chPtr, 7);
-      chPos = strstr(chPtr, "}");
-      u32 sizeChr = chPos-chPtr;
-      char* vectorChr = malloc(sizeChr+1);
-      strncpy(vectorChr, chPtr, sizeChr);
-      *(vectorChr+sizeChr)='\0';
-      //if (dbgLev>=PRINTDEBUG) printf("vector:'%s'\n", vectorChr);
-      chPtr = strchr(vectorChr, ',');
-      u16 size = 0; // count how many commas
-      for (; chPtr; chPtr++) {
-         size++;
-         //if (dbgLev>=PRINTDEBUG) printf("size:%u\n", size);
-         chPtr = strchr(chPtr, ',');
-         if (chPtr==NULL) break;
-         //if (dbgLev>=PRINTDEBUG) printNchar(chPtr, 10);
-      }
-      if (size==0) size=1; // one value, so no comma
-      if (dbgLev>=PRINTDEBUG) printf("size:%u\n", size);
-      double* vectorVal = malloc(size*sizeof(double)); //must be freed by caller
-      chPtr = vectorChr;
-      char val[LineLen];
-      u16 p;
-      for (p=0; p<size; p++) {
-         //if (dbgLev>=PRINTDEBUG) printf("p:%u\n", p);
-         chPos = strchr(chPtr, ',');
-         if (chPos==NULL)
-            strcpy(val, chPtr);
-         else {
-            sizeChr = chPos-chPtr;
-            strncpy(val, chPtr, sizeChr);
-            val[sizeChr]='\0';
-         }
-         //if (dbgLev>=PRINTDEBUG) printf("val:'%s'\n", val);
-         vectorVal[p] = strtod(val, &chPos);
-         if (vectorVal[p]==0 && chPos==val) {
-            if (dbgLev>=PRINTERROR) printf("ERROR %s: cannot find digits in val='%s'\n", __FUNCTION__, val);
-            return ERROR;
-         }
-         chPtr = chPtr+sizeChr+1;
-      }
-      free(vectorChr);
-      for (p=0; p<size; p++) {
-         if (dbgLev>=PRINTDEBUG) printf("vectorVal[%02u]:%g\n", p, vectorVal[p]);
-      }
+      double* vectorVal;
+      u16 size, p;
+      if (parseVector(chPtr, &vectorVal, &size)!=OK) return ERROR;
       //if (dbgLev>=PRINTF) printf("vectorVal :@'0x%16zx'\n", (size_t)vectorVal);
       if (dbgLev>=PRINTDEBUG) printf("vectorVal :@'%16p'\n", vectorVal);
       // now return the vector of double as it's address and size:
@@ -28,6 +28,50 @@
 #include "comType.h"
 
 #define LineLen 160
+#define ChunkLen (1<<20) // bytes of a file read at once
+#define OutLen   (1<<16) // bytes of a file written at once
+#define DblLen   32      // chars of a double by dblStr(), NUL included
+
+typedef struct chunkTy { // file read one chunk at a time, any file size
+    FILE* filePtr;
+    off_t len;    // file size
+    off_t done;   // bytes read from file
+    char* bufPtr; // [size+1] chunk, NUL terminated
+    size_t size;  // bytes allocated for the chunk
+    size_t fill;  // bytes valid in bufPtr
+    size_t pos;   // first byte not used yet by the caller
+    int eof;      // no more bytes to read from file
+} chunkTy;
+
+typedef struct outTy { // file written one chunk at a time, any file size
+    FILE* filePtr;
+    char* bufPtr; // [size] chunk
+    size_t size;  // bytes allocated for the chunk
+    size_t fill;  // bytes valid in bufPtr
+    size_t done;  // bytes written to file
+    int err;      // a write failed, the file is not good
+} outTy;
+
+typedef struct iniKeyTy { // "key=value" of an INI file, both in its buffer
+    char* key;
+    char* val;  // without quotes and comment
+} iniKeyTy;
+
+typedef struct iniSectTy { // "[name]" of an INI file and its keys
+    char* name; // lowercase
+    int first;  // first key in iniTy.key
+    int keys;
+} iniSectTy;
+
+typedef struct iniTy { // INI file split in place: keys and values are not copied
+    char* bufPtr;     // file content, tokens NUL terminated, NULL when none
+    int sects;
+    int sectMax;
+    iniSectTy* sect;  // [sectMax] in file order
+    int keys;
+    int keyMax;
+    iniKeyTy* key;    // [keyMax] in file order, grouped by section
+} iniTy;
 
 extern u08 dbgLev;                                     /* Interaction level */
 
@@ -41,15 +85,64 @@ FILE* openWrite(char* fileName);
 /* open a file in ReadOnly and return the filePtr, file size or ERROR */
 off_t getFileSize(char* fileName, FILE** filePtrPtr);
 
-/* support 64 bit systems, but not file size greather than 4 GB, require C99 */
+/* support 64 bit systems and any file size that fit in RAM, require C99 */
 /* open and copy a file in RAM and return allocated bufferPtr, buffer size or ERROR */
 /* Then the file is closed. The user must free the bufferPtr at end of use */
 off_t readFile(char* fileName, char** bufferPtrPtr);
 
+/* open a file to read it in chunks of size bytes. Return OK or ERROR */
+errOk openChunk(char* fileName, chunkTy* chunkPtr, size_t size);
+
+/* move the bytes not used yet at chunk start and fill it from file */
+/* return bytes available from pos, 0 at end of file */
+size_t readChunk(chunkTy* chunkPtr);
+
+/* close a file read in chunks and free its buffer */
+void closeChunk(chunkTy* chunkPtr);
+
+/* read an INI file in RAM and split it in sections and keys, in one pass */
+/* arrays of the previous file are reused. Return OK or ERROR */
+errOk iniRead(char* fileName, iniTy* iniPtr);
+
+/* value of key in section sect, last one when repeated, NULL when none */
+char* iniGet(const iniTy* iniPtr, int sect, const char* keyPtr);
+
+/* free an INI file read by iniRead() */
+void iniFree(iniTy* iniPtr);
+
 /* support 64 bit systems, but not file size greather than 4 GB, require C99 */
 /* copy RAM on created file and return written bytes or ERROR */
 size_t writeFile(char* fileName, char* bufferPtr);
 
+/* shortest decimal of a double that strtod() read back to the same double */
+/* write it NUL terminated in strPtr[DblLen] and return its length */
+int dblStr(char* strPtr, double val);
+
+/* open a file to write it in chunks of size bytes. Return OK or ERROR */
+errOk openOut(char* fileName, outTy* outPtr, size_t size);
+
+/* write the chunk to file and empty it */
+void flushOut(outTy* outPtr);
+
+/* append len bytes to a file written in chunks */
+void outMem(outTy* outPtr, const char* memPtr, size_t len);
+
+/* append a string to a file written in chunks */
+void outStr(outTy* outPtr, const char* strPtr);
+
+/* append a printf text to a file written in chunks, of any length */
+void outFmt(outTy* outPtr, const char* fmtPtr, ...);
+
+/* append a double by dblStr() to a file written in chunks */
+void outDbl(outTy* outPtr, double val);
+
+/* flush and close a file written in chunks, free its buffer. Return bytes or ERROR */
+off_t closeOut(outTy* outPtr);
+
+/* parse a vector of double "v0,v1,...}" starting after its '{'. Return OK or ERROR */
+/* the vector is allocated: remember to free its address after use */
+errOk parseVector(char* chPtr, double** vectorValPtr, u16* sizePtr);
+
 /* parse of configuration buffer for parameter value. Return value or ERROR */
 /* vectors parameter: remember to free its address after use */
 errOk parseConf(char* bufPtr, char* paramPtr, char paramValue[LineLen]);
@@ -160,7 +160,7 @@ node_editor_add(struct node_editor *editor, const char *name, struct nk_rect bou
     editor->node_count++;
     //printf("&node_buf[%d]:%p\n", editor->node_count-1, node);
     node->ID = IDs;
-    strcpy(node->name, name);
+    snprintf(node->name, sizeof(node->name), "%s", name); // names may be longer
     //sprintf(node->name, "%d", node->ID);
     node->bounds = bounds;
     node->color = nk_rgb(255, 0, 0);
@@ -378,7 +378,7 @@ void nodeDelAll(struct node_editor* editorPtr) {
    nodePtr=editorPtr->end;
    while (nodePtr!=NULL) {
       nTy* nPtr=nodePtr->valuesPtr;
-      nListDel(&nList, nPtr);
+      nListDel(&pbCtxDef.nList, nPtr);
       struct node* prevPtr=nodePtr->prev;
       node_editor_delnode(editorPtr, nodePtr);
       nodePtr=prevPtr;
@@ -401,17 +401,17 @@ void node_editor_in(struct node_editor* graphPtr) {
     strcpy(name, "BOARD");
     id=node_editor_add(graphPtr, name, nk_rect(OFFSET                       , OFFSET                        , NODE_WIDTH, NODE_HEIGHT), nk_rgb(255,   0,  0), 0, 0);
     printf("name:'%s' id:%d\n", name, id);
-    nPtr=nListAdd(&nList); // add an empty node to the double linked list as last element, return its pointer
+    nPtr=nListAdd(&pbCtxDef.nList); // add an empty node to the pool as last element, return its pointer
     initNodeData(nPtr); // zero the node
-    strcpy(nPtr->name, name); nPtr->type=-1; strcpy(nPtr->label, name);
+    nListName(&pbCtxDef.nList, nPtr, name); nPtr->type=-1; snprintf(nPtr->label, sizeof(nPtr->label), "%s", name);
     fillNodeData(id, nPtr);
     printf("nPtr:%p name:'%s' type:%d\n", nPtr, nPtr->name, nPtr->type);
     strcpy(name, "IN");
     id=node_editor_add(graphPtr, name, nk_rect(OFFSET                       , OFFSET                        , NODE_WIDTH, NODE_HEIGHT), nk_rgb(255,   0,  0), 0, 1);
     printf("name:'%s' id:%d\n", name, id);
-    nPtr=nListAdd(&nList); // add an empty node to the double linked list as last element, return its pointer
+    nPtr=nListAdd(&pbCtxDef.nList); // add an empty node to the pool as last element, return its pointer
     initNodeData(nPtr); // zero the node
-    strcpy(nPtr->name, name); nPtr->type=0; strcpy(nPtr->label, name); nPtr->Vo=5;
+    nListName(&pbCtxDef.nList, nPtr, name); nPtr->type=0; snprintf(nPtr->label, sizeof(nPtr->label), "%s", name); *nPtr->Vo=5;
     fillNodeData(id, nPtr);
     printf("nPtr:%p name:'%s' type:%d\n", nPtr, nPtr->name, nPtr->type);
     showStructData();
@@ -430,7 +430,7 @@ node_editor_init(struct node_editor *editor)
     editor->show_grid = nk_true;
     editor->initialized = 1;
 
-    nListInit(&nList); // init the double linked node list
+    nListInit(&pbCtxDef.nList); // init the node pool
 }
 
 #if 0
@@ -443,38 +443,39 @@ void node_editor_demo(struct node_editor *editor) {
     // other nodes as demo show
     strcpy(name, "SR1"); //nodes++;
     id=node_editor_add(editor, name, nk_rect(OFFSET+2*(NODE_WIDTH+SPACING), OFFSET                        , NODE_WIDTH, NODE_HEIGHT), nk_rgb(  0, 255,  0), 1, 1);
-    nPtr=nListAdd(&nList); // add an empty node to the double linked list as last element, return its pointer
+    nPtr=nListAdd(&pbCtxDef.nList); // add an empty node to the pool as last element, return its pointer
     initNodeData(nPtr);
-    strcpy(nPtr->name, name); nPtr->type=1; strcpy(nPtr->label,"Buck"); strcpy(nPtr->refdes,"U14");
-    strcpy(nPtr->in[0],"IN"); nPtr->yeld=0.9; nPtr->Vo=1.8;
+    nListName(&pbCtxDef.nList, nPtr, name); nPtr->type=1; snprintf(nPtr->label, sizeof(nPtr->label), "%s", "Buck"); snprintf(nPtr->refdes, sizeof(nPtr->refdes), "%s", "U14");
+    nPtr->in[0]=nListIntern(&pbCtxDef.nList, "IN"); *nPtr->yeld=0.9; *nPtr->Vo=1.8;
     fillNodeData(id, nPtr);
     strcpy(name, "LR1"); //nodes++;
     id=node_editor_add(editor, name, nk_rect(OFFSET+1*(NODE_WIDTH+SPACING), OFFSET+1*(NODE_HEIGHT+SPACING), NODE_WIDTH, NODE_HEIGHT), nk_rgb(  0,   0,255), 1, 1);
-    nPtr=nListAdd(&nList); // add an empty node to the double linked list as last element, return its pointer
+    nPtr=nListAdd(&pbCtxDef.nList); // add an empty node to the pool as last element, return its pointer
     initNodeData(nPtr);
-    strcpy(nPtr->name, name); nPtr->type=2; strcpy(nPtr->label,"LDO1"); strcpy(nPtr->refdes,"U12");
-    strcpy(nPtr->in[0],"IN"); nPtr->Iadj=0.005; nPtr->Vo=3.6;
+    nListName(&pbCtxDef.nList, nPtr, name); nPtr->type=2; snprintf(nPtr->label, sizeof(nPtr->label), "%s", "LDO1"); snprintf(nPtr->refdes, sizeof(nPtr->refdes), "%s", "U12");
+    nPtr->in[0]=nListIntern(&pbCtxDef.nList, "IN"); *nPtr->Iadj=0.005; *nPtr->Vo=3.6;
     fillNodeData(id, nPtr);
     strcpy(name, "LR2"); //nodes++;
     id=node_editor_add(editor, name, nk_rect(OFFSET+2*(NODE_WIDTH+SPACING), OFFSET+1*(NODE_HEIGHT+SPACING), NODE_WIDTH, NODE_HEIGHT), nk_rgb(  0,   0,255), 1, 1);
-    nPtr=nListAdd(&nList); // add an empty node to the double linked list as last element, return its pointer
+    nPtr=nListAdd(&pbCtxDef.nList); // add an empty node to the pool as last element, return its pointer
     initNodeData(nPtr);
-    strcpy(nPtr->name, name); nPtr->type=2; strcpy(nPtr->label,"LDO2"); strcpy(nPtr->refdes,"U13");
-    strcpy(nPtr->in[0],"LR1"); nPtr->Iadj=0.005; nPtr->Vo=3.3L;
+    nListName(&pbCtxDef.nList, nPtr, name); nPtr->type=2; snprintf(nPtr->label, sizeof(nPtr->label), "%s", "LDO2"); snprintf(nPtr->refdes, sizeof(nPtr->refdes), "%s", "U13");
+    nPtr->in[0]=nListIntern(&pbCtxDef.nList, "LR1"); *nPtr->Iadj=0.005; *nPtr->Vo=3.3L;
     fillNodeData(id, nPtr);
     strcpy(name, "LD1"); //nodes++;
     id=node_editor_add(editor, name, nk_rect(OFFSET+3*(NODE_WIDTH+SPACING), OFFSET                        , NODE_WIDTH, NODE_HEIGHT), nk_rgb(255, 255,  0), 3, 0);
-    nPtr=nListAdd(&nList); // add an empty node to the double linked list as last element, return its pointer
+    nPtr=nListAdd(&pbCtxDef.nList); // add an empty node to the pool as last element, return its pointer
+    nListInputs(&pbCtxDef.nList, nPtr, 3); // 3 GUI input slots
     initNodeData(nPtr);
-    strcpy(nPtr->name, name); nPtr->type=3; strcpy(nPtr->label,"SpW"); strcpy(nPtr->refdes,"U20");
-    strcpy(nPtr->in[0],"SR1"); nPtr->Ii[0]=0.528; strcpy(nPtr->in[1],"SR1"); nPtr->Ii[1]=0.008; strcpy(nPtr->in[2],"LR2"); nPtr->Ii[2]=0.317;
+    nListName(&pbCtxDef.nList, nPtr, name); nPtr->type=3; snprintf(nPtr->label, sizeof(nPtr->label), "%s", "SpW"); snprintf(nPtr->refdes, sizeof(nPtr->refdes), "%s", "U20");
+    nPtr->in[0]=nListIntern(&pbCtxDef.nList, "SR1"); nPtr->Ii[0]=0.528; nPtr->in[1]=nListIntern(&pbCtxDef.nList, "SR1"); nPtr->Ii[1]=0.008; nPtr->in[2]=nListIntern(&pbCtxDef.nList, "LR2"); nPtr->Ii[2]=0.317;
     fillNodeData(id, nPtr);
     strcpy(name, "LD2"); //nodes++;
     id=node_editor_add(editor, name, nk_rect(OFFSET+3*(NODE_WIDTH+SPACING), OFFSET+1*(NODE_HEIGHT+SPACING), NODE_WIDTH, NODE_HEIGHT), nk_rgb(255, 255,  0), 1, 0);
-    nPtr=nListAdd(&nList); // add an empty node to the double linked list as last element, return its pointer
+    nPtr=nListAdd(&pbCtxDef.nList); // add an empty node to the pool as last element, return its pointer
     initNodeData(nPtr);
-    strcpy(nPtr->name, name); nPtr->type=3; strcpy(nPtr->label,"LVDS"); strcpy(nPtr->refdes,"U6");
-    strcpy(nPtr->in[0],"LR2"); nPtr->Ii[0]=0.0354;
+    nListName(&pbCtxDef.nList, nPtr, name); nPtr->type=3; snprintf(nPtr->label, sizeof(nPtr->label), "%s", "LVDS"); snprintf(nPtr->refdes, sizeof(nPtr->refdes), "%s", "U6");
+    nPtr->in[0]=nListIntern(&pbCtxDef.nList, "LR2"); nPtr->Ii[0]=0.0354;
     fillNodeData(id, nPtr);
     node_editor_link(editor, 0, 0, 1, 0);
     node_editor_link(editor, 0, 0, 2, 0);
@@ -591,10 +592,11 @@ node_editor(struct nk_context *ctx)
                     snprintf(Io, 6, "%g", it->values.Io);
                     snprintf(Po, 6, "%g", it->values.Po);
 #endif
-                    static int LDin=1;
                     nTy* nd=it->valuesPtr; // so can use nd-> istead of it->valuesPtr.
+                    int LDin=nd->ins;
 #define STEP 0.1
 #define SPP  0.1
+#define LDMAXIN 16 // LD inputs offered by the property
 
 #if defined NODE_WIDTH && NODE_WIDTH == 256
 #define EFW 50
@@ -604,13 +606,14 @@ node_editor(struct nk_context *ctx)
                     if (!strncasecmp(it->name, "LD", 2)) { // Loads
                        const float size0[] = {35, 80, 45};
                        nk_layout_row(ctx, NK_STATIC, 20, 3, size0);
-                       nk_edit_string_zero_terminated(ctx, NK_EDIT_FIELD, refdes, 7, 0); nk_label(ctx, "Inputs:", NK_TEXT_RIGHT); nk_property_int(ctx, "###n", 1, &LDin, MaxIns, 1, 1);
+                       nk_edit_string_zero_terminated(ctx, NK_EDIT_FIELD, refdes, 7, 0); nk_label(ctx, "Inputs:", NK_TEXT_RIGHT); nk_property_int(ctx, "###n", 1, &LDin, LDMAXIN, 1, 1);
+                       if (LDin!=nd->ins) nListInputs(&pbCtxDef.nList, nd, LDin);
 //                       const float size[] = {50, 15, 30, 50, 15, 50, 10};
                        const float size[] = {EFW, 15, 30, EFW, 15, EFW, 10};
                        nk_layout_row(ctx, NK_STATIC, 20, 7, size);
                        nk_property_double(ctx, "###n", 0, &nd->Vi[0], DBL_MAX, STEP, SPP); nk_label(ctx, "V", NK_TEXT_LEFT); nk_label(ctx, "", NK_TEXT_RIGHT);      nk_label(ctx, "", NK_TEXT_RIGHT);                                nk_label(ctx, "", NK_TEXT_RIGHT); nk_property_double(ctx, "###n", 0, &nd->R[0], DBL_MAX, STEP, SPP);  nk_label(ctx, u8"ΩOhm", NK_TEXT_LEFT); /* Ω */
                        nk_layout_row(ctx, NK_STATIC, 20, 7, size);
-                       nk_property_double(ctx, "###n", 0, &nd->Ii[0], DBL_MAX, STEP, SPP); nk_label(ctx, "A", NK_TEXT_LEFT); nk_label(ctx, "Pdis:", NK_TEXT_RIGHT); nk_property_double(ctx, "###n", 0, &nd->Pd, DBL_MAX, STEP, SPP); nk_label(ctx, "W", NK_TEXT_LEFT); nk_property_double(ctx, "###n", 0, &nd->Pi[0], DBL_MAX, STEP, SPP); nk_label(ctx, "W", NK_TEXT_LEFT);
+                       nk_property_double(ctx, "###n", 0, &nd->Ii[0], DBL_MAX, STEP, SPP); nk_label(ctx, "A", NK_TEXT_LEFT); nk_label(ctx, "Pdis:", NK_TEXT_RIGHT); nk_property_double(ctx, "###n", 0, nd->Pd, DBL_MAX, STEP, SPP); nk_label(ctx, "W", NK_TEXT_LEFT); nk_property_double(ctx, "###n", 0, &nd->Pi[0], DBL_MAX, STEP, SPP); nk_label(ctx, "W", NK_TEXT_LEFT);
                     } else if (!strncasecmp(it->name, "IN", 2)) { // IN
                        const float size0[] = {35};
                        nk_layout_row(ctx, NK_STATIC, 20, 1, size0);
@@ -618,11 +621,11 @@ node_editor(struct nk_context *ctx)
 //                       const float size[] = {50, 15, 30, 50, 15, 50, 10};
                        const float size[] = {EFW, 15, 30, EFW, 15, EFW, 10};
                        nk_layout_row(ctx, NK_STATIC, 20, 7, size);
-                       nk_label(ctx, "", NK_TEXT_RIGHT); nk_label(ctx, "", NK_TEXT_RIGHT); nk_label(ctx, "", NK_TEXT_RIGHT);      nk_label(ctx, "", NK_TEXT_RIGHT);                                nk_label(ctx, "", NK_TEXT_RIGHT); nk_property_double(ctx, "###n", 0, &nd->Vo, DBL_MAX, STEP, SPP); nk_label(ctx, "V", NK_TEXT_LEFT);
+                       nk_label(ctx, "", NK_TEXT_RIGHT); nk_label(ctx, "", NK_TEXT_RIGHT); nk_label(ctx, "", NK_TEXT_RIGHT);      nk_label(ctx, "", NK_TEXT_RIGHT);                                nk_label(ctx, "", NK_TEXT_RIGHT); nk_property_double(ctx, "###n", 0, nd->Vo, DBL_MAX, STEP, SPP); nk_label(ctx, "V", NK_TEXT_LEFT);
                        nk_layout_row(ctx, NK_STATIC, 20, 7, size);
-                       nk_label(ctx, "", NK_TEXT_RIGHT); nk_label(ctx, "", NK_TEXT_RIGHT); nk_label(ctx, "", NK_TEXT_RIGHT);      nk_label(ctx, "", NK_TEXT_RIGHT);                                nk_label(ctx, "", NK_TEXT_RIGHT); nk_property_double(ctx, "###n", 0, &nd->Io, DBL_MAX, STEP, SPP); nk_label(ctx, "A", NK_TEXT_LEFT);
+                       nk_label(ctx, "", NK_TEXT_RIGHT); nk_label(ctx, "", NK_TEXT_RIGHT); nk_label(ctx, "", NK_TEXT_RIGHT);      nk_label(ctx, "", NK_TEXT_RIGHT);                                nk_label(ctx, "", NK_TEXT_RIGHT); nk_property_double(ctx, "###n", 0, nd->Io, DBL_MAX, STEP, SPP); nk_label(ctx, "A", NK_TEXT_LEFT);
                        nk_layout_row(ctx, NK_STATIC, 20, 7, size);
-                       nk_label(ctx, "", NK_TEXT_RIGHT); nk_label(ctx, "", NK_TEXT_RIGHT); nk_label(ctx, "Pdis:", NK_TEXT_RIGHT); nk_property_double(ctx, "###n", 0, &nd->Pd, DBL_MAX, STEP, SPP); nk_label(ctx, "W", NK_TEXT_LEFT); nk_property_double(ctx, "###n", 0, &nd->Po, DBL_MAX, STEP, SPP); nk_label(ctx, "W", NK_TEXT_LEFT);
+                       nk_label(ctx, "", NK_TEXT_RIGHT); nk_label(ctx, "", NK_TEXT_RIGHT); nk_label(ctx, "Pdis:", NK_TEXT_RIGHT); nk_property_double(ctx, "###n", 0, nd->Pd, DBL_MAX, STEP, SPP); nk_label(ctx, "W", NK_TEXT_LEFT); nk_property_double(ctx, "###n", 0, nd->Po, DBL_MAX, STEP, SPP); nk_label(ctx, "W", NK_TEXT_LEFT);
                     } else if (!strncasecmp(it->name, "BOARD", 5)) { // BOARD
                        // do not draw anything for BOARD
                     } else { // VoltReg
@@ -630,24 +633,24 @@ node_editor(struct nk_context *ctx)
                        nk_layout_row(ctx, NK_STATIC, 20, 4, size0);
                        if (!strncasecmp(it->name, "LR", 2)) { // Linear
                           voltReg_radio=LR;
-                          strcpy(it->valuesPtr->name, "LRx"); it->valuesPtr->type=2; strcpy(it->valuesPtr->label, "LRx");
+                          nListName(&pbCtxDef.nList, it->valuesPtr, "LRx"); it->valuesPtr->type=2; snprintf(it->valuesPtr->label, sizeof(it->valuesPtr->label), "%s", "LRx");
                        } else { // Switching
                           voltReg_radio=SR;
-                          strcpy(it->valuesPtr->name, "SRx"); it->valuesPtr->type=1; strcpy(it->valuesPtr->label, "SRx");
+                          nListName(&pbCtxDef.nList, it->valuesPtr, "SRx"); it->valuesPtr->type=1; snprintf(it->valuesPtr->label, sizeof(it->valuesPtr->label), "%s", "SRx");
                        }
                        nk_edit_string_zero_terminated(ctx, NK_EDIT_FIELD, refdes, 7, 0); nk_label(ctx, "VoltReg:", NK_TEXT_LEFT); if (nk_option_label(ctx, "Linear", voltReg_radio == LR)) voltReg_radio=LR; if (nk_option_label(ctx, "Switching", voltReg_radio == SR)) voltReg_radio=SR;
 //                       const float size[] = {50, 15, 30, 50, 15, 50, 10};
                        const float size[] = {EFW, 15, 30, EFW, 15, EFW, 10};
                        nk_layout_row(ctx, NK_STATIC, 20, 7, size);
-                       nk_property_double(ctx, "###n", 0, &nd->Vi[0], DBL_MAX, STEP, SPP); nk_label(ctx, "V", NK_TEXT_LEFT); nk_label(ctx, u8"ΔDV:", NK_TEXT_RIGHT);  nk_property_double(ctx, "###n", 0, &nd->DV, DBL_MAX, STEP, SPP);   nk_label(ctx, "V", NK_TEXT_LEFT); nk_property_double(ctx, "###n", 0, &nd->Vo, DBL_MAX, STEP, SPP); nk_label(ctx, "V", NK_TEXT_LEFT);
+                       nk_property_double(ctx, "###n", 0, &nd->Vi[0], DBL_MAX, STEP, SPP); nk_label(ctx, "V", NK_TEXT_LEFT); nk_label(ctx, u8"ΔDV:", NK_TEXT_RIGHT);  nk_property_double(ctx, "###n", 0, nd->DV, DBL_MAX, STEP, SPP);   nk_label(ctx, "V", NK_TEXT_LEFT); nk_property_double(ctx, "###n", 0, nd->Vo, DBL_MAX, STEP, SPP); nk_label(ctx, "V", NK_TEXT_LEFT);
                        nk_layout_row(ctx, NK_STATIC, 20, 7, size);
                        if (!strncasecmp(it->name, "LR", 2)) { // Linear
-                       nk_property_double(ctx, "###n", 0, &nd->Ii[0], DBL_MAX, STEP, SPP); nk_label(ctx, "A", NK_TEXT_LEFT); nk_label(ctx, "Iadj:", NK_TEXT_RIGHT); nk_property_double(ctx, "###n", 0, &nd->Iadj, DBL_MAX, STEP, SPP); nk_label(ctx, "A", NK_TEXT_LEFT); nk_property_double(ctx, "###n", 0, &nd->Io, DBL_MAX, STEP, SPP); nk_label(ctx, "A", NK_TEXT_LEFT);
+                       nk_property_double(ctx, "###n", 0, &nd->Ii[0], DBL_MAX, STEP, SPP); nk_label(ctx, "A", NK_TEXT_LEFT); nk_label(ctx, "Iadj:", NK_TEXT_RIGHT); nk_property_double(ctx, "###n", 0, nd->Iadj, DBL_MAX, STEP, SPP); nk_label(ctx, "A", NK_TEXT_LEFT); nk_property_double(ctx, "###n", 0, nd->Io, DBL_MAX, STEP, SPP); nk_label(ctx, "A", NK_TEXT_LEFT);
                        } else { // Switching
-                       nk_property_double(ctx, "###n", 0, &nd->Ii[0], DBL_MAX, STEP, SPP); nk_label(ctx, "A", NK_TEXT_LEFT); nk_label(ctx, "Yeld:", NK_TEXT_RIGHT); nk_property_double(ctx, "###n", 0, &nd->yeld, DBL_MAX, STEP, SPP); nk_label(ctx, "", NK_TEXT_LEFT);  nk_property_double(ctx, "###n", 0, &nd->Io, DBL_MAX, STEP, SPP); nk_label(ctx, "A", NK_TEXT_LEFT);
+                       nk_property_double(ctx, "###n", 0, &nd->Ii[0], DBL_MAX, STEP, SPP); nk_label(ctx, "A", NK_TEXT_LEFT); nk_label(ctx, "Yeld:", NK_TEXT_RIGHT); nk_property_double(ctx, "###n", 0, nd->yeld, DBL_MAX, STEP, SPP); nk_label(ctx, "", NK_TEXT_LEFT);  nk_property_double(ctx, "###n", 0, nd->Io, DBL_MAX, STEP, SPP); nk_label(ctx, "A", NK_TEXT_LEFT);
                        }
                        nk_layout_row(ctx, NK_STATIC, 20, 7, size);
-                       nk_property_double(ctx, "###n", 0, &nd->Pi[0], DBL_MAX, STEP, SPP); nk_label(ctx, "W", NK_TEXT_LEFT); nk_label(ctx, "Pdis:", NK_TEXT_RIGHT); nk_property_double(ctx, "###n", 0, &nd->Pd, DBL_MAX, STEP, SPP);   nk_label(ctx, "W", NK_TEXT_LEFT); nk_property_double(ctx, "###n", 0, &nd->Po, DBL_MAX, STEP, SPP); nk_label(ctx, "W", NK_TEXT_LEFT);
+                       nk_property_double(ctx, "###n", 0, &nd->Pi[0], DBL_MAX, STEP, SPP); nk_label(ctx, "W", NK_TEXT_LEFT); nk_label(ctx, "Pdis:", NK_TEXT_RIGHT); nk_property_double(ctx, "###n", 0, nd->Pd, DBL_MAX, STEP, SPP);   nk_label(ctx, "W", NK_TEXT_LEFT); nk_property_double(ctx, "###n", 0, nd->Po, DBL_MAX, STEP, SPP); nk_label(ctx, "W", NK_TEXT_LEFT);
                        if (voltReg_radio == LR) strcpy(it->name, "LR");
                        if (voltReg_radio == SR) strcpy(it->name, "SR");
                     }
@@ -752,8 +755,8 @@ node_editor(struct nk_context *ctx)
                             printf("nodeEPtr:%p nPtr:%p name:'%s' type:%d\n", nodeEPtr, nodeEPtr->valuesPtr, nodeEPtr->valuesPtr->name, nodeEPtr->valuesPtr->type);
                             struct node* nodeSPtr=node_editor_find(nodedit, nodedit->linking.input_id);
                             printf("nodeSPtr:%p nPtr:%p name:'%s' type:%d\n", nodeSPtr, nodeSPtr->valuesPtr, nodeSPtr->valuesPtr->name, nodeSPtr->valuesPtr->type);
-                            nodeEPtr->valuesPtr->from[n]=nodeSPtr->valuesPtr;
-                            strcpy(nodeEPtr->valuesPtr->in[n], nodeSPtr->valuesPtr->name);
+                            nodeEPtr->valuesPtr->from[n]=nodeSPtr->valuesPtr->ix;
+                            nodeEPtr->valuesPtr->in[n]=nodeSPtr->valuesPtr->name;
                             //showStructData();
                         }
 
@@ -834,7 +837,7 @@ node_editor(struct nk_context *ctx)
             }
 
             /* contextual menu */
-            nTy* nPtr=nList.first;
+            nTy* nPtr=nListFirst(&pbCtxDef.nList);
             if (nk_contextual_begin(ctx, 0, nk_vec2(100, 265), nk_window_get_bounds(ctx))) {
                 const char *grid_option[] = {"Show Grid", "Hide Grid"};
                 nk_layout_row_dynamic(ctx, 25, 1);
@@ -848,63 +851,63 @@ node_editor(struct nk_context *ctx)
                 if (nk_contextual_item_label(ctx, "Del Node", NK_TEXT_CENTERED)) {
                    if (nodeid>0) { // cannot remove node 0 IN
                       printf("delete node id:%d\n", nodeid);
-                      printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, nList.nodeCnt);
+                      printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, pbCtxDef.nList.nodeCnt);
                       //node_editor_del(nodedit, nodeid);
                       struct node* nodePtr=node_editor_find(nodedit, nodeid);
-                      nListDel(&nList, nodePtr->valuesPtr); // remove node values
+                      nListDel(&pbCtxDef.nList, nodePtr->valuesPtr); // remove node values
                       node_editor_delnode(nodedit, nodePtr); // remove GUI node
                       //nodes--;
-                      printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, nList.nodeCnt);
+                      printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, pbCtxDef.nList.nodeCnt);
                       printf("\n");
                       nodeclick=0;
                    }
                 }
                 if (nk_contextual_item_label(ctx, "New Reg", NK_TEXT_CENTERED)) {
-                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, nList.nodeCnt);
+                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, pbCtxDef.nList.nodeCnt);
                     //nodes++;
                     int idn=node_editor_add(nodedit, "Reg", nk_rect(500, 400, NODE_WIDTH, NODE_HEIGHT),
                             nk_rgb(255, 255, 255), 1, 1);
-                    nPtr=nListAdd(&nList); // add an empty node to the double linked list as last element, return its pointer
+                    nPtr=nListAdd(&pbCtxDef.nList); // add an empty node to the pool as last element, return its pointer
                     initNodeData(nPtr);
-                    nPtr->type=1; nPtr->yeld=0.9;
-                    strcpy(nPtr->name, "SRx"); nPtr->type=1; strcpy(nPtr->label, "SRx");
+                    nPtr->type=1; *nPtr->yeld=0.9;
+                    nListName(&pbCtxDef.nList, nPtr, "SRx"); nPtr->type=1; snprintf(nPtr->label, sizeof(nPtr->label), "%s", "SRx");
                     fillNodeData(idn, nPtr);
-                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, nList.nodeCnt);
+                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, pbCtxDef.nList.nodeCnt);
                 }
                 if (nk_contextual_item_label(ctx, "New Load", NK_TEXT_CENTERED)) {
-                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, nList.nodeCnt);
+                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, pbCtxDef.nList.nodeCnt);
                     //nodes++;
                     int idn=node_editor_add(nodedit, "LDx", nk_rect(500, 400, NODE_WIDTH, NODE_HEIGHT),
                             nk_rgb(255, 255, 255), 1, 0);
-                    nPtr=nListAdd(&nList); // add an empty node to the double linked list as last element, return its pointer
+                    nPtr=nListAdd(&pbCtxDef.nList); // add an empty node to the pool as last element, return its pointer
                     initNodeData(nPtr);
-                    strcpy(nPtr->name, "LDx"); nPtr->type=3; strcpy(nPtr->label, "LDx");
+                    nListName(&pbCtxDef.nList, nPtr, "LDx"); nPtr->type=3; snprintf(nPtr->label, sizeof(nPtr->label), "%s", "LDx");
                     fillNodeData(idn, nPtr);
                     printf("nPtr:%p name:'%s' type:%d\n", nPtr, nPtr->name, nPtr->type);
-                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, nList.nodeCnt);
+                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, pbCtxDef.nList.nodeCnt);
                     //showStructData();
                 }
                 if (nk_contextual_item_label(ctx, "Clear all", NK_TEXT_CENTERED)) {
                     printf("Clear all\n");
-                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, nList.nodeCnt);
+                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, pbCtxDef.nList.nodeCnt);
                     nodeDelAll(nodedit);
-                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, nList.nodeCnt);
+                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, pbCtxDef.nList.nodeCnt);
                     node_editor_init(nodedit);
-                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, nList.nodeCnt);
+                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, pbCtxDef.nList.nodeCnt);
                     node_editor_in(nodedit);
-                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, nList.nodeCnt);
+                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, pbCtxDef.nList.nodeCnt);
                     printf("Cleared\n");
                     //showStructData();
                 }
                 if (nk_contextual_item_label(ctx, "Load INI", NK_TEXT_CENTERED)) {
                     printf("load INI file\n");
-                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, nList.nodeCnt);
+                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, pbCtxDef.nList.nodeCnt);
                     guiLoadINI(nodedit, DefCliIniFile);
-                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, nList.nodeCnt);
+                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, pbCtxDef.nList.nodeCnt);
                 }
                 if (nk_contextual_item_label(ctx, "Save INI", NK_TEXT_CENTERED)) {
                     printf("save INI file\n");
-                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, nList.nodeCnt);
+                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, pbCtxDef.nList.nodeCnt);
                     saveINI(DefGuiIniResFile);
                 }
                 if (nk_contextual_item_label(ctx, "Calc Nodes", NK_TEXT_CENTERED)) {
@@ -918,8 +921,9 @@ node_editor(struct nk_context *ctx)
 #endif
                     printf("\n");
                     printf("calc nodes\n");
-                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, nList.nodeCnt);
+                    printf("nodedit->node_count:%d nList.nodeCnt:%d\n", nodedit->node_count, pbCtxDef.nList.nodeCnt);
                     clearNodes();
+                    compileNodes(); // links may be changed by the editor
                     int ret=calcNodes();
                     if (ret!=0) {
                        printf("calcNodes returned:%d, quit\n", ret);
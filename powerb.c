@@ -18,51 +18,274 @@
 
 #include <stdio.h>
 #include <strings.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include "powerbLib.h"
 #include "fileIo.h"
 
 u08 dbgLev=PRINTF;
 
+typedef struct argFilesTy { // INI files given by the command line
+    int cnt;
+    int max;
+    char** name;
+} argFilesTy;
+
+static void addFile(argFilesTy* filesPtr, const char* namePtr, size_t len) {
+   if (filesPtr->cnt==filesPtr->max) {
+      filesPtr->max=filesPtr->max ? 2*filesPtr->max : 16;
+      filesPtr->name=realloc(filesPtr->name, filesPtr->max*sizeof(char*));
+   }
+   char* copyPtr=malloc(len+1);
+   memcpy(copyPtr, namePtr, len);
+   copyPtr[len]='\0';
+   filesPtr->name[filesPtr->cnt++]=copyPtr;
+   return;
+} // void addFile(argFilesTy* filesPtr, const char* namePtr, size_t len)
+
+static int cmpName(const void* a, const void* b) {
+   return strcmp(*(char* const*)a, *(char* const*)b);
+} // int cmpName(const void* a, const void* b)
+
+// add the *.ini files of a directory by name, results *.res.ini excluded
+static int addDir(argFilesTy* filesPtr, const char* dirPtr) {
+   DIR* dir=opendir(dirPtr);
+   if (dir==NULL) return -1;
+   int first=filesPtr->cnt;
+   size_t dirLen=strlen(dirPtr);
+   for (struct dirent* entPtr=readdir(dir); entPtr; entPtr=readdir(dir)) {
+      size_t len=strlen(entPtr->d_name);
+      if (len<=4 || strcasecmp(entPtr->d_name+len-4, ".ini")) continue;
+      if (len>8 && !strcasecmp(entPtr->d_name+len-8, ".res.ini")) continue;
+      char* pathPtr=malloc(dirLen+len+2);
+      sprintf(pathPtr, "%s/%s", dirPtr, entPtr->d_name);
+      addFile(filesPtr, pathPtr, strlen(pathPtr));
+      free(pathPtr);
+   }
+   closedir(dir);
+   qsort(filesPtr->name+first, filesPtr->cnt-first, sizeof(char*), cmpName);
+   return 0;
+} // int addDir(argFilesTy* filesPtr, const char* dirPtr)
+
+// add the files listed on stdin, one by line, empty and '#' lines skipped
+static void addStdin(argFilesTy* filesPtr) {
+   char line[4096];
+   while (fgets(line, sizeof(line), stdin)) {
+      size_t len=strcspn(line, "\r\n");
+      if (len==0 || line[0]=='#') continue;
+      addFile(filesPtr, line, len);
+   }
+   return;
+} // void addStdin(argFilesTy* filesPtr)
+
+void usage(char* progName) {
+   printf("usage: %s [options] [file.ini ...|dir|-]\n", progName);
+   printf("  more files, a directory of *.ini or - for file names on stdin: solve all\n");
+   printf("  on threads, every result in its .res.ini and a summary of the boards\n");
+   printf("  --montecarlo N  Monte Carlo tolerance analysis on N samples\n");
+   printf("  --worstcase     worst case bounds of IN power and Pd by intervals\n");
+   printf("  --refine        with --worstcase, tighten loose bounds by splitting tolerances\n");
+   printf("  --profile       stream LD load profiles: energy, average and peak power\n");
+   printf("  --battery       discharge the IN battery over the profiles: runtime, dropouts\n");
+   printf("  --thermal       iterate calc with junction temperatures: Tj and margin\n");
+   printf("  --sensitivity   derivatives of IN P and regulator Pd by every parameter\n");
+   printf("  --linear        write the linear map of LD currents to IN and regulators\n");
+   printf("  --sweep FILE    with the linear map, min avg max over the load vectors of FILE\n");
+   printf("  --optimize G    search the design alternatives for min G: Pd or P of IN\n");
+   printf("  --serve SOCK    daemon on the Unix socket SOCK: keep designs loaded, solve on request\n");
+   printf("  --layout        place the nodes as the GUI and show the graph matrix\n");
+   printf("  --compile       write the design as binary .pbc, loaded then in place of the INI\n");
+   printf("  -o FILE         with --compile, the .pbc name, default the INI name with .pbc\n");
+   printf("  --seed S        first key of the random numbers, default 1\n");
+   printf("  --threads T     threads to use, default all cores\n");
+   printf("  -h, --help      show this help\n");
+} // void usage(char* progName)
+
 int main(int argNum, char* argV[]) {
    int ret;
-   //printf("argNum:%d\n", argNum);
-   if (argNum>0) argNum--;
-   //printf("argNum:%d\n", argNum);
-   if (argNum>1) {
-      printf("WARN: ignoring argNum >1\n");
-   }
-   //if (argNum>0) printf("INI file argV:'%s'\n", argV[1]);
-   // choose ini file
-   char* graphFile;
-   if (argNum>0) {
-      int len=strlen(argV[1]);
-      graphFile=malloc(len+1); // add NULL
-      graphFile[0]='\0';
-      strcpy(graphFile, argV[1]);
-   } else { // default fileName
-      char fileName[]=DefCliIniFile; // "powerb.ini"
-      int len=strlen(fileName);
-      //printf("len:%d\n", len);
-      graphFile=malloc(len+1); // add NULL
-      graphFile[0]='\0';
-      strcpy(graphFile, fileName);
+   long mcSamples=0; // Monte Carlo samples, 0 for a single calc
+   int wc=0, refine=0; // worst case analysis
+   int prof=0; // load profiles
+   int battery=0; // battery runtime
+   int thermal=0; // electro-thermal solve
+   int sens=0; // adjoint sensitivity
+   int linear=0; // linear load map
+   char* sweepFile=NULL; // load vectors for the linear map
+   int opt=-1; // optimizer goal, -1 for none
+   char* sockFile=NULL; // solver daemon socket
+   int compile=0; // write the compiled design
+   int layout=0; // show the graph matrix
+   char* outFile=NULL; // compiled design name
+   u64 seed=1;
+   int threads=0;
+   char* graphFile=NULL;
+   argFilesTy files={0, 0, NULL};
+   int many=0; // directory or stdin given
+   for (int a=1; a<argNum; a++) {
+      if (!strcmp(argV[a], "-h") || !strcmp(argV[a], "--help")) {
+         usage(argV[0]);
+         return 0;
+      }
+      if (!strcmp(argV[a], "--montecarlo") && a+1<argNum) {
+         mcSamples=atol(argV[++a]);
+         if (mcSamples<1) {
+            printf("Invalid Monte Carlo samples:'%s'. Quit\n", argV[a]);
+            return -1;
+         }
+         continue;
+      }
+      if (!strcmp(argV[a], "--worstcase")) {
+         wc=1;
+         continue;
+      }
+      if (!strcmp(argV[a], "--refine")) {
+         refine=1;
+         continue;
+      }
+      if (!strcmp(argV[a], "--profile")) {
+         prof=1;
+         continue;
+      }
+      if (!strcmp(argV[a], "--battery")) {
+         battery=1;
+         continue;
+      }
+      if (!strcmp(argV[a], "--thermal")) {
+         thermal=1;
+         continue;
+      }
+      if (!strcmp(argV[a], "--sensitivity")) {
+         sens=1;
+         continue;
+      }
+      if (!strcmp(argV[a], "--linear")) {
+         linear=1;
+         continue;
+      }
+      if (!strcmp(argV[a], "--sweep") && a+1<argNum) {
+         linear=1;
+         sweepFile=argV[++a];
+         continue;
+      }
+      if (!strcmp(argV[a], "--optimize") && a+1<argNum) {
+         a++;
+         if (!strcasecmp(argV[a], "Pd")) opt=OptGoalPd;
+         else if (!strcasecmp(argV[a], "P")) opt=OptGoalP;
+         else {
+            printf("Invalid optimize goal:'%s', Pd or P. Quit\n", argV[a]);
+            return -1;
+         }
+         continue;
+      }
+      if (!strcmp(argV[a], "--serve") && a+1<argNum) {
+         sockFile=argV[++a];
+         continue;
+      }
+      if (!strcmp(argV[a], "--layout")) {
+         layout=1;
+         continue;
+      }
+      if (!strcmp(argV[a], "--compile")) {
+         compile=1;
+         continue;
+      }
+      if (!strcmp(argV[a], "-o") && a+1<argNum) {
+         outFile=argV[++a];
+         continue;
+      }
+      if (!strcmp(argV[a], "--seed") && a+1<argNum) {
+         seed=strtoull(argV[++a], NULL, 0);
+         continue;
+      }
+      if (!strcmp(argV[a], "--threads") && a+1<argNum) {
+         threads=atoi(argV[++a]);
+         continue;
+      }
+      if (!strcmp(argV[a], "-")) {
+         addStdin(&files);
+         many=1;
+         continue;
+      }
+      if (argV[a][0]=='-') {
+         printf("WARN: ignoring unknown option:'%s'\n", argV[a]);
+         continue;
+      }
+      struct stat st;
+      if (stat(argV[a], &st)==0 && S_ISDIR(st.st_mode)) {
+         if (addDir(&files, argV[a])!=0) {
+            printf("Cannot read directory:'%s'. Quit\n", argV[a]);
+            return -1;
+         }
+         many=1;
+         continue;
+      }
+      addFile(&files, argV[a], strlen(argV[a]));
+   }
+   if (sockFile!=NULL) { // designs are loaded on request
+      for (int f=0; f<files.cnt; f++) free(files.name[f]);
+      free(files.name);
+      ret=serve(sockFile);
+      if (ret!=0) {
+         printf("serve returned not OK:%d\n", ret);
+      }
+      return ret;
+   }
+   if (compile && (many || files.cnt!=1)) {
+      printf("Compile need a single INI file. Quit\n");
+      return -1;
    }
+   if (many || files.cnt>1) { // batch of boards
+      if (mcSamples>0 || wc || prof || battery || thermal || sens || linear || opt>=0) {
+         printf("Analysis options need a single INI file. Quit\n");
+         return -1;
+      }
+      ret=solveFiles(files.name, files.cnt, threads);
+      for (int f=0; f<files.cnt; f++) free(files.name[f]);
+      free(files.name);
+      return ret;
+   }
+   // choose ini file, the list is not needed after
+   char fileName[(files.cnt==1) ? strlen(files.name[0])+1 : 1];
+   if (files.cnt==1) graphFile=strcpy(fileName, files.name[0]);
+   for (int f=0; f<files.cnt; f++) free(files.name[f]);
+   free(files.name);
+   if (graphFile==NULL) graphFile=DefCliIniFile; // "powerb.ini"
    //printf("INI file:'%s'\n", graphFile);
 
    ret=loadINI(graphFile);
    if (ret!=0) {
       printf("loadINI returned not OK:%d\n", ret);
       ret=freeMem();
-      free(graphFile);
       return -1;
    }
 
+   if (layout) layoutNodes(); // only the GUI need node places
+
+   if (compile) { // the design as loaded, before any calc
+      size_t len=strlen(graphFile);
+      if (len>4 && !strcasecmp(graphFile+len-4, ".pbc")) {
+         printf("Compile need an INI file, not:'%s'. Quit\n", graphFile);
+         ret=freeMem();
+         return -1;
+      }
+      char pbcFile[len+5];
+      if (outFile==NULL) {
+         if (len>4 && !strcasecmp(graphFile+len-4, ".ini")) len-=4;
+         memcpy(pbcFile, graphFile, len);
+         strcpy(pbcFile+len, ".pbc");
+         outFile=pbcFile;
+      }
+      ret=pbSavePBC(&pbCtxDef, graphFile, outFile);
+      if (ret!=0) printf("pbSavePBC returned not OK:%d\n", ret);
+      freeMem();
+      return ret;
+   }
+
    ret=calcNodes();
    if (ret!=0) {
       printf("calcNodes returned not OK:%d\n", ret);
       ret=freeMem();
-      free(graphFile);
       return -1;
    }
 
@@ -71,7 +294,78 @@ int main(int argNum, char* argV[]) {
    //printf("Tot Sect:%d Nodes:%d\n", sect, nt);
    saveINI(DefCliIniResFile);
 
+   if (mcSamples>0) {
+      ret=monteCarlo(&pbCtxDef, mcSamples, seed, threads);
+      if (ret!=0) {
+         printf("monteCarlo returned not OK:%d\n", ret);
+         ret=freeMem();
+         return -1;
+      }
+   }
+
+   if (wc) {
+      ret=worstCase(&pbCtxDef, refine, threads);
+      if (ret!=0) {
+         printf("worstCase returned not OK:%d\n", ret);
+         ret=freeMem();
+         return -1;
+      }
+   }
+
+   if (prof) {
+      ret=profileEnergy(&pbCtxDef, threads);
+      if (ret!=0) {
+         printf("profileEnergy returned not OK:%d\n", ret);
+         ret=freeMem();
+         return -1;
+      }
+   }
+
+   if (battery) {
+      ret=batteryRun(&pbCtxDef);
+      if (ret!=0) {
+         printf("batteryRun returned not OK:%d\n", ret);
+         ret=freeMem();
+         return -1;
+      }
+   }
+
+   if (thermal) {
+      ret=thermalSolve(&pbCtxDef);
+      if (ret!=0) {
+         printf("thermalSolve returned not OK:%d\n", ret);
+         ret=freeMem();
+         return -1;
+      }
+   }
+
+   if (sens) {
+      ret=sensitivity(&pbCtxDef);
+      if (ret!=0) {
+         printf("sensitivity returned not OK:%d\n", ret);
+         ret=freeMem();
+         return -1;
+      }
+   }
+
+   if (linear) {
+      ret=linearSweep(&pbCtxDef, sweepFile);
+      if (ret!=0) {
+         printf("linearSweep returned not OK:%d\n", ret);
+         ret=freeMem();
+         return -1;
+      }
+   }
+
+   if (opt>=0) {
+      ret=optimize(&pbCtxDef, opt, threads);
+      if (ret!=0) {
+         printf("optimize returned not OK:%d\n", ret);
+         ret=freeMem();
+         return -1;
+      }
+   }
+
    ret=freeMem();
-   free(graphFile);
    return 0;
 }
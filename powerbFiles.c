@@ -0,0 +1,159 @@
+/* PowerBudget v0.00.01a 2024/09/08 calculate power dissipation and budget */
+/* Copyright 2024 Valerio Messina http://users.iol.it/efa              */
+/* powerbFiles.c is part of PowerBudget
+   PowerBudget is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   PowerBudget is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with PowerBudget. If not, see <http://www.gnu.org/licenses/>. */
+
+/* powerbFiles.c LIB: solve many INI files on threads, summary of the boards */
+
+#include <stdio.h>
+#include <strings.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "powerbLib.h"
+#include "fileIo.h"
+
+#define FileOk    0 // solved and saved
+#define FileLoad  1 // loadINI failed
+#define FileCalc  2 // calcNodes failed
+#define FileSave  3 // res file not written
+
+typedef struct fileJobTy { // a board of the run
+    char* fileName;
+    char* resName;  // fileName with .res.ini
+    off_t size;     // bytes, bigger boards go first
+    int status;     // FileOk, FileLoad, FileCalc, FileSave
+    int nodes;
+    double V, I, P; // IN
+    double Pd;      // sum of regulator and RS dissipation
+} fileJobTy;
+
+typedef struct fileRunTy { // shared by all threads
+    fileJobTy* job;
+    fileJobTy** order; // [jobs] biggest first
+    int jobs;
+    int next;       // next order position to solve
+} fileRunTy;
+
+// load, calc and save one board on its own design
+static void fileSolve(fileJobTy* jobPtr) {
+   pbCtx* ctx=pbCtxNew();
+   if (ctx==NULL) { jobPtr->status=FileLoad; return; }
+   ctx->lev=PRINTWARN; // only problems, the summary tells the rest
+   char tag[strlen(jobPtr->fileName)+3]; // threads print together: say the board
+   sprintf(tag, "%s: ", jobPtr->fileName);
+   ctx->tag=tag;
+   if (pbLoadINI(ctx, jobPtr->fileName)!=0) jobPtr->status=FileLoad;
+   else if (pbCalcNodes(ctx)!=0) jobPtr->status=FileCalc;
+   else {
+      nTy* in=ctx->plan.node[0];
+      jobPtr->nodes=ctx->plan.nodes;
+      jobPtr->V=*in->Vo;
+      jobPtr->I=*in->Io;
+      jobPtr->P=*in->Po;
+      for (int k=1; k<ctx->plan.nodes; k++) {
+         if (ctx->plan.type[k]!=3) jobPtr->Pd+=*ctx->plan.node[k]->Pd;
+      }
+      jobPtr->status=(pbSaveINI(ctx, jobPtr->resName)==0) ? FileOk : FileSave;
+   }
+   pbCtxFree(ctx);
+   return;
+} // void fileSolve(fileJobTy* jobPtr)
+
+// worker: take the next board until none is left, a slow board only
+// holds its own thread
+static void* fileThread(void* argPtr) {
+   fileRunTy* runPtr=argPtr;
+   for (;;) {
+      int o=__sync_fetch_and_add(&runPtr->next, 1);
+      if (o>=runPtr->jobs) break;
+      fileSolve(runPtr->order[o]);
+   }
+   return NULL;
+} // void* fileThread(void* argPtr)
+
+static int cmpSize(const void* a, const void* b) { // biggest first, then in order
+   const fileJobTy* ja=*(fileJobTy* const*)a;
+   const fileJobTy* jb=*(fileJobTy* const*)b;
+   if (ja->size!=jb->size) return (ja->size<jb->size) - (ja->size>jb->size);
+   return (ja>jb) - (ja<jb);
+} // int cmpSize(const void* a, const void* b)
+
+// res file name of an INI file: "a.ini" or "a.pbc" ==> "a.res.ini", else ".res.ini" added
+static char* fileResName(const char* fileName) {
+   size_t len=strlen(fileName);
+   if (len>4 && (!strcasecmp(fileName+len-4, ".ini") || !strcasecmp(fileName+len-4, ".pbc"))) len-=4;
+   char* resPtr=malloc(len+sizeof(".res.ini"));
+   memcpy(resPtr, fileName, len);
+   strcpy(resPtr+len, ".res.ini");
+   return resPtr;
+} // char* fileResName(const char* fileName)
+
+// solve every INI file on threads, each res file next to its INI, then show
+// one summary line for every board in the given order. The biggest files
+// start first so the last thread does not wait alone on a big board.
+// threads=0 use all cores. Return 0 or -1 when any board failed
+int solveFiles(char** fileList, int files, int threads) {
+   if (files<1) {
+      printf("WARN: no INI file to solve\n");
+      return 0;
+   }
+   if (threads<1) threads=sysconf(_SC_NPROCESSORS_ONLN);
+   if (threads<1) threads=1;
+   if (threads>files) threads=files;
+   fileRunTy run;
+   run.jobs=files;
+   run.next=0;
+   run.job=calloc(files, sizeof(fileJobTy));
+   run.order=malloc(files*sizeof(fileJobTy*));
+   for (int f=0; f<files; f++) {
+      struct stat st;
+      run.job[f].fileName=fileList[f];
+      run.job[f].resName=fileResName(fileList[f]);
+      run.job[f].size=(stat(fileList[f], &st)==0) ? st.st_size : 0;
+      run.order[f]=&run.job[f];
+   }
+   qsort(run.order, files, sizeof(fileJobTy*), cmpSize);
+
+   pthread_t* th=malloc(threads*sizeof(pthread_t));
+   for (int t=1; t<threads; t++) pthread_create(&th[t], NULL, fileThread, &run);
+   fileThread(&run);
+   for (int t=1; t<threads; t++) pthread_join(th[t], NULL);
+   free(th);
+
+   const char* statusPtr[]={"ok", "load", "calc", "save"};
+   int failed=0;
+   double Psum=0, Pdsum=0;
+   printf("Boards:%d threads:%d\n", files, threads);
+   printf("status nodes       IN V       IN I       IN P       Pd W   file\n");
+   for (int f=0; f<files; f++) {
+      fileJobTy* jobPtr=&run.job[f];
+      if (jobPtr->status!=FileOk) {
+         printf("%-6s %5s %10s %10s %10s %10s   %s\n", statusPtr[jobPtr->status], "", "", "", "", "", jobPtr->fileName);
+         failed++;
+         continue;
+      }
+      printf("%-6s %5d %10.5g %10.5g %10.5g %10.5g   %s\n", statusPtr[jobPtr->status], jobPtr->nodes,
+             jobPtr->V, jobPtr->I, jobPtr->P, jobPtr->Pd, jobPtr->fileName);
+      Psum+=jobPtr->P;
+      Pdsum+=jobPtr->Pd;
+   }
+   printf("solved:%d failed:%d IN P sum:%g W Pd sum:%g W\n", files-failed, failed, Psum, Pdsum);
+   printf("\n");
+   for (int f=0; f<files; f++) free(run.job[f].resName);
+   free(run.job);
+   free(run.order);
+   return failed ? -1 : 0;
+} // int solveFiles(char** fileList, int files, int threads)
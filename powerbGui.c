@@ -91,30 +91,30 @@ int fillNodeData(int id, nTy* node); // GUI:
 
 int initNodeData(nTy* nodePtr) { // init to empty a nTy node
    int i;
-   nodePtr->name[0]='\0';
+   nodePtr->name="";
    nodePtr->type=0; // IN=0, SR=1, LR=2, RS=4, LD=3
    nodePtr->label[0]='\0'; // any user string
    nodePtr->refdes[0]='\0'; // "Uxx" or "RNxxxx"
    nodePtr->col=-1; // used for positioning
    nodePtr->row=-1; // used for positioning
-   for (i=0; i<MaxIns; i++) {
-      nodePtr->from[i]=NULL; // SR,LR,RS has 1, LD up to MaxIns
-      nodePtr-> in[i][0]='\0'; // used only by GUI
+   nodePtr->pix=-1; // not in evaluation plan
+   for (i=0; i<nodePtr->ins; i++) {
+      nodePtr->from[i]=-1; // SR,LR,RS has 1, LD any
+      nodePtr->in[i]=""; // used only by GUI
       nodePtr->Vi[i]=0;
       nodePtr->Ii[i]=0;
       nodePtr->R[i]=0;
       nodePtr->Pi[i]=0;
    }
-   nodePtr->yeld=0;
-   nodePtr->Iadj=0;
-   nodePtr->DV=0;
-   nodePtr->Pd=0;
-   nodePtr->Vo=0;
-   nodePtr->Io=0;
-   nodePtr->Po=0;
-   for (i=0; i<MaxOut; i++) {
-      nodePtr->to[i]=NULL; // to leaf
-   }
+   *nodePtr->yeld=0;
+   nodePtr->eff=NULL; // constant yeld
+   *nodePtr->Iadj=0;
+   *nodePtr->DV=0;
+   nodePtr->DVmin=0;
+   *nodePtr->Pd=0;
+   *nodePtr->Vo=0;
+   *nodePtr->Io=0;
+   *nodePtr->Po=0;
    nodePtr->out=0;
    return 0;
 } // int initNodeData(nTy* nodePtr)
@@ -131,7 +131,7 @@ int fillNodeData(int id, nTy* valuesPtr) {
    //nPtr=realloc(nPtr, sizeof(nCnt*size)); // allocation space for nodes
    //printf("nPtr:%p\n", nPtr);
    //void* mPtr=NULL;
-   //printf("valuesPtr->Vo:%g\n", valuesPtr->Vo);
+   //printf("valuesPtr->Vo:%g\n", *valuesPtr->Vo);
    //mPtr=memcpy(&nPtr[nCnt-1], valuesPtr, size); // copy vector element
    //printf("coping node to node_editor struct ...\n");
    //nTy* valuesNewPtr=malloc(sizeof(nTy)); // allocate space for an nTy
@@ -166,7 +166,7 @@ int saveINIres(nTy* nPtr, int nodes) {
          out+=sprintf(bufferPtr+out, "refdes=%s\n", nPtr->refdes);
       }
       if (type==3) { // LDx
-         for (int i=0; i<MaxIns; i++) {
+         for (int i=0; i<nPtr->ins; i++) {
             //printf("n:%d i:%d\n", n, i);
             if (nPtr->in[i][0]=='\0') continue; // LDx can have more than one
             out+=sprintf(bufferPtr+out, "f%d=%s\n", i, nPtr->in[i]);
@@ -182,19 +182,19 @@ int saveINIres(nTy* nPtr, int nodes) {
          out+=sprintf(bufferPtr+out, "Pi=%g\n", nPtr->Pi[0]);
       }
       if (type!=0) { // IN
-         out+=sprintf(bufferPtr+out, "DV=%g\n", nPtr->DV);
-         out+=sprintf(bufferPtr+out, "n=%g\n", nPtr->yeld);
-         out+=sprintf(bufferPtr+out, "Iadj=%g\n", nPtr->Iadj);
-         out+=sprintf(bufferPtr+out, "Pd=%g\n", nPtr->Pd);
+         out+=sprintf(bufferPtr+out, "DV=%g\n", *nPtr->DV);
+         out+=sprintf(bufferPtr+out, "n=%g\n", *nPtr->yeld);
+         out+=sprintf(bufferPtr+out, "Iadj=%g\n", *nPtr->Iadj);
+         out+=sprintf(bufferPtr+out, "Pd=%g\n", *nPtr->Pd);
       }
       if (type==0) { // IN
-         out+=sprintf(bufferPtr+out, "V=%g\n", nPtr->Vo);
-         out+=sprintf(bufferPtr+out, "I=%g\n", nPtr->Io);
-         out+=sprintf(bufferPtr+out, "P=%g\n", nPtr->Po);
+         out+=sprintf(bufferPtr+out, "V=%g\n", *nPtr->Vo);
+         out+=sprintf(bufferPtr+out, "I=%g\n", *nPtr->Io);
+         out+=sprintf(bufferPtr+out, "P=%g\n", *nPtr->Po);
       } else if (type!=3) { // LDx
-         out+=sprintf(bufferPtr+out, "Vo=%g\n", nPtr->Vo);
-         out+=sprintf(bufferPtr+out, "Io=%g\n", nPtr->Io);
-         out+=sprintf(bufferPtr+out, "Po=%g\n", nPtr->Po);
+         out+=sprintf(bufferPtr+out, "Vo=%g\n", *nPtr->Vo);
+         out+=sprintf(bufferPtr+out, "Io=%g\n", *nPtr->Io);
+         out+=sprintf(bufferPtr+out, "Po=%g\n", *nPtr->Po);
       }
       out+=sprintf(bufferPtr+out, "\n");
       //printf("buffer[%d]:'\n%s\n'\n", n, bufferPtr);
@@ -237,7 +237,7 @@ int guiLoadINI(void* nodedit, char* fileName) {
    nodeditPtr=nodedit;
    struct node* nodePtr;
    // at first remove all existing nodes and links
-   printf("nodeditPtr->node_count:%d nList.nodeCnt:%d\n", nodeditPtr->node_count, nList.nodeCnt);
+   printf("nodeditPtr->node_count:%d nList.nodeCnt:%d\n", nodeditPtr->node_count, pbCtxDef.nList.nodeCnt);
    printf("removing current nodes ...\n");
 #if 0
    int pass=0;
@@ -259,29 +259,30 @@ int guiLoadINI(void* nodedit, char* fileName) {
    freeMem(); // free values
    printf("cleared\n");
    //printf("\n");
-   printf("nodeditPtr->node_count:%d nList.nodeCnt:%d\n", nodeditPtr->node_count, nList.nodeCnt);
+   printf("nodeditPtr->node_count:%d nList.nodeCnt:%d\n", nodeditPtr->node_count, pbCtxDef.nList.nodeCnt);
 
    printf("init ...\n");
    node_editor_init(&nodeEditor);
    nodeEditor.initialized = 1;
    //char name[5];
-   printf("nodeditPtr->node_count:%d nList.nodeCnt:%d\n", nodeditPtr->node_count, nList.nodeCnt);
+   printf("nodeditPtr->node_count:%d nList.nodeCnt:%d\n", nodeditPtr->node_count, pbCtxDef.nList.nodeCnt);
 
    //int ret;
    //int sect;
    printf("loading ...\n");
    loadINI(fileName);
-   int sect=nList.nodeCnt;
+   layoutNodes(); // node col/row
+   int sect=pbCtxDef.nList.nodeCnt;
    printf("loaded %d sections, %d nodes\n", sect, sect-1);
    printf("\n");
    //showStructData();
-   printf("nodeditPtr->node_count:%d nList.nodeCnt:%d\n", nodeditPtr->node_count, nList.nodeCnt);
+   printf("nodeditPtr->node_count:%d nList.nodeCnt:%d\n", nodeditPtr->node_count, pbCtxDef.nList.nodeCnt);
 
    // create GUI nodes
    printf("Creating GUI nodes ...\n");
    int id;
-   nTy* nPtr=nList.first;
-   for (int n=0; n<sect; n++, nPtr=nPtr->next) {
+   nTy* nPtr=nListFirst(&pbCtxDef.nList);
+   for (int n=0; n<sect; n++, nPtr=nListNext(&pbCtxDef.nList, nPtr)) {
       //printf("graph n:%02d node:'%s'\n", n, nPtr->name);
       //if (nPtr->type==-1) continue; // BOARD
       int in=1, out=1;
@@ -293,7 +294,7 @@ int guiLoadINI(void* nodedit, char* fileName) {
       //printf("values addr node:%p\n", nPtr);
       fillNodeData(id, nPtr);
    }
-   printf("nodeditPtr->node_count:%d nList.nodeCnt:%d\n", nodeditPtr->node_count, nList.nodeCnt);
+   printf("nodeditPtr->node_count:%d nList.nodeCnt:%d\n", nodeditPtr->node_count, pbCtxDef.nList.nodeCnt);
 
    // create GUI links
    printf("Creating GUI links ...\n");
@@ -302,14 +303,13 @@ int guiLoadINI(void* nodedit, char* fileName) {
       //printf("graph n:%02d id:%02d addr:%p\n", n, nodePtr->ID, nodePtr);
       nPtr=nodePtr->valuesPtr;
       if (nPtr->type==-1) continue; // BOARD
-      if (nPtr->type==3) continue; // LD
-      for (int l=0; l<MaxOut; l++) {
-         if (nPtr->to[l]!=NULL) {
+      if (nPtr->type==0) continue; // IN
+      for (int l=0; l<nPtr->ins; l++) { // links from the node inputs
+         if (nPtr->from[l]>=0) {
             //printf("grap_ n:%02d l:%02d node:%p valuesPtr:%p\n", n, l, nodePtr, nPtr);
-            //printf("grap_ n:%02d l:%02d name:'%s' values.to.name:'%s' addr:%p\n", n, l, nodePtr->name, nPtr->to[l]->name, nPtr->to[l]);
-            int id=findGuiNode(nodeditPtr, nPtr->to[l]);
-            //printf("find node id:%d for nPtr->to[l]:%p\n", id, nPtr->to[l]);
-            node_editor_link(nodeditPtr, nodePtr->ID, 0, id, 0); // link two nodes: nodeIDfrom, slotIDfrom, nodeIDto, slotIDto
+            int id=findGuiNode(nodeditPtr, NodeAt(&pbCtxDef.nList, nPtr->from[l]));
+            //printf("find node id:%d for nPtr->from[l]:%d\n", id, nPtr->from[l]);
+            node_editor_link(nodeditPtr, id, 0, nodePtr->ID, 0); // link two nodes: nodeIDfrom, slotIDfrom, nodeIDto, slotIDto
          }
       }
    }
@@ -17,86 +17,937 @@
 /* powerbLib.c LIB: read INI file, check content and fill struct */
 
 #include <stdio.h>
+#include <ctype.h>
+#include <math.h>
 #include <strings.h>
 
-#include <iniparser.h> // dictionary with N sections with M keys
-
 #include "powerbLib.h"
 #include "fileIo.h"
 
-//nTy* nPtr; // vector of struct/nodes ptr
-nListTy nList; // list of node values, needed for GUI
-//int sect;  // number of sections/nodes
-dictionary* graphPtr; // INI file dictionary ptr
-nTy* missFrom=NULL; // take note of node to complete later
+pbCtx pbCtxDef={.nList.plan=&pbCtxDef.plan, .lev=PRINTALL}; // design of the compatibility calls, needed for GUI
+
+// keys of a node section known by loadINI(), their index in ctx->keyVal
+#define KeyLabel  0
+#define KeyRefdes 1
+#define KeyV      2 // IN
+#define KeyI      3
+#define KeyP      4
+#define KeyVi     5 // SR, LR, RS input 0
+#define KeyIi     6
+#define KeyPi     7
+#define KeyR      8
+#define KeyN      9
+#define KeyEff   10
+#define KeyIadj  11
+#define KeyDV    12
+#define KeyDVmin 13
+#define KeyPd    14
+#define KeyVo    15
+#define KeyIo    16
+#define KeyPo    17
+#define KeyCap   18 // IN battery
+#define KeySoc0  19
+#define KeySoc   20
+#define KeyVoc   21
+#define KeyRint  22
+#define KeyVcut  23
+#define KeyDt    24
+#define KeyRth   25 // thermal
+#define KeyTa    26
+#define KeyTmax  27
+#define KeyTc    28
+#define KeyVoopt 29 // design alternatives
+#define KeyAsLR  30
+#define KeyAsSR  31
+#define KeyCnt   32
+static const char* const keyNamePtr[KeyCnt]={"label", "refdes", "v", "i", "p", "vi", "ii",
+   "pi", "r", "n", "eff", "iadj", "dv", "dvmin", "pd", "vo", "io", "po", "cap", "soc0",
+   "soc", "voc", "rint", "vcut", "dt", "rth", "ta", "tmax", "tc", "voopt", "aslr", "assr"};
 
-// init the double linked node list
+// keys of every input of a node "f0", "V0" ..., after the named ones
+#define SlotF     0
+#define SlotV     1
+#define SlotI     2
+#define SlotP     3
+#define SlotR     4
+#define SlotProf  5
+#define SlotDt    6
+#define SlotFopt  7 // "f0opt"
+#define SlotKeys  8
+static const char* const slotNamePtr[SlotFopt]={"f", "v", "i", "p", "r", "prof", "dt"};
+#define SlotKey(i, key) (KeyCnt+SlotKeys*(i)+(key)) // index in ctx->keyVal
+#define InsLimit  65536 // fN of a section below it, a larger N is taken as a typo
+
+// init the node pool. A used pool is emptied in one reset: the blocks are
+// kept for the next nodes, so reloading a design does not allocate again
 void nListInit(nListTy* nListPtr) {
    if (nListPtr==NULL) return;
-   nListPtr->first=NULL;
-   nListPtr->last=NULL;
+   if (!nListPtr->init) {
+      nListPtr->block=NULL;
+      nListPtr->blocks=0;
+      nListPtr->inMax=0;
+      nListPtr->from=NULL;
+      nListPtr->in=NULL;
+      nListPtr->Vi=nListPtr->Ii=nListPtr->R=nListPtr->Pi=NULL;
+      nListPtr->nodeMax=0;
+      nListPtr->yeld=nListPtr->Iadj=nListPtr->DV=nListPtr->Pd=NULL;
+      nListPtr->Vo=nListPtr->Io=nListPtr->Po=NULL;
+      memset(&nListPtr->names, 0, sizeof(nameTabTy));
+   }
+   for (int n=0; n<nListPtr->used; n++) {
+      nTy* nodePtr=NodeAt(nListPtr, n);
+      if (nodePtr->ix>=0) effFree(nodePtr->eff);
+   }
+   nameTabTy* tabPtr=&nListPtr->names; // names go with the nodes
+   for (int c=0; c<tabPtr->chunks; c++) free(tabPtr->chunk[c]);
+   tabPtr->chunks=0;
+   tabPtr->fill=NULL;
+   tabPtr->left=0;
+   tabPtr->cnt=0;
+   if (tabPtr->str) memset(tabPtr->str, 0, tabPtr->max*sizeof(char*));
+   nListPtr->used=0;
    nListPtr->nodeCnt=0;
+   nListPtr->inputs=0;
+   nListPtr->placed=0;
    nListPtr->init=1;
    return;
 } // nListInit(nListTy* nListPtr)
 
-// add an empty node to the double linked list as last element, return its pointer
+// point the solver values of a node to its slot in the pool columns
+static void nListView(nListTy* nListPtr, nTy* nodePtr) {
+   int ix=nodePtr->ix;
+   nodePtr->yeld=nListPtr->yeld+ix;
+   nodePtr->Iadj=nListPtr->Iadj+ix;
+   nodePtr->DV=nListPtr->DV+ix;
+   nodePtr->Pd=nListPtr->Pd+ix;
+   nodePtr->Vo=nListPtr->Vo+ix;
+   nodePtr->Io=nListPtr->Io+ix;
+   nodePtr->Po=nListPtr->Po+ix;
+   return;
+} // void nListView(nListTy* nListPtr, nTy* nodePtr)
+
+// grow the node columns to max slots, the views of every node are set
+// again. Return 0 or -1
+static int nListColumns(nListTy* nListPtr, int max) {
+   double** colPtr[7]={&nListPtr->yeld, &nListPtr->Iadj, &nListPtr->DV, &nListPtr->Pd,
+                       &nListPtr->Vo, &nListPtr->Io, &nListPtr->Po};
+   int ok=1;
+   for (int c=0; c<7; c++) {
+      double* newPtr=realloc(*colPtr[c], max*sizeof(double));
+      if (newPtr) *colPtr[c]=newPtr;
+      else ok=0;
+   }
+   for (int n=0; n<nListPtr->used; n++) { // columns moved, even the ones done on error
+      nTy* nPtr=NodeAt(nListPtr, n);
+      if (nPtr->ix>=0) nListView(nListPtr, nPtr);
+   }
+   if (!ok) return -1;
+   nListPtr->nodeMax=max;
+   return 0;
+} // int nListColumns(nListTy* nListPtr, int max)
+
+// add an empty node to the pool as last element, return its pointer. The
+// pool grows by blocks, a node keeps its address until the pool is emptied.
+// Its solver values are in the pool columns: they can move, nTy has views
 nTy* nListAdd(nListTy* nListPtr) {
    if (nListPtr==NULL) return NULL;
-   nTy* nodePtr;
-   //printf("nListPtr->nodeCnt:%d\n", nListPtr->nodeCnt);
-   nodePtr = malloc(sizeof(nTy));
+   if (nListPtr->used==nListPtr->nodeMax && nListColumns(nListPtr, nListPtr->nodeMax ? 2*nListPtr->nodeMax : NodeBlock)!=0) return NULL;
+   if (nListPtr->used==nListPtr->blocks*NodeBlock) { // pool full
+      nTy** blockPtr=realloc(nListPtr->block, (nListPtr->blocks+1)*sizeof(nTy*));
+      if (blockPtr==NULL) return NULL;
+      nListPtr->block=blockPtr;
+      nListPtr->block[nListPtr->blocks]=malloc(NodeBlock*sizeof(nTy));
+      if (nListPtr->block[nListPtr->blocks]==NULL) return NULL;
+      nListPtr->blocks++;
+   }
+   int ix=nListPtr->used++;
+   nTy* nodePtr=NodeAt(nListPtr, ix);
+   nodePtr->ix=ix;
+   nodePtr->name="";
+   nListView(nListPtr, nodePtr);
+   *nodePtr->yeld=*nodePtr->Iadj=*nodePtr->DV=*nodePtr->Pd=0;
+   *nodePtr->Vo=*nodePtr->Io=*nodePtr->Po=0;
+   nodePtr->ins=0;
+   if (nListInputs(nListPtr, nodePtr, 1)!=0) { // one input, a LD get more
+      nListPtr->used--;
+      return NULL;
+   }
+   nodePtr->eff = NULL;
+   nodePtr->DVmin = 0;
+   nodePtr->col=-1;
+   nodePtr->row=-1;
    nListPtr->nodeCnt++;
-   //printf("nListPtr[%d]:%p\n", nListPtr->nodeCnt-1, nodePtr);
-   if (!nListPtr->first) { // first node
-      nodePtr->next = NULL;
-      nodePtr->prev = NULL;
-      nListPtr->first = nodePtr;
-      nListPtr->last = nodePtr;
-   } else { // next nodes
-      nodePtr->prev = nListPtr->last;
-      if (nListPtr->last) // can remove condition
-         nListPtr->last->next = nodePtr;
-      nodePtr->next = NULL;
-      nListPtr->last = nodePtr;
-   }
-   //printf("nodePtr:%p\n", nodePtr);
-   //printf("nodeCnt:%d\n", nListPtr->nodeCnt);
-   //printf("\n");
+   nListPtr->placed=0;
+   if (nListPtr->plan) nListPtr->plan->valid=0; // links changed
    return nodePtr;
 } // nTy* nListAdd(nList* nListPtr)
 
-// delete a node from the double linked list
+// delete a node from the pool, links of the other nodes to it are cleared.
+// Its slot is given again only when it is the last one
 void nListDel(nListTy* nListPtr, nTy* nodePtr) {
-   if (nListPtr==NULL || nodePtr==NULL) return;
-   if (nListPtr->nodeCnt>0) {
-      //printf("delete node:%p\n", nodePtr);
-      // remove from the linked list
-      //node_pop(nListPtr, nodePtr);
-      if (nodePtr->next) // not last
-         nodePtr->next->prev = nodePtr->prev; // can be NULL if first
-      if (nodePtr->prev) // not first
-         nodePtr->prev->next = nodePtr->next; // can be NULL if last
-      if (nListPtr->last == nodePtr) // last
-         nListPtr->last = nodePtr->prev;
-      if (nListPtr->first == nodePtr) // first
-         nListPtr->first = nodePtr->next;
-      nodePtr->next = NULL; // just in case
-      nodePtr->prev = NULL; // just in case
-      free(nodePtr);
-      nListPtr->nodeCnt--;
+   if (nListPtr==NULL || nodePtr==NULL || nodePtr->ix<0) return;
+   int ix=nodePtr->ix;
+   for (nTy* nPtr=nListFirst(nListPtr); nPtr; nPtr=nListNext(nListPtr, nPtr)) {
+      for (int i=0; i<nPtr->ins; i++) {
+         if (nPtr->from[i]==ix) nPtr->from[i]=-1;
+      }
    }
+   nListName(nListPtr, nodePtr, ""); // name free for another node
+   effFree(nodePtr->eff);
+   nodePtr->eff=NULL;
+   nodePtr->ix=-1;
+   while (nListPtr->used>0 && NodeAt(nListPtr, nListPtr->used-1)->ix<0) nListPtr->used--;
+   nListPtr->nodeCnt--;
+   nListPtr->placed=0;
+   if (nListPtr->plan) nListPtr->plan->valid=0; // links changed
    return;
 } // nListDel(nListTy* nListPtr, nTy* nodePtr)
 
-int loadINI(char* graphFile) {
+// give a node ins input slots, the first ones keep their values and the
+// new ones are empty. The slots of all nodes are in a row, as loaded, so
+// a node with more inputs moves to the end. The pool arrays can move:
+// the pointers of every node are set again. Return 0 or -1
+int nListInputs(nListTy* nListPtr, nTy* nodePtr, int ins) {
+   if (ins<=nodePtr->ins && nodePtr->ins>0) { // fewer: keep the slots
+      for (int i=ins; i<nodePtr->ins; i++) {
+         nodePtr->from[i]=-1;
+         nodePtr->in[i]="";
+         nodePtr->Vi[i]=nodePtr->Ii[i]=nodePtr->R[i]=nodePtr->Pi[i]=0;
+      }
+      nodePtr->ins=ins;
+      if (nListPtr->plan) nListPtr->plan->valid=0; // links changed
+      return 0;
+   }
+   int first=nListPtr->inputs;
+   if (nodePtr->ins>0 && nodePtr->inFirst+nodePtr->ins==first) { // last: grow in place
+      first=nodePtr->inFirst;
+      nListPtr->inputs=first;
+   }
+   if (first+ins>nListPtr->inMax) {
+      int max=2*nListPtr->inMax;
+      if (max<first+ins) max=first+ins;
+      if (max<NodeBlock) max=NodeBlock;
+      int* fromPtr=realloc(nListPtr->from, max*sizeof(int));
+      if (fromPtr) nListPtr->from=fromPtr;
+      const char** inPtr=realloc(nListPtr->in, max*sizeof(char*));
+      if (inPtr) nListPtr->in=inPtr;
+      double* vPtr[4]={nListPtr->Vi, nListPtr->Ii, nListPtr->R, nListPtr->Pi};
+      int ok=(fromPtr!=NULL && inPtr!=NULL);
+      for (int f=0; f<4; f++) {
+         double* newPtr=realloc(vPtr[f], max*sizeof(double));
+         if (newPtr) vPtr[f]=newPtr;
+         else ok=0;
+      }
+      nListPtr->Vi=vPtr[0]; nListPtr->Ii=vPtr[1]; nListPtr->R=vPtr[2]; nListPtr->Pi=vPtr[3];
+      if (!ok) return -1;
+      nListPtr->inMax=max;
+      for (int n=0; n<nListPtr->used; n++) { // arrays moved
+         nTy* nPtr=NodeAt(nListPtr, n);
+         if (nPtr->ix<0 || nPtr==nodePtr) continue;
+         nPtr->from=nListPtr->from+nPtr->inFirst;
+         nPtr->in=nListPtr->in+nPtr->inFirst;
+         nPtr->Vi=nListPtr->Vi+nPtr->inFirst;
+         nPtr->Ii=nListPtr->Ii+nPtr->inFirst;
+         nPtr->R=nListPtr->R+nPtr->inFirst;
+         nPtr->Pi=nListPtr->Pi+nPtr->inFirst;
+      }
+   }
+   for (int i=0; i<ins; i++) {
+      int m=first+i;
+      if (i<nodePtr->ins) { // old slots are still in the arrays
+         int o=nodePtr->inFirst+i;
+         if (o==m) continue; // grown in place
+         nListPtr->from[m]=nListPtr->from[o];
+         nListPtr->in[m]=nListPtr->in[o];
+         nListPtr->Vi[m]=nListPtr->Vi[o];
+         nListPtr->Ii[m]=nListPtr->Ii[o];
+         nListPtr->R[m]=nListPtr->R[o];
+         nListPtr->Pi[m]=nListPtr->Pi[o];
+         continue;
+      }
+      nListPtr->from[m]=-1;
+      nListPtr->in[m]="";
+      nListPtr->Vi[m]=nListPtr->Ii[m]=nListPtr->R[m]=nListPtr->Pi[m]=0;
+   }
+   nListPtr->inputs+=ins;
+   nodePtr->ins=ins;
+   nodePtr->inFirst=first;
+   nodePtr->from=nListPtr->from+first;
+   nodePtr->in=nListPtr->in+first;
+   nodePtr->Vi=nListPtr->Vi+first;
+   nodePtr->Ii=nListPtr->Ii+first;
+   nodePtr->R=nListPtr->R+first;
+   nodePtr->Pi=nListPtr->Pi+first;
+   if (nListPtr->plan) nListPtr->plan->valid=0; // links changed
+   return 0;
+} // int nListInputs(nListTy* nListPtr, nTy* nodePtr, int ins)
+
+// first node of the pool, NULL when empty
+nTy* nListFirst(const nListTy* nListPtr) {
+   for (int n=0; n<nListPtr->used; n++) {
+      nTy* nodePtr=NodeAt(nListPtr, n);
+      if (nodePtr->ix>=0) return nodePtr;
+   }
+   return NULL;
+} // nTy* nListFirst(const nListTy* nListPtr)
+
+// next node in add order, a linear scan of the blocks
+nTy* nListNext(const nListTy* nListPtr, const nTy* nodePtr) {
+   for (int n=nodePtr->ix+1; n<nListPtr->used; n++) {
+      nTy* nextPtr=NodeAt(nListPtr, n);
+      if (nextPtr->ix>=0) return nextPtr;
+   }
+   return NULL;
+} // nTy* nListNext(const nListTy* nListPtr, const nTy* nodePtr)
+
+// empty the pool and give back its blocks
+void nListFree(nListTy* nListPtr) {
+   if (nListPtr==NULL || !nListPtr->init) return;
+   nListInit(nListPtr);
+   for (int b=0; b<nListPtr->blocks; b++) free(nListPtr->block[b]);
+   free(nListPtr->block);
+   nListPtr->block=NULL;
+   nListPtr->blocks=0;
+   free(nListPtr->from);
+   free(nListPtr->in);
+   free(nListPtr->Vi);
+   free(nListPtr->Ii);
+   free(nListPtr->R);
+   free(nListPtr->Pi);
+   free(nListPtr->yeld);
+   free(nListPtr->Iadj);
+   free(nListPtr->DV);
+   free(nListPtr->Pd);
+   free(nListPtr->Vo);
+   free(nListPtr->Io);
+   free(nListPtr->Po);
+   free(nListPtr->names.str);
+   free(nListPtr->names.ix);
+   free(nListPtr->names.chunk);
+   nListPtr->init=0;
+   return;
+} // void nListFree(nListTy* nListPtr)
+
+static inline u32 nameHash(const char* str) { // FNV-1a ignoring case
+   u32 h=2166136261u;
+   for (; *str; str++) h=(h^(u08)tolower((u08)*str))*16777619u;
+   return h;
+} // u32 nameHash(const char* str)
+
+// slot of str in the name table, or the free slot where it goes
+static int nameSlot(const nameTabTy* tabPtr, const char* str) {
+   int mask=tabPtr->max-1;
+   int j=nameHash(str)&mask;
+   while (tabPtr->str[j] && strcmp(tabPtr->str[j], str)) j=(j+1)&mask;
+   return j;
+} // int nameSlot(const nameTabTy* tabPtr, const char* str)
+
+// new storage chunk of the name table, NULL when out of memory
+static char* nameChunk(nameTabTy* tabPtr, size_t size) {
+   char** chunkPtr=realloc(tabPtr->chunk, (tabPtr->chunks+1)*sizeof(char*));
+   if (chunkPtr==NULL) return NULL;
+   tabPtr->chunk=chunkPtr;
+   char* bufPtr=malloc(size);
+   if (bufPtr) tabPtr->chunk[tabPtr->chunks++]=bufPtr;
+   return bufPtr;
+} // char* nameChunk(nameTabTy* tabPtr, size_t size)
+
+// the pool copy of a string, the same pointer for equal strings. The pool
+// keeps it until emptied. NULL when out of memory
+const char* nListIntern(nListTy* nListPtr, const char* str) {
+   nameTabTy* tabPtr=&nListPtr->names;
+   if (2*(tabPtr->cnt+1)>tabPtr->max) { // rehash to twice the slots
+      int max=tabPtr->max ? 2*tabPtr->max : NodeBlock;
+      const char** strPtr=calloc(max, sizeof(char*));
+      int* ixPtr=malloc(max*sizeof(int));
+      if (strPtr==NULL || ixPtr==NULL) { free(strPtr); free(ixPtr); return NULL; }
+      nameTabTy tab=*tabPtr;
+      tab.str=strPtr;
+      tab.ix=ixPtr;
+      tab.max=max;
+      for (int j=0; j<tabPtr->max; j++) {
+         if (tabPtr->str[j]==NULL) continue;
+         int k=nameSlot(&tab, tabPtr->str[j]);
+         tab.str[k]=tabPtr->str[j];
+         tab.ix[k]=tabPtr->ix[j];
+      }
+      free(tabPtr->str);
+      free(tabPtr->ix);
+      *tabPtr=tab;
+   }
+   int j=nameSlot(tabPtr, str);
+   if (tabPtr->str[j]) return tabPtr->str[j];
+   size_t len=strlen(str)+1;
+   char* copyPtr;
+   if (len>NameChunk) copyPtr=nameChunk(tabPtr, len); // a long string get its own
+   else {
+      if (len>tabPtr->left) {
+         tabPtr->left=0;
+         tabPtr->fill=nameChunk(tabPtr, NameChunk);
+         if (tabPtr->fill==NULL) return NULL;
+         tabPtr->left=NameChunk;
+      }
+      copyPtr=tabPtr->fill;
+      tabPtr->fill+=len;
+      tabPtr->left-=len;
+   }
+   if (copyPtr==NULL) return NULL;
+   memcpy(copyPtr, str, len);
+   tabPtr->str[j]=copyPtr;
+   tabPtr->ix[j]=-1;
+   tabPtr->cnt++;
+   return copyPtr;
+} // const char* nListIntern(nListTy* nListPtr, const char* str)
+
+// name a node with the pool copy of name. The first node with a name is the
+// one found by it. Return 0 or -1 when out of memory
+int nListName(nListTy* nListPtr, nTy* nodePtr, const char* name) {
+   nameTabTy* tabPtr=&nListPtr->names;
+   if (tabPtr->max>0 && nodePtr->name[0]) { // old name free
+      int j=nameSlot(tabPtr, nodePtr->name);
+      if (tabPtr->str[j] && tabPtr->ix[j]==nodePtr->ix) tabPtr->ix[j]=-1;
+   }
+   const char* namePtr=nListIntern(nListPtr, name);
+   if (namePtr==NULL) return -1;
+   nodePtr->name=namePtr;
+   if (namePtr[0]=='\0') return 0;
+   int j=nameSlot(tabPtr, namePtr);
+   if (tabPtr->ix[j]<0) tabPtr->ix[j]=nodePtr->ix;
+   return 0;
+} // int nListName(nListTy* nListPtr, nTy* nodePtr, const char* name)
+
+// node by name ignoring case, NULL when none. Names equal but for the case
+// have the same hash: they are all in the probe run before a free slot
+nTy* nListFind(nListTy* nListPtr, const char* name) {
+   const nameTabTy* tabPtr=&nListPtr->names;
+   if (tabPtr->max==0) return NULL;
+   int mask=tabPtr->max-1;
+   for (int j=nameHash(name)&mask; tabPtr->str[j]; j=(j+1)&mask) {
+      if (tabPtr->ix[j]>=0 && !strcasecmp(tabPtr->str[j], name)) return NodeAt(nListPtr, tabPtr->ix[j]);
+   }
+   return NULL;
+} // nTy* nListFind(nListTy* nListPtr, const char* name)
+
+// fill a curve axis from cnt increasing points, return 0 or -1
+int effAxis(effAxTy* axPtr, const double* x, int cnt) {
+   axPtr->cnt=cnt;
+   axPtr->x=malloc((cnt+1)*sizeof(double));
+   axPtr->w=malloc(cnt*sizeof(double));
+   axPtr->b=NULL;
+   if (axPtr->x==NULL || axPtr->w==NULL) return -1;
+   double minW=0;
+   for (int p=0; p<cnt; p++) {
+      axPtr->x[p]=x[p];
+      axPtr->w[p]=p<cnt-1 ? 1/(x[p+1]-x[p]) : 0;
+      if (p<cnt-1 && (minW==0 || x[p+1]-x[p]<minW)) minW=x[p+1]-x[p];
+   }
+   axPtr->x[cnt]=x[cnt-1];
+   double range=x[cnt-1]-x[0];
+   axPtr->buckets=1;
+   if (cnt>1) { // buckets not wider than the narrowest segment
+      double m=range/minW;
+      axPtr->buckets=m<EffBuckets-1 ? (int)m+1 : EffBuckets;
+   }
+   axPtr->scale=cnt>1 ? axPtr->buckets/range : 0;
+   axPtr->b=malloc(axPtr->buckets*sizeof(u16));
+   if (axPtr->b==NULL) return -1;
+   int seg=0;
+   for (int j=0; j<axPtr->buckets; j++) {
+      double at=cnt>1 ? x[0]+j/axPtr->scale : x[0];
+      while (seg<cnt-2 && at>=x[seg+1]) seg++;
+      axPtr->b[j]=seg;
+   }
+   return 0;
+} // int effAxis(effAxTy* axPtr, const double* x, int cnt)
+
+// parse the SR efficiency curve "Io:{0.01,0.1,1};n:{0.7,0.88,0.9}", with
+// optional "Vi:{5,12}" and then n given as one Io row for every Vi. Every
+// axis get a uniform bucket table so effLookup() need no search.
+// Return the curve or NULL on error
+effTy* effParse(const char* strPtr) {
+   const char* keyPtr[3]={"Io", "Vi", "n"};
+   double* axPtr[3]={NULL, NULL, NULL}; // Io, Vi, n
+   u16 axCnt[3]={0, 0, 0};
+   effTy* effPtr=NULL;
+   if (strPtr==NULL) return NULL;
+   char* bufPtr=malloc(strlen(strPtr)+1);
+   strcpy(bufPtr, strPtr);
+   char* chPtr=bufPtr;
+   for (;;) { // key:{v0,v1,...} separated by ';' or spaces
+      while (*chPtr==' ' || *chPtr=='\t' || *chPtr==';') chPtr++;
+      if (*chPtr=='\0') break;
+      char* colPtr=strchr(chPtr, ':');
+      if (colPtr==NULL) { printf("ERROR: eff miss ':' in '%s'\n", chPtr); goto fail; }
+      *colPtr='\0';
+      int a;
+      for (a=0; a<3; a++) {
+         if (strcasecmp(chPtr, keyPtr[a])==0) break;
+      }
+      if (a==3 || axPtr[a]) { printf("ERROR: eff unknown or double key:'%s'\n", chPtr); goto fail; }
+      for (chPtr=colPtr+1; *chPtr==' '; chPtr++) ;
+      if (*chPtr!='{') { printf("ERROR: eff miss '{' after '%s'\n", keyPtr[a]); goto fail; }
+      if (parseVector(chPtr+1, &axPtr[a], &axCnt[a])!=OK) goto fail;
+      chPtr=strchr(chPtr, '}')+1;
+   }
+   if (axPtr[0]==NULL || axPtr[2]==NULL) { printf("ERROR: eff need Io:{...} and n:{...}, quote it when using ';'\n"); goto fail; }
+   double* Io=axPtr[0];
+   double* Vi=axPtr[1];
+   double* n=axPtr[2];
+   int cI=axCnt[0], cV=Vi ? axCnt[1] : 1;
+   if (axCnt[2]!=cI*cV) { printf("ERROR: eff has %d n, expected %d\n", axCnt[2], cI*cV); goto fail; }
+   for (int p=1; p<cI; p++) {
+      if (Io[p]<=Io[p-1]) { printf("ERROR: eff Io not increasing\n"); goto fail; }
+   }
+   for (int p=1; p<cV; p++) {
+      if (Vi[p]<=Vi[p-1]) { printf("ERROR: eff Vi not increasing\n"); goto fail; }
+   }
+   for (int p=0; p<cI*cV; p++) {
+      if (n[p]<=0 || n[p]>1) { printf("ERROR: eff n:%g not in (0,1]\n", n[p]); goto fail; }
+   }
+
+   effPtr=calloc(1, sizeof(effTy));
+   double noVi=0;
+   if (effAxis(&effPtr->Io, Io, cI)!=0 || effAxis(&effPtr->Vi, Vi ? Vi : &noVi, cV)!=0) {
+      printf("ERROR: eff cannot allocate\n");
+      effFree(effPtr);
+      effPtr=NULL;
+      goto fail;
+   }
+   effPtr->n=malloc((size_t)(cV+1)*(cI+1)*sizeof(double));
+   for (int y=0; y<=cV; y++) { // repeat last row and column
+      for (int x=0; x<=cI; x++) {
+         effPtr->n[y*(cI+1)+x]=n[(y<cV ? y : cV-1)*cI+(x<cI ? x : cI-1)];
+      }
+   }
+   effPtr->src=malloc(strlen(strPtr)+1);
+   strcpy(effPtr->src, strPtr);
+
+fail:
+   for (int a=0; a<3; a++) free(axPtr[a]);
+   free(bufPtr);
+   return effPtr;
+} // effTy* effParse(const char* strPtr)
+
+// free an SR efficiency curve
+void effFree(effTy* effPtr) {
+   if (effPtr==NULL) return;
+   free(effPtr->Io.x); free(effPtr->Io.w); free(effPtr->Io.b);
+   free(effPtr->Vi.x); free(effPtr->Vi.w); free(effPtr->Vi.b);
+   free(effPtr->n);
+   free(effPtr->src);
+   free(effPtr);
+} // void effFree(effTy* effPtr)
+
+// parse the tolerance after a value: "0.528 ±10% normal", "3.3 +-0.05".
+// Return 1 and fill rel, tol, dist when found, 0 when none, -1 on error
+int parseTol(const char* strPtr, tolTy* tolPtr) {
+   const char* chPtr=strstr(strPtr, "\xC2\xB1"); // UTF-8 ±
+   int len=2;
+   if (chPtr==NULL) { chPtr=strstr(strPtr, "+/-"); len=3; }
+   if (chPtr==NULL) { chPtr=strstr(strPtr, "+-"); len=2; }
+   if (chPtr==NULL) return 0;
+   char* endPtr;
+   tolPtr->tol=strtod(chPtr+len, &endPtr);
+   if (endPtr==chPtr+len || tolPtr->tol<0) {
+      printf("Invalid tolerance:'%s'\n", strPtr);
+      return -1;
+   }
+   tolPtr->rel=0;
+   if (*endPtr=='%') {
+      tolPtr->rel=1;
+      tolPtr->tol/=100;
+      endPtr++;
+   }
+   while (*endPtr==' ' || *endPtr=='\t') endPtr++;
+   tolPtr->dist=TolUniform;
+   if (strncasecmp(endPtr, "normal", 6)==0 || strncasecmp(endPtr, "gauss", 5)==0) {
+      tolPtr->dist=TolNormal;
+   } else if (*endPtr!='\0' && strncasecmp(endPtr, "uniform", 7)!=0) {
+      printf("Invalid distribution:'%s'\n", endPtr);
+      return -1;
+   }
+   return 1;
+} // int parseTol(const char* strPtr, tolTy* tolPtr)
+
+// index in ctx->keyVal of the key of a section, -1 when unknown or of an
+// input over ins
+static int keyIndex(const char* keyPtr, int ins) {
+   char ch=tolower((unsigned char)keyPtr[0]);
+   for (int k=0; k<KeyCnt; k++) {
+      if (keyNamePtr[k][0]==ch && strcasecmp(keyNamePtr[k], keyPtr)==0) return k;
+   }
+   const char* numPtr=keyPtr;
+   while (isalpha((unsigned char)*numPtr)) numPtr++;
+   if (!isdigit((unsigned char)*numPtr)) return -1;
+   char* endPtr;
+   long i=strtol(numPtr, &endPtr, 10);
+   if (i>=ins) return -1;
+   size_t len=numPtr-keyPtr;
+   for (int k=0; k<SlotFopt; k++) {
+      if (strlen(slotNamePtr[k])!=len || strncasecmp(slotNamePtr[k], keyPtr, len)!=0) continue;
+      if (*endPtr=='\0') return SlotKey(i, k);
+      if (k==SlotF && strcasecmp(endPtr, "opt")==0) return SlotKey(i, SlotFopt);
+      return -1;
+   }
+   return -1;
+} // int keyIndex(const char* keyPtr, int ins)
+
+// values of the known keys of INI section s in ctx->keyVal, NULL when
+// missing, found in one pass. Return the inputs up to the largest fN key or
+// -1 on error
+static int sectKeys(pbCtx* ctx, int s) {
+   const iniSectTy* sectPtr=&ctx->ini.sect[s];
+   const iniKeyTy* keyPtr=ctx->ini.key+sectPtr->first;
+   int ins=1;
+   for (int k=0; k<sectPtr->keys; k++) { // largest fN, any N
+      const char* chPtr=keyPtr[k].key;
+      if (tolower((unsigned char)chPtr[0])!='f' || !isdigit((unsigned char)chPtr[1])) continue;
+      char* endPtr;
+      long i=strtol(chPtr+1, &endPtr, 10);
+      if (*endPtr!='\0') continue;
+      if (i>=InsLimit) {
+         printf("Input key:'%s' of:'%s' over f%d. Quit\n", chPtr, sectPtr->name, InsLimit-1);
+         return -1;
+      }
+      if (i>=ins) ins=i+1;
+   }
+   int cnt=SlotKey(ins, 0);
+   if (cnt>ctx->keyMax) {
+      char** valPtr=realloc(ctx->keyVal, cnt*sizeof(char*));
+      if (valPtr==NULL) {
+         printf("No memory for node:'%s'. Quit\n", sectPtr->name);
+         return -1;
+      }
+      ctx->keyVal=valPtr;
+      ctx->keyMax=cnt;
+   }
+   memset(ctx->keyVal, 0, cnt*sizeof(char*));
+   for (int k=0; k<sectPtr->keys; k++) { // last one wins when repeated
+      int j=keyIndex(keyPtr[k].key, ins);
+      if (j>=0) ctx->keyVal[j]=keyPtr[k].val;
+   }
+   return ins;
+} // int sectKeys(pbCtx* ctx, int s)
+
+// string of a key of the section being loaded, def when missing
+static inline const char* keyStr(const pbCtx* ctx, int key, const char* def) {
+   return ctx->keyVal[key] ? ctx->keyVal[key] : def;
+} // const char* keyStr(const pbCtx* ctx, int key, const char* def)
+
+// number of a key of the section being loaded, def when missing
+static inline double keyNum(const pbCtx* ctx, int key, double def) {
+   return ctx->keyVal[key] ? strtod(ctx->keyVal[key], NULL) : def;
+} // double keyNum(const pbCtx* ctx, int key, double def)
+
+// values of a node checked by pbValidateNodes(), the pbSet...() calls and
+// the tolerances
+#define ValVo   0 // IN V, regulator Vo: >0
+#define ValN    1 // SR n: (0,1]
+#define ValIadj 2 // LR Iadj: >=0
+#define ValR    3 // RS R: (0,MaxRsValue], LD R: >=0
+#define ValI    4 // LD I: >=0
+#define ValP    5 // LD P: >=0
+static const char* const valNamePtr[]={"V", "n", "Iadj", "R", "I", "P"};
+
+// 0 when value is valid for field of node, -1 when not
+static int valueCheck(const nTy* node, int field, double value) {
+   if (!isfinite(value)) return -1;
+   switch (field) {
+      case ValVo:   return value>0 ? 0 : -1;
+      case ValN:    return (value>0 && value<=1) ? 0 : -1;
+      case ValIadj: return value>=0 ? 0 : -1;
+      case ValR:    if (node->type==4) return (value>0 && value<=MaxRsValue) ? 0 : -1;
+                    return value>=0 ? 0 : -1;
+      case ValI:
+      case ValP:    return value>=0 ? 0 : -1;
+   }
+   return -1;
+} // int valueCheck(const nTy* node, int field, double value)
+
+static const int tolVal[]={ValVo, ValN, ValIadj, ValR, ValI, ValP}; // by TolVo ... TolPi
+
+// take note of the tolerance of a value when there is one
+static int addTol(pbCtx* ctx, nTy* nPtr, int key, int field, int input, double nom) {
+   const char* strPtr=keyStr(ctx, key, NULL);
+   if (strPtr==NULL) return 0;
+   tolTy tol;
+   int ret=parseTol(strPtr, &tol);
+   if (ret<=0) return ret; // no tolerance or invalid
+   tol.node=nPtr;
+   tol.field=field;
+   tol.input=input;
+   tol.nom=nom;
+   if (valueCheck(nPtr, tolVal[field], tolBound(&tol, -1))!=0 || valueCheck(nPtr, tolVal[field], tolBound(&tol, 1))!=0) {
+      printf("Tolerance of:'%s' out of the valid values of node:'%s'\n", strPtr, nPtr->name);
+      return -1;
+   }
+   if (ctx->tolList.cnt==ctx->tolList.max) {
+      int max=ctx->tolList.max ? 2*ctx->tolList.max : 16;
+      tolTy* tolPtr=realloc(ctx->tolList.tol, max*sizeof(tolTy));
+      if (tolPtr==NULL) return -1;
+      ctx->tolList.tol=tolPtr;
+      ctx->tolList.max=max;
+   }
+   ctx->tolList.tol[ctx->tolList.cnt++]=tol;
+   return 0;
+} // int addTol(pbCtx* ctx, nTy* nPtr, int key, int field, int input, double nom)
+
+// take note of all tolerances of a node
+static int loadTol(pbCtx* ctx, nTy* nPtr) {
+   int ret=0;
+   switch (nPtr->type) {
+   case 0: // IN
+      ret|=addTol(ctx, nPtr, KeyV, TolVo, 0, *nPtr->Vo);
+      break;
+   case 1: // SR
+      if (nPtr->eff==NULL) // n from eff curve is a result
+         ret|=addTol(ctx, nPtr, KeyN, TolYeld, 0, *nPtr->yeld);
+      ret|=addTol(ctx, nPtr, KeyVo, TolVo, 0, *nPtr->Vo);
+      break;
+   case 2: // LR
+      ret|=addTol(ctx, nPtr, KeyIadj, TolIadj, 0, *nPtr->Iadj);
+      ret|=addTol(ctx, nPtr, KeyVo, TolVo, 0, *nPtr->Vo);
+      break;
+   case 4: // RS
+      ret|=addTol(ctx, nPtr, KeyR, TolR, 0, nPtr->R[0]);
+      break;
+   case 3: // LD
+      for (int i=0; i<nPtr->ins; i++) {
+         ret|=addTol(ctx, nPtr, SlotKey(i, SlotI), TolIi, i, nPtr->Ii[i]);
+         ret|=addTol(ctx, nPtr, SlotKey(i, SlotR), TolR, i, nPtr->R[i]);
+         ret|=addTol(ctx, nPtr, SlotKey(i, SlotP), TolPi, i, nPtr->Pi[i]);
+      }
+      break;
+   }
+   return ret;
+} // int loadTol(pbCtx* ctx, nTy* nPtr)
+
+// forget all load profiles
+static void profClear(pbCtx* ctx) {
+   for (int p=0; p<ctx->profList.cnt; p++) free(ctx->profList.prof[p].fileName);
+   ctx->profList.cnt=0;
+   return;
+} // void profClear(pbCtx* ctx)
+
+// take note of the load current profiles of a LD: "prof0=ld1.csv", binary
+// float or double arrays (.f32 .f64) need the sample time "dt0=1e-6".
+// Relative names start from the INI directory. Return profiles or -1
+static int loadProf(pbCtx* ctx, nTy* nPtr, const char* graphFile) {
+   int cnt=0;
+   for (int i=0; i<nPtr->ins; i++) {
+      const char* strPtr=keyStr(ctx, SlotKey(i, SlotProf), NULL);
+      if (strPtr==NULL || strPtr[0]=='\0') continue;
+      profTy prof;
+      prof.node=nPtr;
+      prof.input=i;
+      prof.kind=ProfF32;
+      const char* extPtr=strrchr(strPtr, '.');
+      if (extPtr && (!strcasecmp(extPtr, ".csv") || !strcasecmp(extPtr, ".txt"))) prof.kind=ProfCsv;
+      if (extPtr && !strcasecmp(extPtr, ".f64")) prof.kind=ProfF64;
+      prof.dt=keyNum(ctx, SlotKey(i, SlotDt), 0);
+      if (prof.kind!=ProfCsv && prof.dt<=0) {
+         printf("Binary profile:'%s' need dt%d>0\n", strPtr, i);
+         return -1;
+      }
+      const char* dirEndPtr=strrchr(graphFile, '/');
+      size_t dirLen=(strPtr[0]!='/' && dirEndPtr) ? (size_t)(dirEndPtr-graphFile+1) : 0;
+      prof.fileName=malloc(dirLen+strlen(strPtr)+1);
+      memcpy(prof.fileName, graphFile, dirLen);
+      strcpy(prof.fileName+dirLen, strPtr);
+      if (ctx->profList.cnt==ctx->profList.max) {
+         ctx->profList.max=ctx->profList.max ? 2*ctx->profList.max : 16;
+         ctx->profList.prof=realloc(ctx->profList.prof, ctx->profList.max*sizeof(profTy));
+      }
+      ctx->profList.prof[ctx->profList.cnt++]=prof;
+      cnt++;
+   }
+   return cnt;
+} // int loadProf(pbCtx* ctx, nTy* nPtr, const char* graphFile)
+
+// forget the battery of IN
+static void batClear(pbCtx* ctx) {
+   free(ctx->bat.soc.x); free(ctx->bat.soc.w); free(ctx->bat.soc.b);
+   free(ctx->bat.Voc);
+   memset(&ctx->bat, 0, sizeof(ctx->bat));
+   return;
+} // void batClear(pbCtx* ctx)
+
+// read the battery of IN: "Cap=2.6" Ah, discharge curve "SOC={0,0.1,1}" with
+// "Voc={3,3.5,4.2}" V, "Rint=0.05" ohm, "Vcut=3" V, "SOC0=1" at start and
+// "dt=1" s step without load profiles. No curve: Voc is V. No Cap: no battery.
+// Return 0 or -1 on error
+static int loadBat(pbCtx* ctx, nTy* nPtr) {
+   const int key[2]={KeySoc, KeyVoc};
+   double* v[2]={NULL, NULL}; // SOC, Voc
+   u16 cnt[2]={0, 0};
+   int ret=-1;
+   batClear(ctx);
+   ctx->bat.cap=keyNum(ctx, KeyCap, 0);
+   if (ctx->bat.cap==0) return 0;
+   ctx->bat.soc0=keyNum(ctx, KeySoc0, 1);
+   ctx->bat.Rint=keyNum(ctx, KeyRint, 0);
+   ctx->bat.Vcut=keyNum(ctx, KeyVcut, 0);
+   ctx->bat.dt=keyNum(ctx, KeyDt, 1);
+   for (int a=0; a<2; a++) {
+      if (ctx->keyVal[key[a]]==NULL) continue;
+      char* chPtr=strchr(ctx->keyVal[key[a]], '{');
+      if (chPtr==NULL || parseVector(chPtr+1, &v[a], &cnt[a])!=OK) goto done;
+   }
+   if (cnt[0]==0 && cnt[1]==0) { // flat curve at the IN voltage
+      static double flatSoc=0;
+      if (*nPtr->Vo<=0) goto done;
+      if (effAxis(&ctx->bat.soc, &flatSoc, 1)!=0) goto done;
+      ctx->bat.Voc=malloc(2*sizeof(double));
+      ctx->bat.Voc[0]=ctx->bat.Voc[1]=*nPtr->Vo;
+   } else {
+      if (cnt[0]==0 || cnt[0]!=cnt[1]) goto done;
+      for (int p=0; p<cnt[0]; p++) {
+         if (v[1][p]<=0 || v[0][p]<0 || v[0][p]>1) goto done;
+         if (p>0 && v[0][p]<=v[0][p-1]) goto done;
+      }
+      if (effAxis(&ctx->bat.soc, v[0], cnt[0])!=0) goto done;
+      ctx->bat.Voc=malloc((cnt[1]+1)*sizeof(double));
+      memcpy(ctx->bat.Voc, v[1], cnt[1]*sizeof(double));
+      ctx->bat.Voc[cnt[1]]=v[1][cnt[1]-1];
+   }
+   if (ctx->bat.cap<0 || ctx->bat.soc0<0 || ctx->bat.soc0>1 || ctx->bat.Rint<0 || ctx->bat.dt<=0) goto done;
+   if (ctx->bat.Vcut<0 || ctx->bat.Vcut>=batVoc(&ctx->bat, ctx->bat.soc0)) goto done;
+   if (*nPtr->Vo==0) *nPtr->Vo=batVoc(&ctx->bat, ctx->bat.soc0); // nominal calc at start
+   ret=0;
+   done:
+   free(v[0]);
+   free(v[1]);
+   return ret;
+} // int loadBat(pbCtx* ctx, nTy* nPtr)
+
+// take note of the thermal data of a node: "Rth=40" C/W junction to ambient,
+// "Ta=60" C ambient, else BOARD "Ta" or 25, "Tmax=125" C, "tc=-0.002" 1/C.
+// Nodes without any of them are not listed. Return 0 or -1 on error
+static int loadTherm(pbCtx* ctx, nTy* nPtr, double boardTa) {
+   const int key[4]={KeyRth, KeyTa, KeyTmax, KeyTc};
+   double val[4]={0, boardTa, 125, 0};
+   int found=0;
+   for (int v=0; v<4; v++) {
+      if (ctx->keyVal[key[v]]==NULL) continue;
+      val[v]=keyNum(ctx, key[v], 0);
+      found=1;
+   }
+   if (!found) return 0;
+   if (val[0]<0 || val[2]<=val[1]) return -1;
+   if (ctx->thermList.cnt==ctx->thermList.max) {
+      ctx->thermList.max=ctx->thermList.max ? 2*ctx->thermList.max : 16;
+      ctx->thermList.therm=realloc(ctx->thermList.therm, ctx->thermList.max*sizeof(thermTy));
+   }
+   thermTy* thPtr=&ctx->thermList.therm[ctx->thermList.cnt++];
+   thPtr->node=nPtr;
+   thPtr->Rth=val[0];
+   thPtr->Ta=val[1];
+   thPtr->Tmax=val[2];
+   thPtr->tc=val[3];
+   thPtr->Tj=val[1];
+   return 0;
+} // int loadTherm(pbCtx* ctx, nTy* nPtr, double boardTa)
+
+static void optClear(pbCtx* ctx) {
+   for (int o=0; o<ctx->optList.cnt; o++) {
+      free(ctx->optList.opt[o].val);
+      free(ctx->optList.opt[o].names);
+   }
+   ctx->optList.cnt=0;
+   return;
+} // void optClear(pbCtx* ctx)
+
+static optTy* optAdd(pbCtx* ctx, nTy* nPtr, int kind, int input) {
+   if (ctx->optList.cnt==ctx->optList.max) {
+      ctx->optList.max=ctx->optList.max ? 2*ctx->optList.max : 16;
+      ctx->optList.opt=realloc(ctx->optList.opt, ctx->optList.max*sizeof(optTy));
+   }
+   optTy* optPtr=&ctx->optList.opt[ctx->optList.cnt++];
+   memset(optPtr, 0, sizeof(optTy));
+   optPtr->node=nPtr;
+   optPtr->kind=kind;
+   optPtr->input=input;
+   return optPtr;
+} // optTy* optAdd(pbCtx* ctx, nTy* nPtr, int kind, int input)
+
+// take note of the alternatives of a node for optimize(): SR, LR output
+// voltages "Voopt={1.8,2.5}", SR "asLR=0.002" Iadj when built as LR, LR
+// "asSR=0.9" n when built as SR, "f0opt=LR2,SR1" other nodes that may feed
+// an input of LD or the input of SR, LR, RS. Return 0 or -1 on error
+static int loadOpt(pbCtx* ctx, nTy* nPtr) {
+   const char* strPtr;
+   if (nPtr->type==1 || nPtr->type==2) {
+      if (ctx->keyVal[KeyVoopt]!=NULL) {
+         double* v=NULL;
+         u16 cnt=0;
+         char* chPtr=strchr(ctx->keyVal[KeyVoopt], '{');
+         int bad=(chPtr==NULL || parseVector(chPtr+1, &v, &cnt)!=OK || cnt==0);
+         for (int c=0; !bad && c<cnt; c++) bad=(v[c]<=0);
+         if (bad) { free(v); return -1; }
+         optTy* optPtr=optAdd(ctx, nPtr, OptVo, 0);
+         optPtr->cnt=cnt;
+         optPtr->val=v;
+      }
+      int key=(nPtr->type==1) ? KeyAsLR : KeyAsSR;
+      if (ctx->keyVal[key]!=NULL) {
+         double v=keyNum(ctx, key, -1);
+         if (v<0 || (nPtr->type==2 && (v==0 || v>1))) return -1; // Iadj>=0, 0<n<=1
+         optTy* optPtr=optAdd(ctx, nPtr, OptType, 0);
+         optPtr->cnt=1;
+         optPtr->val=malloc(sizeof(double));
+         optPtr->val[0]=v;
+      }
+   }
+   int ins=(nPtr->type==3) ? nPtr->ins : 1; // SR, LR, RS only f0
+   for (int i=0; i<ins; i++) {
+      strPtr=keyStr(ctx, SlotKey(i, SlotFopt), NULL);
+      if (strPtr==NULL) continue;
+      if (nPtr->in[i][0]=='\0' || strPtr[0]=='\0') return -1; // no input to move
+      optTy* optPtr=optAdd(ctx, nPtr, OptFeed, i);
+      optPtr->names=malloc(strlen(strPtr)+1);
+      strcpy(optPtr->names, strPtr);
+      optPtr->cnt=1;
+      for (const char* chPtr=strPtr; *chPtr; chPtr++) optPtr->cnt+=(*chPtr==',');
+   }
+   return 0;
+} // int loadOpt(pbCtx* ctx, nTy* nPtr)
+
+// clear the data a load fill, the nodes are cleared by nListInit()
+static void loadClear(pbCtx* ctx) {
+   freePlan(&ctx->plan);
+   ctx->tolList.cnt=0;
+   ctx->thermList.cnt=0;
+   optClear(ctx);
+   profClear(ctx);
+   batClear(ctx);
+   return;
+} // void loadClear(pbCtx* ctx)
+
+// load stages: pbParseINI() ==> pbResolveNodes() ==> pbValidateNodes(), the
+// design is then ready to compile and calc. The GUI placement is the last
+// stage pbLayoutNodes(), called only by who need col/row
+int pbLoadINI(pbCtx* ctx, char* graphFile) {
+   size_t nameLen=strlen(graphFile);
+   if (nameLen>4 && !strcasecmp(graphFile+nameLen-4, ".pbc")) { // compiled
+      loadClear(ctx);
+      return pbLoadPBC(ctx, graphFile);
+   }
+   if (pbParseINI(ctx, graphFile)!=0) return -1;
+   if (pbResolveNodes(ctx)!=0) return -1;
+   if (pbValidateNodes(ctx)!=0) return -1;
+   return 0;
+} // int pbLoadINI(pbCtx* ctx, char* graphFile)
+
+// read INI file and fill a node by section with its checked values. Inputs
+// are kept by name in nTy in, linked by pbResolveNodes()
+int pbParseINI(pbCtx* ctx, char* graphFile) {
+   loadClear(ctx);
    // parse ini file
-   graphPtr=iniparser_load(graphFile);
-   if (graphPtr==NULL) {
+   if (iniRead(graphFile, &ctx->ini)!=OK) {
       printf("Cannot open and parse file:'%s'. Quit\n", graphFile);
       return -1;
    }
-   int sect=iniparser_getnsec(graphPtr);
+   int sect=ctx->ini.sects;
    //printf("sect:%d\n", sect);
    if (sect<3) { // INI sections
       printf("Too few sections in file. Quit\n");
@@ -105,10 +956,11 @@ int loadINI(char* graphFile) {
 
    // check needed sections/nodes
    int board=0; int in=0; int sr=0; int lr=0; int rs=0; int ld=0;
+   int boardSect=-1;
    for (int s=0; s<sect; s++) { // INI sections = # nodes
-      const char* sectNamePtr=iniparser_getsecname(graphPtr, s);
+      const char* sectNamePtr=ctx->ini.sect[s].name;
       //printf("s:%d name:'%s'\n", s, sectNamePtr);
-      if (strcasecmp(sectNamePtr, "board")==0) board++;
+      if (strcasecmp(sectNamePtr, "board")==0) { board++; boardSect=s; }
       if (strcasecmp(sectNamePtr, "in")==0) in++;
       char noPtr[3];
       strncpy(noPtr, sectNamePtr, 2); noPtr[2]='\0';
@@ -116,8 +968,6 @@ int loadINI(char* graphFile) {
       if (strcasecmp(noPtr, "lr")==0) lr++;
       if (strcasecmp(noPtr, "rs")==0) rs++;
       if (strcasecmp(noPtr, "ld")==0) ld++;
-      iniparser_getsecnkeys(graphPtr, sectNamePtr);
-      //printf("keys:%d\n", keys);
    }
    if (board==0) {
       printf("Missing BOARD section in file. Quit\n");
@@ -139,107 +989,103 @@ int loadINI(char* graphFile) {
       printf("Missing LD1 section in file. Quit\n");
       return -1;
    }
-   printf("INI file:'%s'\n", graphFile);
-   printf("BOARD in file:'%s'\n", iniparser_getstring(graphPtr, "BOARD:label", ""));
-   printf("Input in file:%d\n", in);
-   printf("Switching Regulators in file:%d\n", sr);
-   printf("Linear Regulators in file:%d\n", lr);
-   printf("Resistor serie in file:%d\n", rs);
-   printf("Loads in file:%d\n", ld);
    int nt=in+sr+lr+rs+ld;
-   printf("Tot Sections:%d Nodes:%d\n", sect, nt);
-   //printf("Tot Nodes:%d\n", nt);
-   printf("\n");
+   if (PbLev(ctx)>=PRINTF) {
+      printf("INI file:'%s'\n", graphFile);
+      const char* labelPtr=iniGet(&ctx->ini, boardSect, "label");
+      printf("BOARD in file:'%s'\n", labelPtr ? labelPtr : "");
+      printf("Input in file:%d\n", in);
+      printf("Switching Regulators in file:%d\n", sr);
+      printf("Linear Regulators in file:%d\n", lr);
+      printf("Resistor serie in file:%d\n", rs);
+      printf("Loads in file:%d\n", ld);
+      printf("Tot Sections:%d Nodes:%d\n", sect, nt);
+      //printf("Tot Nodes:%d\n", nt);
+      printf("\n");
+   }
 
    // allocate space for nodes
    //nPtr = malloc((nt+1)*sizeof(nTy)); // keep space for BOARD in [0]
    // init an empty node list, needed to support GUI
-   nListInit(&nList);
+   nListInit(&ctx->nList);
 
    // 1st pass, fill struct with file data and check valid values
+   const char* boardTaPtr=iniGet(&ctx->ini, boardSect, "Ta");
+   double boardTa=boardTaPtr ? strtod(boardTaPtr, NULL) : TcRef;
    nTy* nPtr;
    for (int s=0; s<sect; s++) { // INI sections = # nodes
       //printf("s:%d\n", s);
-      const char* sectNamePtr=iniparser_getsecname(graphPtr, s);
-      nPtr=nListAdd(&nList);
+      const char* sectNamePtr=ctx->ini.sect[s].name;
+      if (nListFind(&ctx->nList, sectNamePtr)!=NULL) {
+         printf("Node:'%s' twice in file. Quit\n", sectNamePtr);
+         return -1;
+      }
+      nPtr=nListAdd(&ctx->nList);
+      int ins=sectKeys(ctx, s); // keys of the section in one pass
+      if (ins<0) return -1;
+      if (nPtr==NULL || nListName(&ctx->nList, nPtr, sectNamePtr)!=0) {
+         printf("No memory for node:'%s'. Quit\n", sectNamePtr);
+         return -1;
+      }
       if (strcasecmp(sectNamePtr, "board")==0) { // BOARD only
-         strcpy(nPtr->name, sectNamePtr);
          nPtr->type=-1;
-         strcpy(nPtr->label, iniparser_getstring(graphPtr, "BOARD:label", ""));
-         strcpy(nPtr->refdes, "");
-         nPtr->col=-1;
-         nPtr->row=-1;
-         for (int i=0; i<MaxIns; i++) {
-            nPtr->from[i]=NULL;
-            strcpy(nPtr->in[i], "");
+         snprintf(nPtr->label, sizeof(nPtr->label), "%s", keyStr(ctx, KeyLabel, ""));
+         snprintf(nPtr->refdes, sizeof(nPtr->refdes), "%s", "");
+         for (int i=0; i<nPtr->ins; i++) {
+            nPtr->from[i]=-1;
+            nPtr->in[i]="";
             nPtr->Vi[i]=0;
             nPtr->Ii[i]=0;
             nPtr->Pi[i]=0;
             nPtr->R[i]=0;
          }
-         nPtr->yeld=0;
-         nPtr->Iadj=0;
-         nPtr->DV=0;
-         nPtr->Pd=0;
-         nPtr->Vo=0;
-         nPtr->Io=0;
-         nPtr->Po=0;
-         for (int t=0; t<MaxOut; t++) {
-            nPtr->to[t]=NULL;
-         }
+         *nPtr->yeld=0;
+         *nPtr->Iadj=0;
+         *nPtr->DV=0;
+         *nPtr->Pd=0;
+         *nPtr->Vo=0;
+         *nPtr->Io=0;
+         *nPtr->Po=0;
          nPtr->out=0;
       } // BOARD only
 
       if (strcasecmp(sectNamePtr, "in")==0) { // IN only
-         strcpy(nPtr->name, sectNamePtr);
          nPtr->type=0;
-         strcpy(nPtr->label, iniparser_getstring(graphPtr, "IN:label", ""));
-         strcpy(nPtr->refdes, "");
-         nPtr->col=-1;
-         nPtr->row=-1;
-         for (int i=0; i<MaxIns; i++) {
-            nPtr->from[i]=NULL;
-            strcpy(nPtr->in[i], "");
+         snprintf(nPtr->label, sizeof(nPtr->label), "%s", keyStr(ctx, KeyLabel, ""));
+         snprintf(nPtr->refdes, sizeof(nPtr->refdes), "%s", "");
+         for (int i=0; i<nPtr->ins; i++) {
+            nPtr->from[i]=-1;
+            nPtr->in[i]="";
             nPtr->Vi[i]=0;
             nPtr->Ii[i]=0;
             nPtr->Pi[i]=0;
             nPtr->R[i]=0;
          }
-         nPtr->yeld=0;
-         nPtr->Iadj=0;
-         nPtr->DV=0;
-         nPtr->Pd=0;
-         nPtr->Vo=iniparser_getdouble(graphPtr, "IN:V", 0);
-         nPtr->Io=iniparser_getdouble(graphPtr, "IN:I", 0);
-         nPtr->Po=iniparser_getdouble(graphPtr, "IN:P", 0);
-         for (int t=0; t<MaxOut; t++) {
-            nPtr->to[t]=NULL;
-         }
+         *nPtr->yeld=0;
+         *nPtr->Iadj=0;
+         *nPtr->DV=0;
+         *nPtr->Pd=0;
+         *nPtr->Vo=keyNum(ctx, KeyV, 0);
+         *nPtr->Io=keyNum(ctx, KeyI, 0);
+         *nPtr->Po=keyNum(ctx, KeyP, 0);
          nPtr->out=0;
-         if (nPtr->Vo==0) {
-            printf("Invalid input for IN. Quit\n");
+         if (loadBat(ctx, nPtr)!=0) {
+            printf("Invalid battery for IN. Quit\n");
             return -1;
          }
-         for (int t=0; t<MaxOut; t++) {
-            nPtr->to[t]=NULL;
+         if (*nPtr->Vo==0) {
+            printf("Invalid input for IN. Quit\n");
+            return -1;
          }
-         nPtr->out=0;
       } // IN only
 
       char sectTypePtr[3]="";
       strncpy(sectTypePtr, sectNamePtr, 2); sectTypePtr[2]='\0';
-      char sectKeyPtr[15]="";
       if (strcasecmp(sectTypePtr, "sr")==0) { // SR only
-         strcpy(nPtr->name, sectNamePtr);
          nPtr->type=1;
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":label");
-         strcpy(nPtr->label, iniparser_getstring(graphPtr, sectKeyPtr, ""));
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":refdes");
-         strcpy(nPtr->refdes, iniparser_getstring(graphPtr, sectKeyPtr, ""));
-         nPtr->col=-1;
-         nPtr->row=-1;
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":f0");
-         const char* strPtr=iniparser_getstring(graphPtr, sectKeyPtr, NULL);
+         snprintf(nPtr->label, sizeof(nPtr->label), "%s", keyStr(ctx, KeyLabel, ""));
+         snprintf(nPtr->refdes, sizeof(nPtr->refdes), "%s", keyStr(ctx, KeyRefdes, ""));
+         const char* strPtr=keyStr(ctx, SlotKey(0, SlotF), NULL);
          if (strPtr==NULL) {
             printf("Node:'%s' from:NULL. Quit\n", sectNamePtr);
             return -1;
@@ -250,58 +1096,52 @@ int loadINI(char* graphFile) {
             printf("Node:'%s' from:LDn. Quit\n", sectNamePtr);
             return -1;
          }
-         nPtr->from[0]=NULL;
-         strcpy(nPtr->in[0], strPtr);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Vi");
-         nPtr->Vi[0]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Ii");
-         nPtr->Ii[0]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Pi");
-         nPtr->Pi[0]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":R");
-         nPtr->R[0]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         for (int i=1; i<MaxIns; i++) {
-            nPtr->from[i]=NULL;
-            strcpy(nPtr->in[i], "");
+         nPtr->from[0]=-1;
+         nPtr->in[0]=nListIntern(&ctx->nList, strPtr);
+         if (nPtr->in[0]==NULL) {
+            printf("No memory for node:'%s'. Quit\n", sectNamePtr);
+            return -1;
+         }
+         nPtr->Vi[0]=keyNum(ctx, KeyVi, 0);
+         nPtr->Ii[0]=keyNum(ctx, KeyIi, 0);
+         nPtr->Pi[0]=keyNum(ctx, KeyPi, 0);
+         nPtr->R[0]=keyNum(ctx, KeyR, 0);
+         for (int i=1; i<nPtr->ins; i++) {
+            nPtr->from[i]=-1;
+            nPtr->in[i]="";
             nPtr->Vi[i]=0;
             nPtr->Ii[i]=0;
             nPtr->Pi[i]=0;
             nPtr->R[i]=0;
          }
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":n");
-         nPtr->yeld=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         nPtr->Iadj=0;
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":DV");
-         nPtr->DV=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Pd");
-         nPtr->Pd=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Vo");
-         nPtr->Vo=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Io");
-         nPtr->Io=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Po");
-         nPtr->Po=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         for (int t=0; t<MaxOut; t++) {
-            nPtr->to[t]=NULL;
+         *nPtr->yeld=keyNum(ctx, KeyN, 0);
+         strPtr=keyStr(ctx, KeyEff, NULL);
+         if (strPtr!=NULL) { // n depend on load, replace the constant yeld
+            nPtr->eff=effParse(strPtr);
+            if (nPtr->eff==NULL) {
+               printf("Invalid eff for SR:'%s'. Quit\n", sectNamePtr);
+               return -1;
+            }
          }
+         *nPtr->Iadj=0;
+         *nPtr->DV=keyNum(ctx, KeyDV, 0);
+         nPtr->DVmin=keyNum(ctx, KeyDVmin, 0);
+         *nPtr->Pd=keyNum(ctx, KeyPd, 0);
+         *nPtr->Vo=keyNum(ctx, KeyVo, 0);
+         *nPtr->Io=keyNum(ctx, KeyIo, 0);
+         *nPtr->Po=keyNum(ctx, KeyPo, 0);
          nPtr->out=0;
-         if (nPtr->Vo==0) {
+         if (*nPtr->Vo==0) {
             printf("Invalid input for SR:'%s'. Quit\n", sectNamePtr);
             return -1;
          }
       } // SR only
 
       if (strcasecmp(sectTypePtr, "lr")==0) { // LR only
-         strcpy(nPtr->name, sectNamePtr);
          nPtr->type=2;
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":label");
-         strcpy(nPtr->label, iniparser_getstring(graphPtr, sectKeyPtr, ""));
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":refdes");
-         strcpy(nPtr->refdes, iniparser_getstring(graphPtr, sectKeyPtr, ""));
-         nPtr->col=-1;
-         nPtr->row=-1;
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":f0");
-         const char* strPtr=iniparser_getstring(graphPtr, sectKeyPtr, NULL);
+         snprintf(nPtr->label, sizeof(nPtr->label), "%s", keyStr(ctx, KeyLabel, ""));
+         snprintf(nPtr->refdes, sizeof(nPtr->refdes), "%s", keyStr(ctx, KeyRefdes, ""));
+         const char* strPtr=keyStr(ctx, SlotKey(0, SlotF), NULL);
          if (strPtr==NULL) {
             printf("Node:'%s' from:NULL. Quit\n", sectNamePtr);
             return -1;
@@ -312,60 +1152,45 @@ int loadINI(char* graphFile) {
             printf("Node:'%s' from:LDn. Quit\n", sectNamePtr);
             return -1;
          }
-         nPtr->from[0]=NULL;
-         strcpy(nPtr->in[0], strPtr);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Vi");
-         nPtr->Vi[0]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Ii");
-         nPtr->Ii[0]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Pi");
-         nPtr->Pi[0]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":R");
-         nPtr->R[0]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         for (int i=1; i<MaxIns; i++) {
-            nPtr->from[i]=NULL;
-            strcpy(nPtr->in[i], "");
+         nPtr->from[0]=-1;
+         nPtr->in[0]=nListIntern(&ctx->nList, strPtr);
+         if (nPtr->in[0]==NULL) {
+            printf("No memory for node:'%s'. Quit\n", sectNamePtr);
+            return -1;
+         }
+         nPtr->Vi[0]=keyNum(ctx, KeyVi, 0);
+         nPtr->Ii[0]=keyNum(ctx, KeyIi, 0);
+         nPtr->Pi[0]=keyNum(ctx, KeyPi, 0);
+         nPtr->R[0]=keyNum(ctx, KeyR, 0);
+         for (int i=1; i<nPtr->ins; i++) {
+            nPtr->from[i]=-1;
+            nPtr->in[i]="";
             nPtr->Vi[i]=0;
             nPtr->Ii[i]=0;
             nPtr->Pi[i]=0;
             nPtr->R[i]=0;
          }
-         nPtr->yeld=0;
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Iadj");
-         nPtr->Iadj=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":DV");
-         nPtr->DV=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Pd");
-         nPtr->Pd=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":n");
-         nPtr->yeld=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Vo");
-         nPtr->Vo=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Io");
-         nPtr->Io=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Po");
-         nPtr->Po=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         for (int t=0; t<MaxOut; t++) {
-            nPtr->to[t]=NULL;
-         }
+         *nPtr->yeld=0;
+         *nPtr->Iadj=keyNum(ctx, KeyIadj, 0);
+         *nPtr->DV=keyNum(ctx, KeyDV, 0);
+         nPtr->DVmin=keyNum(ctx, KeyDVmin, 0);
+         *nPtr->Pd=keyNum(ctx, KeyPd, 0);
+         *nPtr->yeld=keyNum(ctx, KeyN, 0);
+         *nPtr->Vo=keyNum(ctx, KeyVo, 0);
+         *nPtr->Io=keyNum(ctx, KeyIo, 0);
+         *nPtr->Po=keyNum(ctx, KeyPo, 0);
          nPtr->out=0;
-         if (nPtr->Vo==0) {
+         if (*nPtr->Vo==0) {
             printf("Invalid input for LR:'%s', miss Vo. Quit\n", sectNamePtr);
             return -1;
          }
       } // LR only
 
       if (strcasecmp(sectTypePtr, "rs")==0) { // RS only
-         strcpy(nPtr->name, sectNamePtr);
          nPtr->type=4;
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":label");
-         strcpy(nPtr->label, iniparser_getstring(graphPtr, sectKeyPtr, ""));
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":refdes");
-         strcpy(nPtr->refdes, iniparser_getstring(graphPtr, sectKeyPtr, ""));
-         nPtr->col=-1;
-         nPtr->row=-1;
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":f0");
-         const char* strPtr=iniparser_getstring(graphPtr, sectKeyPtr, NULL);
+         snprintf(nPtr->label, sizeof(nPtr->label), "%s", keyStr(ctx, KeyLabel, ""));
+         snprintf(nPtr->refdes, sizeof(nPtr->refdes), "%s", keyStr(ctx, KeyRefdes, ""));
+         const char* strPtr=keyStr(ctx, SlotKey(0, SlotF), NULL);
          if (strPtr==NULL) {
             printf("Node:'%s' from:NULL. Quit\n", sectNamePtr);
             return -1;
@@ -376,39 +1201,31 @@ int loadINI(char* graphFile) {
             printf("Node:'%s' from:LDn. Quit\n", sectNamePtr);
             return -1;
          }
-         nPtr->from[0]=NULL;
-         strcpy(nPtr->in[0], strPtr);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Vi");
-         nPtr->Vi[0]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Ii");
-         nPtr->Ii[0]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Pi");
-         nPtr->Pi[0]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":R");
-         nPtr->R[0]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         for (int i=1; i<MaxIns; i++) {
-            nPtr->from[i]=NULL;
-            strcpy(nPtr->in[i], "");
+         nPtr->from[0]=-1;
+         nPtr->in[0]=nListIntern(&ctx->nList, strPtr);
+         if (nPtr->in[0]==NULL) {
+            printf("No memory for node:'%s'. Quit\n", sectNamePtr);
+            return -1;
+         }
+         nPtr->Vi[0]=keyNum(ctx, KeyVi, 0);
+         nPtr->Ii[0]=keyNum(ctx, KeyIi, 0);
+         nPtr->Pi[0]=keyNum(ctx, KeyPi, 0);
+         nPtr->R[0]=keyNum(ctx, KeyR, 0);
+         for (int i=1; i<nPtr->ins; i++) {
+            nPtr->from[i]=-1;
+            nPtr->in[i]="";
             nPtr->Vi[i]=0;
             nPtr->Ii[i]=0;
             nPtr->Pi[i]=0;
             nPtr->R[i]=0;
          }
-         nPtr->yeld=0;
-         nPtr->Iadj=0;
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":DV");
-         nPtr->DV=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Pd");
-         nPtr->Pd=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Vo");
-         nPtr->Vo=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Io");
-         nPtr->Io=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":Po");
-         nPtr->Po=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         for (int t=0; t<MaxOut; t++) {
-            nPtr->to[t]=NULL;
-         }
+         *nPtr->yeld=0;
+         *nPtr->Iadj=0;
+         *nPtr->DV=keyNum(ctx, KeyDV, 0);
+         *nPtr->Pd=keyNum(ctx, KeyPd, 0);
+         *nPtr->Vo=keyNum(ctx, KeyVo, 0);
+         *nPtr->Io=keyNum(ctx, KeyIo, 0);
+         *nPtr->Po=keyNum(ctx, KeyPo, 0);
          nPtr->out=0;
          if (nPtr->R[0]==0) {
             printf("Invalid input for RS:'%s', miss R. Quit\n", sectNamePtr);
@@ -421,28 +1238,23 @@ int loadINI(char* graphFile) {
       } // RS only
 
       if (strcasecmp(sectTypePtr,"ld")==0) { // LD only
-         strcpy(nPtr->name, sectNamePtr);
          nPtr->type=3;
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":label");
-         strcpy(nPtr->label, iniparser_getstring(graphPtr, sectKeyPtr, ""));
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":refdes");
-         strcpy(nPtr->refdes, iniparser_getstring(graphPtr, sectKeyPtr, ""));
-         nPtr->col=-1;
-         nPtr->row=-1;
-         for (int i=0; i<MaxIns; i++) {
+         snprintf(nPtr->label, sizeof(nPtr->label), "%s", keyStr(ctx, KeyLabel, ""));
+         snprintf(nPtr->refdes, sizeof(nPtr->refdes), "%s", keyStr(ctx, KeyRefdes, ""));
+         if (nListInputs(&ctx->nList, nPtr, ins)!=0) {
+            printf("No memory for LD:'%s' inputs:%d. Quit\n", sectNamePtr, ins);
+            return -1;
+         }
+         for (int i=0; i<nPtr->ins; i++) {
             //printf("i:%d\n", i);
-            char snPtr[2];
-            sprintf(snPtr, "%d", i);
-            strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":f"); strcat(sectKeyPtr, snPtr);
-            //printf("NodeKey:'%s'\n", sectKeyPtr);
-            const char* strPtr=iniparser_getstring(graphPtr, sectKeyPtr, NULL);
+            const char* strPtr=keyStr(ctx, SlotKey(i, SlotF), NULL);
             if (strPtr==NULL && i==0) { // at least one input from needed
                printf("Node:'%s' from:NULL. Quit\n", sectNamePtr);
                return -1;
             }
             if (strPtr==NULL) { // at least one input from
-               nPtr->from[i]=NULL;
-               strcpy(nPtr->in[i], "");
+               nPtr->from[i]=-1;
+               nPtr->in[i]="";
                nPtr->Vi[i]=0;
                nPtr->Ii[i]=0;
                nPtr->Pi[i]=0;
@@ -457,250 +1269,400 @@ int loadINI(char* graphFile) {
                printf("Node:'%s' from:LDn. Quit\n", sectNamePtr);
                return -1;
             }
-            nPtr->from[i]=NULL;
-            strcpy(nPtr->in[i], strPtr);
-            strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":V"); strcat(sectKeyPtr, snPtr);
-            nPtr->Vi[i]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-            strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":I"); strcat(sectKeyPtr, snPtr);
-            nPtr->Ii[i]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-            strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":P"); strcat(sectKeyPtr, snPtr);
-            nPtr->Pi[i]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-            strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":R"); strcat(sectKeyPtr, snPtr);
-            nPtr->R[i]=iniparser_getdouble(graphPtr, sectKeyPtr, 0);
-         }
-         nPtr->yeld=0;
-         nPtr->Iadj=0;
-         nPtr->DV=0;
-         nPtr->Pd=0;
-         nPtr->Vo=0;
-         nPtr->Io=0;
-         nPtr->Po=0;
-         for (int t=0; t<MaxOut; t++) {
-            nPtr->to[t]=NULL;
+            nPtr->from[i]=-1;
+            nPtr->in[i]=nListIntern(&ctx->nList, strPtr);
+            if (nPtr->in[i]==NULL) {
+               printf("No memory for node:'%s'. Quit\n", sectNamePtr);
+               return -1;
+            }
+            nPtr->Vi[i]=keyNum(ctx, SlotKey(i, SlotV), 0);
+            nPtr->Ii[i]=keyNum(ctx, SlotKey(i, SlotI), 0);
+            nPtr->Pi[i]=keyNum(ctx, SlotKey(i, SlotP), 0);
+            nPtr->R[i]=keyNum(ctx, SlotKey(i, SlotR), 0);
          }
+         *nPtr->yeld=0;
+         *nPtr->Iadj=0;
+         *nPtr->DV=0;
+         *nPtr->Pd=0;
+         *nPtr->Vo=0;
+         *nPtr->Io=0;
+         *nPtr->Po=0;
          nPtr->out=0;
-         if (nPtr->Ii[0]==0 && nPtr->Pi[0]==0 && nPtr->R[0]==0) {
+         int profs=loadProf(ctx, nPtr, graphFile);
+         if (profs<0) {
+            printf("Invalid profile for LD:'%s'. Quit\n", sectNamePtr);
+            return -1;
+         }
+         if (nPtr->Ii[0]==0 && nPtr->Pi[0]==0 && nPtr->R[0]==0 && profs==0) {
             printf("Invalid input for LD:'%s'. Quit\n", sectNamePtr);
             return -1;
          }
       } // LD only
+
+      if (loadTol(ctx, nPtr)!=0) {
+         printf("Invalid tolerance in:'%s'. Quit\n", sectNamePtr);
+         return -1;
+      }
+      if (nPtr->type>0 && loadTherm(ctx, nPtr, boardTa)!=0) {
+         printf("Invalid thermal data in:'%s'. Quit\n", sectNamePtr);
+         return -1;
+      }
+      if (nPtr->type>0 && loadOpt(ctx, nPtr)!=0) {
+         printf("Invalid design alternative in:'%s'. Quit\n", sectNamePtr);
+         return -1;
+      }
    } // for (int s=0; s<sect; s++) { // INI sections = # nodes
+   return 0;
+} // int pbParseINI(pbCtx* ctx, char* graphFile)
 
-   // 2nd pass to check from names and fill ptrs
+// check the input names of the nodes and link them, names found by hash
+int pbResolveNodes(pbCtx* ctx) {
+   int sect=ctx->nList.nodeCnt;
    //printf("2nd pass ...\n");
-   nPtr=nList.first;
-   for (int s=0; s<sect; s++, nPtr=nPtr->next) { // INI sections = # nodes
+   nTy* nPtr=nListFirst(&ctx->nList);
+   for (int s=0; s<sect; s++, nPtr=nListNext(&ctx->nList, nPtr)) { // INI sections = # nodes
       //printf("node:'%s'\n", nPtr->name);
       //printf("type:'%d'\n", nPtr->type);
       if (nPtr->type == 0 || nPtr->type == -1) continue; // skip BOARD & IN
-      const char* sectNamePtr=iniparser_getsecname(graphPtr, s);
-      char sectKeyPtr[10];
-      for (int i=0; i<MaxIns; i++) {
+      for (int i=0; i<nPtr->ins; i++) {
          //printf("i:%d\n", i);
-         char snPtr[2];
-         sprintf(snPtr, "%d", i);
-         strcpy(sectKeyPtr, sectNamePtr); strcat(sectKeyPtr, ":f"); strcat(sectKeyPtr, snPtr);
-         //printf("NodeKey:'%s'\n", sectKeyPtr);
-         const char* strPtr=iniparser_getstring(graphPtr, sectKeyPtr, NULL);
-         if (strPtr==NULL && i==0) { // at least one input from
-            printf("Node:'%s' from:NULL. Quit\n", sectNamePtr);
+         const char* strPtr=nPtr->in[i]; // fx key read by the 1st pass
+         if (strPtr[0]=='\0' && i==0) { // at least one input from
+            printf("Node:'%s' from:NULL. Quit\n", nPtr->name);
             return -1;
          }
-         if (strPtr==NULL) {
-            //printf("Node:'%s' continue\n", sectNamePtr);
+         if (strPtr[0]=='\0') {
+            //printf("Node:'%s' continue\n", nPtr->name);
             continue;
          }
          //printf("search from strPtr:'%s'\n", strPtr);
-         if (strcasecmp(strPtr, sectNamePtr)==0) {
-            printf("Node:'%s' from itself. Quit\n", sectNamePtr);
+         if (strcasecmp(strPtr, nPtr->name)==0) {
+            printf("Node:'%s' from itself. Quit\n", nPtr->name);
             return -1;
          }
-         char noPtr[3];
-         strncpy(noPtr, strPtr, 2); noPtr[2]='\0';
-         if (strcasecmp(noPtr, "ld")==0) {
-            printf("Node:'%s' from:LDn. Quit\n", sectNamePtr);
+         if (strncasecmp(strPtr, "ld", 2)==0) {
+            printf("Node:'%s' from:LDn. Quit\n", nPtr->name);
             return -1;
          }
-         int srcOK=0;
-         nTy* nodePtr=nList.first;
-         for (int n=0; n<sect; n++, nodePtr=nodePtr->next) { // check in all section if exist
-            const char* nodeNamePtr=iniparser_getsecname(graphPtr, n);
-            //printf("check nodeNamePtr:'%s'\n", nodeNamePtr);
-            if (strcasecmp(strPtr, nodeNamePtr)==0) {
-               //printf("Node:'%s' from:'%s' found\n", nPtr->name, strPtr);
-               srcOK=1;
-               nPtr->from[i]=nodePtr;
-               // now fill to[] of from node: nPtr
-               for (int t=0; t<MaxOut; t++) { // find first free
-                  if (nodePtr->to[t]!=NULL) continue;
-                  //printf("fill t:%d\n", t);
-                  nodePtr->to[t]=nPtr;
-                  break;
-               }
-               break;
-            }
-         }
-         //printf("srcOK:%d\n", srcOK);
-         if (srcOK==0) {
+         nTy* nodePtr=nListFind(&ctx->nList, strPtr);
+         if (nodePtr==NULL) {
             printf("Node:'%s' from:'%s' not found. Quit\n", nPtr->name, strPtr);
             return -1;
          }
+         nPtr->from[i]=nodePtr->ix;
       }
    }
    //printf("\n");
+   return 0;
+} // int pbResolveNodes(pbCtx* ctx)
 
-   // 3rd pass to discover max depth and load input valuess
-   //printf("3rd pass, discover max depth ...\n");
-   int md=0;
-   int ml=0;
-   nPtr=nList.first;
-   for (int s=0; s<sect; s++, nPtr=nPtr->next) { // INI sections = # nodes
-      if (nPtr->type!=3) continue; // only LDx
-      //printf("s:%d node:'%s'\n", s, nPtr->name);
-      int d=0;
-      for (int i=0; i<MaxIns; i++) { // for every load input
-         d=0;
-         //printf("input i:%d\n", i);
-         if (nPtr->from[i]!=NULL) {
-            ml++;
-            nTy* from=nPtr->from[i];
-            //printf("from:%p\n", from);
-            int type=from->type;
-            //printf("type:%d\n", type);
-            while (type!=0) { // up to IN
-               d++;
-               //printf("col:%d row:%d node:'%s' type:%d \n", d, ml, from->name, from->type);
-               from=from->from[0];
-               type=from->type;
-            }
-            //printf("col:%d row:%d node:'%s' type:%d\n", d, ml, from->name, from->type);
-         }
-         if (d>md) md=d; // new max depth
-      } // for (int i=0; i<MaxIns; i++)
-   } // for (int s=0; s<sect; s++)
-   md++; ml--;
-   //printf("md:%d ml:%d\n", md, ml);
-   int cols=md+1, rows=ml+1;
-   printf("cols:%d lines:%d\n", cols, rows);
-   printf("\n");
+// check the values of a node as loaded, print the first invalid one
+static int nodeCheck(const nTy* nPtr) {
+   int field=-1, input=-1;
+   double value=0;
+   if (nPtr->type>=0 && nPtr->type<=2 && valueCheck(nPtr, ValVo, *nPtr->Vo)!=0) { field=ValVo; value=*nPtr->Vo; }
+   else if (nPtr->type==1 && nPtr->eff==NULL && valueCheck(nPtr, ValN, *nPtr->yeld)!=0) { field=ValN; value=*nPtr->yeld; }
+   else if (nPtr->type==2 && valueCheck(nPtr, ValIadj, *nPtr->Iadj)!=0) { field=ValIadj; value=*nPtr->Iadj; }
+   else if (nPtr->type==4 && valueCheck(nPtr, ValR, nPtr->R[0])!=0) { field=ValR; value=nPtr->R[0]; }
+   else if (nPtr->type==3) {
+      for (int i=0; i<nPtr->ins && field<0; i++) {
+         if (nPtr->from[i]<0) continue;
+         input=i;
+         if (valueCheck(nPtr, ValI, nPtr->Ii[i])!=0) { field=ValI; value=nPtr->Ii[i]; }
+         else if (valueCheck(nPtr, ValP, nPtr->Pi[i])!=0) { field=ValP; value=nPtr->Pi[i]; }
+         else if (valueCheck(nPtr, ValR, nPtr->R[i])!=0) { field=ValR; value=nPtr->R[i]; }
+      }
+   }
+   if (field<0) return 0;
+   if (input>=0) printf("Invalid %s%d:%g of node:'%s'. Quit\n", valNamePtr[field], input, value, nPtr->name);
+   else printf("Invalid %s:%g of node:'%s'. Quit\n", valNamePtr[field], value, nPtr->name);
+   return -1;
+} // int nodeCheck(const nTy* nPtr)
 
-   // 4th pass, graph exploration and fill
-   //printf("graph exploration and fill\n");
-   int c=0;
-   int r=0;
-   nPtr=nList.first;
-   for (int s=0; s<sect; s++, nPtr=nPtr->next) { // INI sections = # nodes
-      //printf("start s:%d\n", s);
-      if (nPtr->type!=3) continue; // explore only from LDx
-      //printf("node:'%- 4s'\n", nPtr->name);
-      for (int i=0; i<MaxIns; i++) { // for every load input
-         //printf("start input i:%d r:%d\n", i, r);
-         if (nPtr->from[i]!=NULL) { // only if there is a connection to this input
-            //printf("c   :% 2d r  :% 2d node:'%- 4s' type:%d addr:%p\n", c, r, nPtr->name, nPtr->type, nPtr);
-            //printf("col+:% 2d row:% 2d node:'%- 4s' type:%d addr:%p\n", nPtr->col, nPtr->row, nPtr->name, nPtr->type, nPtr);
-            if (nPtr->col==-1) nPtr->col=c;
-            if (nPtr->row==-1) nPtr->row=r;
-            //printf("col+:% 2d row:% 2d node:'%- 4s' type:%d addr:%p\n", nPtr->col, nPtr->row, nPtr->name, nPtr->type, nPtr);
-            c++;
-            nTy* from=nPtr->from[i];
-            //printf("start name:'%s'\n", from->name);
-            int type=from->type;
-            while (type!=0) { // IN
-               //printf("c  _:% 2d r  :% 2d node:'%- 4s' type:%d addr:%p\n", c, r, from->name, from->type, from);
-               //printf("col_:% 2d row:% 2d node:'%- 4s' type:%d addr:%p\n", from->col, from->row, from->name, from->type, from);
-               if (from->col==-1 || c>from->col) from->col=c;
-               if (from->row==-1) from->row=r;
-               //printf("col_:% 2d row:% 2d node:'%- 4s' type:%d addr:%p\n", from->col, from->row, from->name, from->type, from);
-               from=from->from[0];
-               type=from->type;
-               c++;
-            }
-            //printf("c   :% 2d r  :% 2d node:'%- 4s' type:%d addr:%p _\n", c, r, from->name, from->type, from);
-            if (from->col==-1 || c>from->col) from->col=c;
-            if (from->row==-1) from->row=r;
-            //printf("col :% 2d row:% 2d node:'%- 4s' type:%d addr:%p\n", from->col, from->row, from->name, from->type, from);
-            c++;
-            r++;
+// check the node values, then follow the first input of every node up to
+// IN. A chain that comes back on itself or ends on BOARD never reach IN,
+// checked here once so the later walks end
+int pbValidateNodes(pbCtx* ctx) {
+   nListTy* listPtr=&ctx->nList;
+   u08* state=calloc(listPtr->used+1, 1); // by pool index: 1 on the chain walked, 2 reach IN
+   if (state==NULL) {
+      printf("No memory to validate nodes. Quit\n");
+      return -1;
+   }
+   for (nTy* nPtr=nListFirst(listPtr); nPtr; nPtr=nListNext(listPtr, nPtr)) {
+      if (nPtr->type==-1) continue; // BOARD
+      if (nodeCheck(nPtr)!=0) {
+         free(state);
+         return -1;
+      }
+      nTy* from=nPtr;
+      while (from->type!=0 && state[from->ix]==0) { // up to IN or a known chain
+         state[from->ix]=1;
+         nTy* upPtr=NodeAt(listPtr, from->from[0]);
+         if (upPtr==NULL || upPtr->type<0) { // BOARD or no input
+            printf("Node:'%s' not fed from an IN. Quit\n", nPtr->name);
+            free(state);
+            return -1;
          }
-         //printf("end   input i:%d r:%d\n", i, r);
-         c=0;
-      } // for (int i=0; i<MaxIns; i++)
-      //printf("end   s:%d\n", s);
-   } // for (int s=0; s<sect; s++)
-   //printf("\n");
+         from=upPtr;
+      }
+      if (from->type!=0 && state[from->ix]==1) {
+         printf("Node:'%s' in a loop of inputs. Quit\n", from->name);
+         free(state);
+         return -1;
+      }
+      for (from=nPtr; from->type!=0 && state[from->ix]==1; from=NodeAt(listPtr, from->from[0])) state[from->ix]=2;
+   }
+   free(state);
+   return 0;
+} // int pbValidateNodes(pbCtx* ctx)
 
-#if 0
-   printf("show node matrix data\n");
-   nPtr=nList.first;
-   for (int s=0; s<sect; s++) { // INI sections = # nodes
-      //printf("node:'%- 4s'\n", nPtr->name);
-      int maxIn=1;
-      if (nPtr->type==3) maxIn=MaxIns;
-      for (int i=0; i<maxIn; i++) { // for every load input
-         if (nPtr->type!=3 || nPtr->from[i]!=NULL) { // only if there is a connection to this LD input
-            printf("node:%d input:%d name:'%s' col:%d row:%d\n", s, i, nPtr->name, nPtr->col, nPtr->row);
-         }
+#define LayoutSweeps 4 // crossing reduction: barycenter sweeps down and up
+
+typedef struct layKeyTy { // node of a layer sorted by key, then former place
+    double key;
+    int pos;
+    int ix;
+} layKeyTy;
+
+static int cmpLayKey(const void* a, const void* b) {
+   const layKeyTy* x=a;
+   const layKeyTy* y=b;
+   if (x->key!=y->key) return x->key<y->key ? -1 : 1;
+   return x->pos-y->pos;
+} // int cmpLayKey(const void* a, const void* b)
+
+typedef struct layTy { // layered graph of pbLayoutNodes(), arrays by pool index
+    int cols;
+    int* first;   // [cols+1] first node of every layer in node
+    int* node;    // [placed] pool index, layer after layer in row order
+    int* up;      // [used+1] first input link of a node in upTo
+    int* upTo;    // [edges] node of the input
+    int* upIn;    // [edges] row of the link in the node, the connected LD input
+    int* down;    // [used+1] first child link of a node in downTo
+    int* downTo;  // [edges] child node
+    int* downIn;  // [edges] row of the link in the child
+    int* h;       // rows of a node: connected inputs of LD, 1 for the others
+    int* row;     // first row
+} layTy;
+
+// rows of a layer in node order, packed from row 0
+static void layPack(layTy* layPtr, int c) {
+   for (int k=layPtr->first[c], r=0; k<layPtr->first[c+1]; k++) {
+      layPtr->row[layPtr->node[k]]=r;
+      r+=layPtr->h[layPtr->node[k]];
+   }
+   return;
+} // void layPack(layTy* layPtr, int c)
+
+// order a layer by the mean row of its links to an already placed layer,
+// input links when down is 0, child links when 1. Unlinked nodes keep row
+static void laySort(layTy* layPtr, int c, int down, layKeyTy* keyPtr) {
+   int* first=down ? layPtr->down : layPtr->up;
+   int* to=down ? layPtr->downTo : layPtr->upTo;
+   int* in=down ? layPtr->downIn : layPtr->upIn;
+   int cnt=layPtr->first[c+1]-layPtr->first[c];
+   for (int k=0; k<cnt; k++) {
+      int ix=layPtr->node[layPtr->first[c]+k];
+      double sum=0;
+      for (int e=first[ix]; e<first[ix+1]; e++) {
+         if (down) sum+=layPtr->row[to[e]]+in[e]; // child input row
+         else sum+=layPtr->row[to[e]]-in[e]; // own input row on the input node
       }
-      nPtr=nPtr->next;
+      int links=first[ix+1]-first[ix];
+      keyPtr[k].key=links ? sum/links : layPtr->row[ix];
+      keyPtr[k].pos=k;
+      keyPtr[k].ix=ix;
    }
-   printf("\n");
-#endif
+   qsort(keyPtr, cnt, sizeof(layKeyTy), cmpLayKey);
+   for (int k=0; k<cnt; k++) layPtr->node[layPtr->first[c]+k]=keyPtr[k].ix;
+   layPack(layPtr, c);
+   return;
+} // void laySort(layTy* layPtr, int c, int down, layKeyTy* keyPtr)
 
-   // empty matrix
-   //printf("empty matrix\n");
-   nTy* node[cols][rows]; // node Ptr [col][row] used for graph positioning
-   for (int c=0; c<cols; c++) {
-      for (int r=0; r<rows; r++) {
-         node[c][r]=NULL;
+// place the nodes in layers for the GUI and show them. col is the longest
+// path down to a LD, LD at 0 and IN last. Rows start in the order the LD
+// input chains reach the nodes, crossed links are reduced by LayoutSweeps
+// barycenter sweeps, then a node row is aligned to its first child when
+// free. O(V+E) plus the sweeps. Done once for the loaded nodes, again only
+// after nodes changes
+int pbLayoutNodes(pbCtx* ctx) {
+   nListTy* listPtr=&ctx->nList;
+   if (listPtr->placed) return 0;
+   int used=listPtr->used;
+   int edges=0;
+   for (nTy* nPtr=nListFirst(listPtr); nPtr; nPtr=nListNext(listPtr, nPtr)) {
+      nPtr->col=-1;
+      nPtr->row=-1;
+      if (nPtr->type<=0) continue; // BOARD & IN
+      int maxIn=(nPtr->type==3) ? nPtr->ins : 1;
+      for (int i=0; i<maxIn; i++) edges+=(nPtr->from[i]>=0);
+   }
+   layTy lay;
+   lay.up=calloc(used+1, sizeof(int));
+   lay.upTo=malloc((edges+1)*sizeof(int));
+   lay.upIn=malloc((edges+1)*sizeof(int));
+   lay.down=calloc(used+1, sizeof(int));
+   lay.downTo=malloc((edges+1)*sizeof(int));
+   lay.downIn=malloc((edges+1)*sizeof(int));
+   lay.h=malloc((used+1)*sizeof(int));
+   lay.row=malloc((used+1)*sizeof(int));
+   lay.first=NULL;
+   int* col=malloc((used+1)*sizeof(int));
+   int* seq=malloc((used+1)*sizeof(int)); // topological order, then node order by first visit
+   int* deg=calloc(used+1, sizeof(int));
+   lay.node=malloc((used+1)*sizeof(int));
+   layKeyTy* keyPtr=malloc((used+1)*sizeof(layKeyTy));
+   int ret=-1;
+   if (!lay.up || !lay.upTo || !lay.upIn || !lay.down || !lay.downTo || !lay.downIn || !lay.h || !lay.row || !col || !seq || !deg || !lay.node || !keyPtr) {
+      printf("No memory for layout. Quit\n");
+      goto done;
+   }
+
+   // links both ways in CSR, LD every connected input, the others from[0]
+   for (nTy* nPtr=nListFirst(listPtr); nPtr; nPtr=nListNext(listPtr, nPtr)) {
+      lay.h[nPtr->ix]=1;
+      if (nPtr->type<=0) continue;
+      int maxIn=(nPtr->type==3) ? nPtr->ins : 1;
+      for (int i=0; i<maxIn; i++) {
+         if (nPtr->from[i]<0) continue;
+         lay.up[nPtr->ix]++;
+         lay.down[nPtr->from[i]]++;
+      }
+      if (nPtr->type==3 && lay.up[nPtr->ix]>1) lay.h[nPtr->ix]=lay.up[nPtr->ix];
+   }
+   for (int ix=0, u=0, d=0; ix<=used; ix++) { // counters ==> first link
+      int uc=lay.up[ix], dc=lay.down[ix];
+      lay.up[ix]=u; lay.down[ix]=d;
+      u+=uc; d+=dc;
+   }
+   for (nTy* nPtr=nListFirst(listPtr); nPtr; nPtr=nListNext(listPtr, nPtr)) {
+      if (nPtr->type<=0) continue;
+      int maxIn=(nPtr->type==3) ? nPtr->ins : 1;
+      for (int i=0, r=0; i<maxIn; i++) {
+         int p=nPtr->from[i];
+         if (p<0) continue;
+         int u=lay.up[nPtr->ix]+r, d=lay.down[p]+deg[p]++;
+         lay.upTo[u]=p; lay.upIn[u]=r;
+         lay.downTo[d]=nPtr->ix; lay.downIn[d]=r;
+         r++;
       }
    }
 
-   //printf("fill matrix data\n");
-   nPtr=nList.first;
-   for (int s=0; s<sect; s++, nPtr=nPtr->next) { // INI sections = # nodes
-      if (nPtr->type==-1) continue; // BOARD
-      //printf("node:'%- 4s'\n", nPtr->name);
-      //printf("nPtr->col:%d nPtr->row:%d\n", nPtr->col, nPtr->row);
-      node[nPtr->col][nPtr->row]=nPtr; // fill matrix
-      if (nPtr->type==3) { // LOAD can have more than 1 input
-         for (int i=1; i<MaxIns; i++) { // for every LOAD input
-            if (nPtr->from[i]!=NULL) { // only if there is a connection to this LD input
-               //printf("node:%d input:%d name:'%s' col:%d row:%d\n", s, i, nPtr->name, nPtr->col, nPtr->row);
-               node[nPtr->col][nPtr->row+i]=nPtr; // fill matrix
-            }
+   // layers: topological order inputs first, col by the children backward
+   int placed=0;
+   for (nTy* nPtr=nListFirst(listPtr); nPtr; nPtr=nListNext(listPtr, nPtr)) {
+      deg[nPtr->ix]=lay.up[nPtr->ix+1]-lay.up[nPtr->ix];
+      if (nPtr->type!=-1 && deg[nPtr->ix]==0) seq[placed++]=nPtr->ix;
+   }
+   for (int k=0; k<placed; k++) {
+      int ix=seq[k];
+      for (int e=lay.down[ix]; e<lay.down[ix+1]; e++) {
+         if (--deg[lay.downTo[e]]==0) seq[placed++]=lay.downTo[e];
+      }
+   }
+   lay.cols=0;
+   for (int ix=0; ix<=used; ix++) col[ix]=-1; // nodes in a loop are left out
+   for (int k=placed-1; k>=0; k--) {
+      int ix=seq[k];
+      int c=0;
+      for (int e=lay.down[ix]; e<lay.down[ix+1]; e++) {
+         if (col[lay.downTo[e]]+1>c) c=col[lay.downTo[e]]+1;
+      }
+      col[ix]=c;
+      if (c+1>lay.cols) lay.cols=c+1;
+   }
+
+   // first rows as the LD input chains reach the nodes, in node order
+   int visits=0;
+   for (int ix=0; ix<=used; ix++) seq[ix]=-1;
+   for (nTy* nPtr=nListFirst(listPtr); nPtr; nPtr=nListNext(listPtr, nPtr)) {
+      if (nPtr->type!=3 || col[nPtr->ix]<0) continue;
+      seq[nPtr->ix]=visits++;
+      for (int e=lay.up[nPtr->ix]; e<lay.up[nPtr->ix+1]; e++) {
+         for (int p=lay.upTo[e]; p>=0 && seq[p]<0; ) { // up to a node seen
+            seq[p]=visits++;
+            p=(lay.up[p]<lay.up[p+1]) ? lay.upTo[lay.up[p]] : -1;
          }
       }
    }
-   //printf("\n");
+   for (int ix=0; ix<used; ix++) { // nodes without LD below
+      if (col[ix]>=0 && seq[ix]<0) seq[ix]=visits++;
+   }
+   lay.first=calloc(lay.cols+2, sizeof(int));
+   if (lay.first==NULL) {
+      printf("No memory for layout. Quit\n");
+      goto done;
+   }
+   int* byVisit=deg; // visit ==> pool index
+   for (int ix=0; ix<used; ix++) {
+      if (seq[ix]<0) continue;
+      byVisit[seq[ix]]=ix;
+      lay.first[col[ix]+1]++;
+   }
+   for (int c=0; c<lay.cols; c++) lay.first[c+1]+=lay.first[c];
+   int* fill=seq; // seq no more needed
+   memcpy(fill, lay.first, lay.cols*sizeof(int));
+   for (int v=0; v<visits; v++) lay.node[fill[col[byVisit[v]]]++]=byVisit[v];
+   for (int c=0; c<lay.cols; c++) layPack(&lay, c);
 
-#if 0
-   printf("show matrix data\n");
-   for (int c=0; c<cols; c++) {
-      for (int r=0; r<rows; r++) {
-         if (node[c][r]!=NULL)
-            printf("col:%d row:%d ptr addr:%p name:'%s'\n", c, r, node[c][r], node[c][r]->name);
+   // crossing reduction, down from IN by the inputs and up by the children
+   for (int s=0; s<LayoutSweeps; s++) {
+      for (int c=lay.cols-2; c>=0; c--) laySort(&lay, c, 0, keyPtr);
+      for (int c=1; c<lay.cols; c++) laySort(&lay, c, 1, keyPtr);
+   }
+
+   // rows: LD packed, the others at their first child row when free
+   int rows=0;
+   for (int c=0; c<lay.cols; c++) {
+      for (int k=lay.first[c], next=0; k<lay.first[c+1]; k++) {
+         int ix=lay.node[k];
+         int r=next;
+         if (c>0 && lay.down[ix]<lay.down[ix+1]) {
+            int e=lay.down[ix];
+            r=lay.row[lay.downTo[e]]+lay.downIn[e];
+            for (e++; e<lay.down[ix+1]; e++) {
+               if (lay.row[lay.downTo[e]]+lay.downIn[e]<r) r=lay.row[lay.downTo[e]]+lay.downIn[e];
+            }
+            if (r<next) r=next;
+         }
+         lay.row[ix]=r;
+         next=r+lay.h[ix];
+         if (next>rows) rows=next;
       }
    }
-   printf("\n");
-#endif
+   for (int ix=0; ix<used; ix++) {
+      if (col[ix]<0) continue;
+      nTy* nPtr=NodeAt(listPtr, ix);
+      nPtr->col=col[ix];
+      nPtr->row=lay.row[ix];
+   }
+   listPtr->placed=1;
+   ret=0;
+   if (PbLev(ctx)<PRINTF) goto done; // graph matrix only on screen
 
+   printf("cols:%d lines:%d\n", lay.cols, rows);
+   printf("\n");
    printf("show graph matrix\n");
    printf("rows\\cols|");
-   for (int c=md; c>=0; c--) {
+   for (int c=lay.cols-1; c>=0; c--) {
       printf("      %d|", c);
    }
    printf("\n");
    printf("---------+");
-   for (int c=md; c>=0; c--) {
+   for (int c=lay.cols-1; c>=0; c--) {
       printf("-------+");
    }
    printf("\n");
+   memcpy(fill, lay.first, lay.cols*sizeof(int)); // next node of every layer
    for (int r=0; r<rows; r++) {
       printf(" %02d      |", r);
-      for (int c=md; c>=0; c--) {
-         if (node[c][r]!=NULL) {
-            // printf("col:%d row:%d ptr addr:%p name:'%s'\n", c, r, node[c][r], node[c][r]->name);
-            printf(" '%-4s'|", node[c][r]->name);
+      for (int c=lay.cols-1; c>=0; c--) {
+         int k=fill[c];
+         while (k<lay.first[c+1] && lay.row[lay.node[k]]+lay.h[lay.node[k]]<=r) k++;
+         fill[c]=k;
+         if (k<lay.first[c+1] && lay.row[lay.node[k]]<=r) {
+            printf(" '%-4s'|", NodeAt(listPtr, lay.node[k])->name);
          } else {
             printf("       |");
          }
@@ -708,8 +1670,14 @@ int loadINI(char* graphFile) {
       printf("\n");
    }
    printf("\n");
-   return 0;
-} // int loadINI(char* graphFile)
+done:
+   free(lay.first); free(lay.node); free(keyPtr);
+   free(lay.up); free(lay.upTo); free(lay.upIn);
+   free(lay.down); free(lay.downTo); free(lay.downIn);
+   free(lay.h); free(lay.row);
+   free(col); free(seq); free(deg);
+   return ret;
+} // int pbLayoutNodes(pbCtx* ctx)
 
 double calcP(double v, double i) { // calc power
    return v*i;
@@ -744,466 +1712,1174 @@ double partV(double v, double R[], int pos) { // calc voltage partitor
 }
 #endif
 
-double findInputV(nTy* node) {
-   if (node->from[0]->type==4) printf("WARN: RS on root path\n");
-   double Vo=node->from[0]->Vo;
-   return Vo;
-} // double findInputV(nTy* node)
+// free the compiled plan, so next calcNodes() will compile it again
+void freePlan(planTy* planPtr) {
+   if (planPtr==NULL) return;
+   free(planPtr->node);
+   free(planPtr->type);
+   free(planPtr->ix);
+   free(planPtr->slot);
+   free(planPtr->eff);
+   free(planPtr->in);
+   free(planPtr->up);
+   free(planPtr->mode);
+   free(planPtr->first);
+   free(planPtr->child);
+   free(planPtr->input);
+   free(planPtr->G);
+   free(planPtr->Go);
+   free(planPtr->dI);
+   free(planPtr->dIo);
+   free(planPtr->dirty);
+   free(planPtr->dirtyList);
+   memset(planPtr, 0, sizeof(planTy));
+   return;
+} // void freePlan(planTy* planPtr)
+
+// compile nList in a flat plan: node indexes in topological order, IN first
+// and leaves last, plus the child edge range of every node. Must be called
+// again when the links change, values can change freely between calcNodes()
+int pbCompileNodes(pbCtx* ctx) {
+   freePlan(&ctx->plan);
+   int sect=ctx->nList.nodeCnt;
+   if (sect==0) {
+      printf("%sNo nodes to compile. Quit\n", PbTag(ctx));
+      return -1;
+   }
+   nTy** list=malloc(sect*sizeof(nTy*)); // list position ==> node ptr
+   int* deg=calloc(sect, sizeof(int));    // inputs not yet placed in plan
+   int* outs=calloc(sect+1, sizeof(int)); // child edges, then first edge
+   int* pos=malloc(sect*sizeof(int));     // list position ==> plan position
+   int in=-1;
+   nTy* nPtr=nListFirst(&ctx->nList);
+   for (int s=0; s<sect; s++, nPtr=nListNext(&ctx->nList, nPtr)) {
+      list[s]=nPtr;
+      nPtr->pix=s; // temporary list position
+      pos[s]=-1;
+      if (nPtr->type==0) in=s;
+   }
+   int out=0;
+   if (in<0) {
+      printf("%sMissing IN node. Quit\n", PbTag(ctx));
+      out=-1; goto done;
+   }
+   int edges=0;
+   for (int s=0; s<sect; s++) { // count child edges of every node
+      nPtr=list[s];
+      if (nPtr->type==-1 || nPtr->type==0) continue; // BOARD & IN
+      int maxIn=(nPtr->type==3) ? nPtr->ins : 1;
+      for (int i=0; i<maxIn; i++) {
+         if (nPtr->from[i]<0) continue;
+         if (NodeAt(&ctx->nList, nPtr->from[i])->type==3) {
+            printf("%sNode:'%s' from:LDn. Quit\n", PbTag(ctx), nPtr->name);
+            out=-1; goto done;
+         }
+         outs[NodeAt(&ctx->nList, nPtr->from[i])->pix]++;
+         deg[s]++;
+         edges++;
+      }
+      if (nPtr->type==4 && nPtr->R[0]>MaxRsValue) {
+         printf("%sERROR: RS:'%s' > %d\n", PbTag(ctx), nPtr->name, MaxRsValue);
+         out=-1; goto done;
+      }
+   }
+   for (int s=0, e=0; s<=sect; s++) { // counters ==> first edge of node
+      int cnt=outs[s];
+      outs[s]=e;
+      e+=cnt;
+   }
+   int* child=malloc((edges+1)*sizeof(int)); // child list position
+   int* input=malloc((edges+1)*sizeof(int)); // child input
+   int* fill=malloc(sect*sizeof(int));
+   memcpy(fill, outs, sect*sizeof(int));
+   for (int s=0; s<sect; s++) { // fill child edges in list order
+      nPtr=list[s];
+      if (nPtr->type==-1 || nPtr->type==0) continue; // BOARD & IN
+      int maxIn=(nPtr->type==3) ? nPtr->ins : 1;
+      for (int i=0; i<maxIn; i++) {
+         if (nPtr->from[i]<0) continue;
+         int e=fill[NodeAt(&ctx->nList, nPtr->from[i])->pix]++;
+         child[e]=s;
+         input[e]=i;
+      }
+   }
+   free(fill);
+
+   // topological order: a node is placed when all its inputs are placed
+   int* order=malloc(sect*sizeof(int));
+   int nodes=0;
+   order[nodes++]=in;
+   for (int q=0; q<nodes; q++) {
+      int k=order[q];
+      for (int e=outs[k]; e<outs[k+1]; e++) {
+         if (--deg[child[e]]==0) order[nodes++]=child[e];
+      }
+   }
+   for (int q=0; q<nodes; q++) pos[order[q]]=q;
+   for (int s=0; s<sect; s++) {
+      if (pos[s]<0 && list[s]->type!=-1 && PbLev(ctx)>=PRINTWARN)
+         printf("%sWARN: node:'%s' not connected to IN, skipped\n", PbTag(ctx), list[s]->name);
+   }
+
+   ctx->plan.nodes=nodes;
+   ctx->plan.edges=0;
+   ctx->plan.node=malloc(nodes*sizeof(nTy*));
+   ctx->plan.type=malloc(nodes*sizeof(int));
+   ctx->plan.ix=malloc(nodes*sizeof(int));
+   ctx->plan.slot=malloc(nodes*sizeof(int));
+   ctx->plan.eff=malloc(nodes*sizeof(effTy*));
+   ctx->plan.in=malloc((nodes+1)*sizeof(int));
+   ctx->plan.in[0]=0;
+   for (int k=0; k<nodes; k++) { // input slots in a row, a LD has all its own
+      nPtr=list[order[k]];
+      ctx->plan.in[k+1]=ctx->plan.in[k]+((nPtr->type==3) ? nPtr->ins : 1);
+   }
+   int inputs=ctx->plan.in[nodes];
+   ctx->plan.inputs=inputs;
+   ctx->plan.up=malloc(inputs*sizeof(int));
+   ctx->plan.mode=malloc(inputs*sizeof(u08));
+   ctx->plan.first=malloc((nodes+1)*sizeof(int));
+   ctx->plan.child=malloc((edges+1)*sizeof(int));
+   ctx->plan.input=malloc((edges+1)*sizeof(int));
+   ctx->plan.G=calloc(inputs, sizeof(double));
+   ctx->plan.Go=calloc(nodes, sizeof(double));
+   ctx->plan.dI=calloc(nodes, sizeof(double));
+   ctx->plan.dIo=calloc(nodes, sizeof(double));
+   ctx->plan.dirty=calloc(nodes, sizeof(u08));
+   ctx->plan.dirtyList=malloc(nodes*sizeof(int));
+   ctx->plan.dirtyCnt=0;
+   ctx->plan.solved=0;
+   ctx->plan.hasRS=0;
+   for (int k=0; k<nodes; k++) { // store in plan order
+      int s=order[k];
+      nPtr=list[s];
+      ctx->plan.node[k]=nPtr;
+      ctx->plan.type[k]=nPtr->type;
+      ctx->plan.ix[k]=nPtr->ix;
+      ctx->plan.slot[k]=nPtr->inFirst;
+      ctx->plan.eff[k]=(nPtr->type==1) ? nPtr->eff : NULL;
+      if (nPtr->type==4) ctx->plan.hasRS=1;
+      for (int i=0; i<PlanIns(&ctx->plan, k); i++) {
+         int m=ctx->plan.in[k]+i;
+         ctx->plan.up[m]=-1;
+         ctx->plan.mode[m]=0;
+         if (nPtr->type==0 || nPtr->from[i]<0) continue;
+         if (nPtr->type!=3 && i>0) continue;
+         ctx->plan.up[m]=pos[NodeAt(&ctx->nList, nPtr->from[i])->pix];
+         if (nPtr->Vi[i]!=0) ctx->plan.mode[m]|=FixV; // keep user input voltage
+         if (nPtr->type!=3) continue;
+         if (nPtr->Ii[i]!=0) ctx->plan.mode[m]|=LdI;      // constant current
+         else if (nPtr->R[i]!=0) ctx->plan.mode[m]|=LdR;  // constant resistance
+         else if (nPtr->Pi[i]!=0) ctx->plan.mode[m]|=LdP; // constant power
+      }
+      ctx->plan.first[k]=ctx->plan.edges;
+      for (int e=outs[s]; e<outs[s+1]; e++) { // children in plan too
+         if (pos[child[e]]<0) continue;
+         ctx->plan.child[ctx->plan.edges]=pos[child[e]];
+         ctx->plan.input[ctx->plan.edges]=input[e];
+         ctx->plan.edges++;
+      }
+      nPtr->out=ctx->plan.edges-ctx->plan.first[k];
+   }
+   ctx->plan.first[nodes]=ctx->plan.edges;
+   for (int s=0; s<sect; s++) list[s]->pix=pos[s];
+   ctx->plan.valid=1;
+   if (PbLev(ctx)>=PRINTDEBUG) printf("plan nodes:%d edges:%d RS:%d\n", ctx->plan.nodes, ctx->plan.edges, ctx->plan.hasRS);
+   free(order);
+   free(child);
+   free(input);
+   done:
+   free(list);
+   free(deg);
+   free(outs);
+   free(pos);
+   return out;
+} // int pbCompileNodes(pbCtx* ctx)
+
+// voltage at input i of plan node k, from the node above when not given
+static inline double inputV(pbCtx* ctx, int k, int i) {
+   int m=ctx->plan.in[k]+i;
+   if (ctx->plan.mode[m]&FixV) return ctx->nList.Vi[ctx->plan.slot[k]+i];
+   return ctx->nList.Vo[ctx->plan.ix[ctx->plan.up[m]]];
+} // double inputV(pbCtx* ctx, int k, int i)
+
+// sum of the currents drawn by the children of plan node k
+static inline double childI(pbCtx* ctx, int k) {
+   double Io=0;
+   for (int e=ctx->plan.first[k]; e<ctx->plan.first[k+1]; e++) {
+      Io+=ctx->nList.Ii[ctx->plan.slot[ctx->plan.child[e]]+ctx->plan.input[e]];
+   }
+   return Io;
+} // double childI(pbCtx* ctx, int k)
+
+// calc all inputs of a LD, current, resistance or power as given
+void calcLD(pbCtx* ctx, int k) {
+   nListTy* listPtr=&ctx->nList;
+   int ix=ctx->plan.ix[k];
+   listPtr->Pd[ix]=0;
+   for (int i=0; i<PlanIns(&ctx->plan, k); i++) {
+      int m=ctx->plan.in[k]+i;
+      if (ctx->plan.up[m]<0) continue; // no input connection
+      int f=ctx->plan.slot[k]+i;
+      double Vi=inputV(ctx, k, i);
+      listPtr->Vi[f]=Vi;
+      if (ctx->plan.mode[m]&LdI) { // know V,I ==> R,P
+         listPtr->R[f]=calcR(Vi, listPtr->Ii[f]);
+      } else if (ctx->plan.mode[m]&LdR) { // know V,R ==> I,P
+         listPtr->Ii[f]=calcI(Vi, listPtr->R[f]);
+      } else if (ctx->plan.mode[m]&LdP) { // know V,P ==> I,R
+         listPtr->Ii[f]=calcI(listPtr->Pi[f], Vi);
+         listPtr->R[f]=calcR(Vi, listPtr->Ii[f]);
+      }
+      listPtr->Pi[f]=calcP(Vi, listPtr->Ii[f]);
+      listPtr->Pd[ix]+=listPtr->Pi[f]; // total dissipation
+   }
+   return;
+} // void calcLD(pbCtx* ctx, int k)
 
 // calc all outputs for IN
-int calcIN(nTy* from, double Io) {
-   int ret=0;
-   from->Io+=Io; // current from node below
-   from->out++;
-   //printf("IN from->Io:%g\n", from->Io);
-   //printf("IN from->out:%d\n", from->out);
-   if (from->to[from->out]==NULL) { // all out current summed
-      //printf("IN out complete, calc all ...\n");
-      from->Po=from->Vo*from->Io; // output power
-   } else ret=1; // goto skip; // stop graph exploration to root
-   return ret;
-} // int calcIN(nTy* node, double Io)
+void calcIN(pbCtx* ctx, int k, double Io) {
+   nListTy* listPtr=&ctx->nList;
+   int ix=ctx->plan.ix[k];
+   listPtr->Io[ix]=Io; // current from nodes below
+   listPtr->Po[ix]=listPtr->Vo[ix]*Io; // output power
+   return;
+} // void calcIN(pbCtx* ctx, int k, double Io)
 
-// may miss Vi, in case do partial calcs
-int calcSR(nTy* from, double* Io) {
-   int ret=0;
-   //from->Io+=from->to[0]->Ii[0]; // output current of father get from son input current
-   from->Io+=*Io; // current from node below
-   from->out++;
-   //printf("SR from->Io:%g\n", from->Io);
-   //printf("SR from->out:%d\n", from->out);
-   if (from->to[from->out]==NULL) { // all out current summed
-      //printf("SR out complete, calc input ...\n");
-      from->Po=from->Vo*from->Io; // output power of father calculated from Vo on Io
-      from->Pd=from->Po*(1/from->yeld-1);
-      from->Pi[0]=from->Po/from->yeld;
-      if (from->Vi[0]==0) {
-         from->Vi[0]=findInputV(from);
-         //printf("SR from->Vi[0]:%g\n", from->Vi[0]);
-      }
-      if (from->Vi[0]!=0) {
-         from->DV=from->Vi[0]-from->Vo;
-         from->Ii[0]=from->Pi[0]/from->Vi[0];
-      } else {
-         if (missFrom!=NULL) printf("WARN: SR lost node for multiple RS");
-         missFrom=from; // to complete later
-         ret|=2;
-      }
-      *Io=from->Ii[0]; // pass current to node up
-      //printf("SR Ii:%g\n", *Io);
-   } else ret|=1; // goto skip; // stop graph exploration to root
-   return ret;
-} // int calcSR(nTy* node, double* Io)
+// calc SR from output current and input voltage
+void calcSR(pbCtx* ctx, int k, double Io, double Vi) {
+   nListTy* listPtr=&ctx->nList;
+   int ix=ctx->plan.ix[k], f=ctx->plan.slot[k];
+   if (ctx->plan.eff[k]) listPtr->yeld[ix]=effLookup(ctx->plan.eff[k], Io, Vi); // n at this load
+   double Po=listPtr->Vo[ix]*Io; // output power calculated from Vo on Io
+   listPtr->Io[ix]=Io; // current from nodes below
+   listPtr->Po[ix]=Po;
+   listPtr->Pd[ix]=Po*(1/listPtr->yeld[ix]-1);
+   listPtr->Pi[f]=Po/listPtr->yeld[ix];
+   listPtr->Vi[f]=Vi;
+   listPtr->DV[ix]=Vi-listPtr->Vo[ix];
+   listPtr->Ii[f]=calcI(listPtr->Pi[f], Vi);
+   return;
+} // void calcSR(pbCtx* ctx, int k, double Io, double Vi)
 
-// may miss Vi, in case do partial calcs
-int calcLR(nTy* from, double* Io) {
-   int ret=0;
-   //printf("LR i:%d from->to[0]:%p\n", i, from->to[0]);
-   from->Io+=*Io; // current from node below
-   from->out++;
-   //printf("LR from->Io:%g\n", from->Io);
-   //printf("LR from->out:%d\n", from->out);
-   if (from->to[from->out]==NULL) { // all out current summed
-      //printf("LR out complete, calc input ...\n");
-      from->Po=from->Vo*from->Io; // output power of father calculated from Vo on Io
-      from->Ii[0]=from->Io+from->Iadj;
-      if (from->Vi[0]==0) {
-         from->Vi[0]=findInputV(from);
-         //printf("LR from->Vi[0]:%g\n", from->Vi[0]);
-      }
-      if (from->Vi[0]!=0) {
-         from->DV=from->Vi[0]-from->Vo;
-         from->Pd=from->Io*from->DV+from->Iadj*from->Vi[0];
-         from->Pi[0]=from->Vi[0]*from->Ii[0];
-      } else {
-         if (missFrom!=NULL) printf("WARN: LR lost node for multiple RS");
-         missFrom=from; // to complete later
-         ret|=2;
-      }
-      *Io=from->Ii[0]; // pass current to node up
-      //printf("LR Io:%g\n", *Io);
-   } else ret|=1; // goto skip; // stop graph exploration to root
-   return ret;
-} // int calcLR(nTy* node, double* Io)
+// calc LR from output current and input voltage
+void calcLR(pbCtx* ctx, int k, double Io, double Vi) {
+   nListTy* listPtr=&ctx->nList;
+   int ix=ctx->plan.ix[k], f=ctx->plan.slot[k];
+   double DV=Vi-listPtr->Vo[ix];
+   listPtr->Io[ix]=Io; // current from nodes below
+   listPtr->Po[ix]=listPtr->Vo[ix]*Io; // output power calculated from Vo on Io
+   listPtr->Ii[f]=Io+listPtr->Iadj[ix];
+   listPtr->Vi[f]=Vi;
+   listPtr->DV[ix]=DV;
+   listPtr->Pd[ix]=Io*DV+listPtr->Iadj[ix]*Vi;
+   listPtr->Pi[f]=Vi*listPtr->Ii[f];
+   return;
+} // void calcLR(pbCtx* ctx, int k, double Io, double Vi)
 
-// may be many RS series, in case find all
-int calcRS(nTy* from, double Io, double* Vo) {
-   int ret=0;
-   //printf("from->name:%s\n", from->name);
-   //printf("RS Io:%g\n", Io);
-   double Vi=0; // Voltage at input of RS series
-   double Rt=0;
-   int p;
-   nTy* fromSave=from; // save for 2nd pass
-   //printf("RS discover Rt and Vi ...\n");
-   for (p=0; p<MaxRserie; p++) { // look for first regulator
-      //printf("from->name:%s\n", from->name);
-      int type=from->type;
-      //printf("type:%d\n", type);
-      if (type==4) {
-         Rt+=from->R[0];
-      }
-      if (type==0 || type==1 || type==2) { // IN or regulators
-         Vi=from->Vo;
-         break;
+// calc RS current side, voltages are set by calcRSv() going down
+void calcRS(pbCtx* ctx, int k, double Io) {
+   nListTy* listPtr=&ctx->nList;
+   int ix=ctx->plan.ix[k], f=ctx->plan.slot[k];
+   listPtr->Io[ix]=Io; // current from nodes below
+   listPtr->Ii[f]=Io;
+   listPtr->DV[ix]=listPtr->R[f]*Io; // deltaV on RS single
+   listPtr->Pd[ix]=listPtr->DV[ix]*Io;
+   return;
+} // void calcRS(pbCtx* ctx, int k, double Io)
+
+// calc RS voltage side from the input voltage, return the output change.
+// Newton step: the children current, moved by dIo to the Newton solution
+// of the RS below, change with Vo by Go. So solve
+// Vo=Vi-R*(Io+dIo+Go*(Vo-Vo0)) in place of Vo=Vi-R*Io
+double calcRSv(pbCtx* ctx, int k, double Vi, double Go, double dIo) {
+   nListTy* listPtr=&ctx->nList;
+   int ix=ctx->plan.ix[k], f=ctx->plan.slot[k];
+   double R=listPtr->R[f];
+   double Vo=listPtr->Vo[ix];
+   double den=1+R*Go;
+   if (den<=0) { Go=0; den=1; } // past max power transfer, plain substitution
+   listPtr->Vi[f]=Vi;
+   listPtr->Vo[ix]=(Vi-R*(listPtr->Io[ix]+dIo)+R*Go*Vo)/den;
+   listPtr->Po[ix]=listPtr->Vo[ix]*listPtr->Io[ix];
+   listPtr->Pi[f]=Vi*listPtr->Ii[f];
+   Vo-=listPtr->Vo[ix];
+   return Vo<0 ? -Vo : Vo;
+} // double calcRSv(pbCtx* ctx, int k, double Vi, double Go, double dIo)
+
+// input conductance dIi/dVi of plan node k: how its input currents move
+// with the voltage from above, RS included. The Jacobian of the RS network
+// is a tree, so the leaves to root sweep eliminates it with no fill and
+// calcRSv() going down does the Newton back substitution
+void calcG(pbCtx* ctx, int k) {
+   const nListTy* listPtr=&ctx->nList;
+   int ix=ctx->plan.ix[k], f=ctx->plan.slot[k];
+   const double* Vi=listPtr->Vi+f;
+   const double* Ii=listPtr->Ii+f;
+   const double* R=listPtr->R+f;
+   double* G=ctx->plan.G+ctx->plan.in[k];
+   int ins=PlanIns(&ctx->plan, k);
+   double Go=0, dIo=0;
+   for (int e=ctx->plan.first[k]; e<ctx->plan.first[k+1]; e++) {
+      Go+=ctx->plan.G[ctx->plan.in[ctx->plan.child[e]]+ctx->plan.input[e]];
+      dIo+=ctx->plan.dI[ctx->plan.child[e]];
+   }
+   ctx->plan.Go[k]=Go;
+   ctx->plan.dIo[k]=dIo;
+   ctx->plan.dI[k]=0;
+   for (int i=0; i<ins; i++) G[i]=0;
+   switch (ctx->plan.type[k]) {
+   case 1: { // SR: constant output power, I=Po/(n*Vi) and n can move with Vi
+      const effTy* eff=ctx->plan.eff[k];
+      if (Vi[0]==0) break;
+      G[0]=-Ii[0]/Vi[0];
+      if (eff && eff->Vi.cnt>1) {
+         double h=1e-6*Vi[0];
+         double dn=effLookup(eff, listPtr->Io[ix], Vi[0]+h)-effLookup(eff, listPtr->Io[ix], Vi[0]-h);
+         G[0]-=Ii[0]*dn/(2*h*listPtr->yeld[ix]);
       }
-      from=from->from[0];
-   } // know: Io, Vi, Rt;
-   //printf("RS Vit:%g\n", Vi);
-   //printf("RS DVt:%g\n", Io*Rt);
-   //printf("RS RSt:%g\n", Rt);
-   double Vp=Vi-Io*Rt; // Voltage after RS series
-   //printf("Vo:%g output of RS series\n", Vp);
-   *Vo=Vp;
-   //printf("RS p:%d exploring down to fill single data ...\n", p);
-   int q=p;
-   // need: Io, Vi, Rt;
-   from=fromSave;
-   for (p=0; p<q; p++) { // all RS found
-      //printf("p:%d\n", p);
-      //printf("Vp:%g\n", Vp);
-      //printf("from->name:%s\n", from->name);
-      //printf("from->R[0]:%g\n", from->R[0]);
-      from->Vo=Vp;
-      from->Io=Io;
-      from->Po=from->Vo*Io;
-      from->DV=from->R[0]*Io; // deltaV on RS single
-      from->Pd=from->DV*Io;
-      from->Vi[0]=from->DV+Vp;
-      from->Ii[0]=Io;
-      from->Pi[0]=from->Vi[0]*Io;
-      //printf("from->Vi[0]:%g\n", from->Vi[0]);
-      //printf("from->DV:%g\n", from->DV);
-      //printf("from->Vo:%g\n", from->Vo);
-      from->out=1;
-      Vp=from->Vi[0]; // take note of Voltage at RS input
-      from=from->from[0];
+      break;
    }
-   return ret;
-} // int calcRS(nTy* node, double Io)
+   case 3: // LD: I constant, R as 1/R, P as -I/V
+      for (int i=0; i<ins; i++) {
+         u08 mode=ctx->plan.mode[ctx->plan.in[k]+i];
+         if (mode&LdR && R[i]!=0) G[i]=1/R[i];
+         else if (mode&LdP && Vi[i]!=0) G[i]=-Ii[i]/Vi[i];
+      }
+      break;
+   case 4: { // RS: children see the output, drooped by R
+      double den=1+R[0]*Go;
+      if (den<=0) break; // as calcRSv()
+      G[0]=Go/den;
+      double I=listPtr->Io[ix]+dIo;
+      ctx->plan.dI[k]=dIo+G[0]*(inputV(ctx, k, 0)-listPtr->Vo[ix]-R[0]*I);
+      break;
+   }
+   } // IN has no input, LR draw Io+Iadj whatever Vi
+   for (int i=0; i<ins; i++) {
+      if (ctx->plan.mode[ctx->plan.in[k]+i]&FixV) G[i]=0; // voltage given, not from above
+   }
+   if (ctx->plan.mode[ctx->plan.in[k]]&FixV) ctx->plan.dI[k]=0;
+   return;
+} // void calcG(pbCtx* ctx, int k)
 
-int calcNodes() {
+// walk the plan from leaves to root: currents go up, every node once.
+// With RS the voltages come down after, repeat until RS outputs are stable,
+// -1 when they are not
+int pbCalcNodes(pbCtx* ctx) {
+   if (!ctx->plan.valid && pbCompileNodes(ctx)!=0) return -1;
+   if (PbLev(ctx)>=PRINTF) printf("calc section ...\n");
+   if (PbLev(ctx)>=PRINTF) printf("sect:%d\n", ctx->nList.nodeCnt);
+   ctx->plan.solved=0;
+   if (ctx->plan.hasRS) { // start with the RS drop of the last solve, none after a load
+      for (int k=1; k<ctx->plan.nodes; k++) {
+         if (ctx->plan.type[k]!=4) continue;
+         ctx->nList.DV[ctx->plan.ix[k]]=0;
+         calcRSv(ctx, k, inputV(ctx, k, 0), 0, 0);
+      }
+   }
+   int iter=0;
+   double dV;
+   do {
+      for (int k=ctx->plan.nodes-1; k>=0; k--) { // leaves to root
+         int ix=ctx->plan.ix[k];
+         switch (ctx->plan.type[k]) {
+         case 0: // IN
+            if (ctx->nList.Vo[ix]==0) { printf("%sERROR: Vo = 0\n", PbTag(ctx)); return -1; }
+            calcIN(ctx, k, childI(ctx, k));
+            break;
+         case 1: // SR
+            if (ctx->plan.eff[k]==NULL && ctx->nList.yeld[ix]==0) { printf("%sERROR: yeld = 0\n", PbTag(ctx)); return -1; }
+            calcSR(ctx, k, childI(ctx, k), inputV(ctx, k, 0));
+            break;
+         case 2: // LR
+            calcLR(ctx, k, childI(ctx, k), inputV(ctx, k, 0));
+            break;
+         case 3: // LD
+            calcLD(ctx, k);
+            break;
+         case 4: // RS
+            calcRS(ctx, k, childI(ctx, k));
+            break;
+         default:
+            printf("%sERROR: unsupported type:%d\n", PbTag(ctx), ctx->plan.type[k]);
+            return -1;
+         } // switch (type)
+         if (ctx->plan.hasRS) calcG(ctx, k);
+      }
+      dV=0;
+      if (!ctx->plan.hasRS) break;
+      for (int k=1; k<ctx->plan.nodes; k++) { // root to leaves: RS voltages
+         if (ctx->plan.type[k]!=4) continue;
+         double d=calcRSv(ctx, k, inputV(ctx, k, 0), ctx->plan.Go[k], ctx->plan.dIo[k]);
+         if (d>dV) dV=d;
+      }
+      iter++;
+   } while (dV>SolveTol && iter<MaxSolveIter);
+   if (dV>SolveTol) { // past the max power a RS can carry: no solution
+      printf("%sERROR: RS voltages not stable after %d iterations\n", PbTag(ctx), iter);
+      return -1;
+   }
+   if (ctx->plan.hasRS && PbLev(ctx)>=PRINTDEBUG) printf("RS voltages stable after %d iterations\n", iter);
+   for (int d=0; d<ctx->plan.dirtyCnt; d++) ctx->plan.dirty[ctx->plan.dirtyList[d]]=0;
+   ctx->plan.dirtyCnt=0;
+   ctx->plan.solved=1;
+   if (PbLev(ctx)>=PRINTF) printf("done\n");
+   if (PbLev(ctx)>=PRINTF) printf("\n");
+   return 0;
+} // int pbCalcNodes(pbCtx* ctx);
+
+// mark plan node k dirty, with all nodes above it up to IN
+static void markUp(pbCtx* ctx, int k) {
+   while (k>=0 && !ctx->plan.dirty[k]) {
+      ctx->plan.dirty[k]=1;
+      ctx->plan.dirtyList[ctx->plan.dirtyCnt++]=k;
+      if (ctx->plan.type[k]==3) { // LD: every input path
+         for (int i=1; i<PlanIns(&ctx->plan, k); i++) markUp(ctx, ctx->plan.up[ctx->plan.in[k]+i]);
+      }
+      k=ctx->plan.up[ctx->plan.in[k]];
+   }
+   return;
+} // void markUp(pbCtx* ctx, int k)
+
+// mark plan node k dirty, with the nodes below fed by its output voltage
+// and all above them. A regulator below keeps its Vo: only its input moves
+static void markDown(pbCtx* ctx, int k) {
+   markUp(ctx, k);
+   for (int e=ctx->plan.first[k]; e<ctx->plan.first[k+1]; e++) {
+      int c=ctx->plan.child[e];
+      if (ctx->plan.type[c]==1 || ctx->plan.type[c]==2) markUp(ctx, c);
+      else markDown(ctx, c);
+   }
+   return;
+} // void markDown(pbCtx* ctx, int k)
+
+// set a value of a node and mark dirty only the nodes it changes: the path
+// up to IN, plus the nodes below for an output voltage. pbSolve() calc them
+static int pbSet(pbCtx* ctx, nTy* node, double* valuePtr, double value, int down) {
+   *valuePtr=value;
+   if (!ctx->plan.valid || !ctx->plan.solved) return 0; // next pbSolve() calc all
+   int k=node->pix;
+   if (k<0) return -1; // node not in plan
+   if (down) markDown(ctx, k);
+   else markUp(ctx, k);
+   return 0;
+} // int pbSet(pbCtx* ctx, nTy* node, double* valuePtr, double value, int down)
+
+// set the kind of a LD input, as it was given in the INI
+static void setLoadMode(pbCtx* ctx, nTy* node, int input, u08 mode) {
+   if (!ctx->plan.valid || node->pix<0) return;
+   u08* modePtr=&ctx->plan.mode[ctx->plan.in[node->pix]+input];
+   *modePtr=(*modePtr&FixV)|mode;
+   return;
+} // void setLoadMode(pbCtx* ctx, nTy* node, int input, u08 mode)
+
+// LIB: set the current of LD input
+int pbSetLoadCurrent(pbCtx* ctx, nTy* node, int input, double value) {
+   if (node==NULL || node->type!=3 || input<0 || input>=node->ins) return -1;
+   if (valueCheck(node, ValI, value)!=0) return -1;
+   setLoadMode(ctx, node, input, LdI);
+   return pbSet(ctx, node, &node->Ii[input], value, 0);
+} // int pbSetLoadCurrent(pbCtx* ctx, nTy* node, int input, double value)
+
+// LIB: set the resistance of LD input or RS
+int pbSetLoadR(pbCtx* ctx, nTy* node, int input, double value) {
+   if (node==NULL || (node->type!=3 && node->type!=4) || input<0 || input>=node->ins) return -1;
+   if (valueCheck(node, ValR, value)!=0) return -1;
+   if (node->type==3) setLoadMode(ctx, node, input, LdR);
+   return pbSet(ctx, node, &node->R[input], value, node->type==4);
+} // int pbSetLoadR(pbCtx* ctx, nTy* node, int input, double value)
+
+// LIB: set the power of LD input
+int pbSetLoadPower(pbCtx* ctx, nTy* node, int input, double value) {
+   if (node==NULL || node->type!=3 || input<0 || input>=node->ins) return -1;
+   if (valueCheck(node, ValP, value)!=0) return -1;
+   setLoadMode(ctx, node, input, LdP);
+   return pbSet(ctx, node, &node->Pi[input], value, 0);
+} // int pbSetLoadPower(pbCtx* ctx, nTy* node, int input, double value)
+
+// LIB: set the efficiency of SR
+int pbSetYeld(pbCtx* ctx, nTy* node, double value) {
+   if (node==NULL || node->type!=1 || valueCheck(node, ValN, value)!=0) return -1;
+   return pbSet(ctx, node, node->yeld, value, 0);
+} // int pbSetYeld(pbCtx* ctx, nTy* node, double value)
+
+// LIB: set the adjust current of LR
+int pbSetIadj(pbCtx* ctx, nTy* node, double value) {
+   if (node==NULL || node->type!=2 || valueCheck(node, ValIadj, value)!=0) return -1;
+   return pbSet(ctx, node, node->Iadj, value, 0);
+} // int pbSetIadj(pbCtx* ctx, nTy* node, double value)
+
+// LIB: set the output voltage of regulator or IN voltage
+int pbSetVo(pbCtx* ctx, nTy* node, double value) {
+   if (node==NULL || node->type<0 || node->type>2 || valueCheck(node, ValVo, value)!=0) return -1;
+   return pbSet(ctx, node, node->Vo, value, 1);
+} // int pbSetVo(pbCtx* ctx, nTy* node, double value)
+
+static int cmpDown(const void* a, const void* b) { // leaves first
+   return *(const int*)b-*(const int*)a;
+} // int cmpDown(const void* a, const void* b)
+
+// LIB: calc only dirty nodes after pbSet...(), leaves to root. Calc all when
+// never solved, links changed or an RS is dirty (its drop moves voltages)
+int pbSolve(pbCtx* ctx) {
+   if (!ctx->plan.valid || !ctx->plan.solved) return pbCalcNodes(ctx);
+   int full=0;
+   for (int d=0; d<ctx->plan.dirtyCnt; d++) {
+      if (ctx->plan.type[ctx->plan.dirtyList[d]]==4) full=1;
+   }
+   if (full) return pbCalcNodes(ctx);
+   qsort(ctx->plan.dirtyList, ctx->plan.dirtyCnt, sizeof(int), cmpDown);
    int out=0;
-   int ret=0;
-   // calc section
-   printf("calc section ...\n");
-   int sect=nList.nodeCnt;
-   printf("sect:%d\n", sect);
-   //showStructData();
-   nTy* nPtr=nList.first;
-   for (int s=0; s<sect; s++, nPtr=nPtr->next) { // INI sections = # nodes
-      //printf("node:%d type:%d\n", s, nPtr->type);
-      if (nPtr->type==-1) continue; // board
-      if (nPtr->type!=3) continue; // calc only LDx
-      //printf("---\n");
-      //printf("new s:%d node:'%s'\n", s, nPtr->name);
-      for (int i=0; i<MaxIns; i++) { // for every load input
-         //printf("\n");
-         //printf("s:%d node:'%s' node:%p input:%d\n", s, nPtr->name, nPtr, i);
-         //char snPtr[2];
-         //sprintf(snPtr, "%d", i);
-         nTy* from;
-         int type;
-         double Vo=0;
-         if (nPtr->Vi[i]==0) { // do not know the input voltage
-            if (nPtr->from[i]!=NULL) { // only if there is an input connection
-               type=nPtr->from[i]->type;
-               if (type==0 || type==1 || type==2) { // IN or regulators
-                  nPtr->Vi[i]=nPtr->from[i]->Vo; // copy Voltage U=>D
-               } else { // found RS so need voltage partitor
-                  //printf("RS processing ...\n");
-                  calcRS(*nPtr->from, nPtr->Ii[i], &Vo);
-#if 0
-                  //printf("nPtr->name:%s\n", nPtr->name);
-                  double R[MaxRserie];
-                  double Rt=0;
-                  from=nPtr->from[i];
-                  //printf("nPtr->from[i].name:%s\n", nPtr->from[i]->name);
-                  //printf("from.name:%s\n", from->name);
-                  //R[0]=from->R[0];
-                  //printf("R[0]:%g\n", R[0]);
-                  double Vi; // Voltage at input of RS series
-                  int p;
-                  for (p=0; p<MaxRserie; p++) { // look for first regulator
-                     //printf("from.name:%s\n", from->name);
-                     type=from->type;
-                     //printf("type:%d\n", type);
-                     if (type==4) {
-                        from->Io=nPtr->Ii[i];
-                        R[p]=from->R[0];
-                        //printf("R[%d]:%g\n", p, R[p]);
-                        double DV=R[p]*from->Io; // deltaV on RS single
-                        from->DV=DV;
-                        from->Pd=DV*from->Io;
-                        from->Ii[0]=from->Io;
-                        Rt+=R[p];
-                     }
-                     if (type==0 || type==1 || type==2) { // IN or regulators
-                        Vi=from->Vo;
-                        //printf("RS Vi:%g\n", Vi);
-                        break;
-                     }
-                     from=from->from[0];
-                  } // know: from->Io, Ii[0], Rt, Vi; [R[p], DV, Pd]
-                  //printf("RS Rt:%g\n", Rt);
-                  double DV=Rt*nPtr->Ii[i]; // deltaV tot on RS series
-                  //printf("tot DV:%g\n", DV);
-                  //nPtr->DV=DV;
-                  nPtr->Vi[i]=Vi-DV;
-                  double Vp=nPtr->Vi[i]; // Voltage at RS series end
-                  //printf("RS Vo:%g\n", Vp);
-                  //printf("RS p:%d exploring down to fill single data ...\n", p);
-                  int q=p;
-                  from=nPtr->from[i];
-                  for (p=0; p<q; p++) { // all RS found
-                     //printf("from->name:%s\n", from->name);
-                     //printf("from->type:%d\n", from->type);
-                     from->Vo=from->DV+Vp;
-                     from->Po=from->Vo*from->Io;
-                     from->Vi[0]=from->DV+from->Vo;
-                     //printf("from->Vi[0]:%g\n", from->Vi[0]);
-                     //if (p==q-1) from->Vi[0]=Vi; // dirty hack to improve accuracy
-                     //printf("from->Vi[0]:%g\n", from->Vi[0]);
-                     //printf("from->DV:%g\n", from->DV);
-                     //printf("from->Vo:%g\n", from->Vo);
-                     from->Pi[0]=from->Vi[0]*from->Ii[0];
-                     from->out=1;
-                     Vp=from->Vi[0];
-                     from=from->from[0];
-                  }
-#endif
-               } // found RS so need voltage partitor
-               //printf("Vi[%d]:%g V as input for load\n", i, nPtr->Vi[i]);
-            } else { // no from, so no input connection
-               //printf("nPtr->from[i] NULL\n");
-               //nPtr->Vi[i]=0;
-               continue;
-            }
-         }
-         //printf("calc i:%d\n", i);
-         if (nPtr->R[i]==0 && nPtr->Ii[i]!=0) { // know V,I ==> R,P
-            nPtr->R[i]=calcR(nPtr->Vi[i], nPtr->Ii[i]);
-            nPtr->Pi[i]=calcP(nPtr->Vi[i], nPtr->Ii[i]);
+   for (int d=0; d<ctx->plan.dirtyCnt; d++) {
+      int k=ctx->plan.dirtyList[d];
+      int ix=ctx->plan.ix[k];
+      ctx->plan.dirty[k]=0;
+      switch (ctx->plan.type[k]) {
+      case 0: // IN
+         if (ctx->nList.Vo[ix]==0) { printf("%sERROR: Vo = 0\n", PbTag(ctx)); out=-1; break; }
+         calcIN(ctx, k, childI(ctx, k));
+         break;
+      case 1: // SR
+         if (ctx->plan.eff[k]==NULL && ctx->nList.yeld[ix]==0) { printf("%sERROR: yeld = 0\n", PbTag(ctx)); out=-1; break; }
+         calcSR(ctx, k, childI(ctx, k), inputV(ctx, k, 0));
+         break;
+      case 2: // LR
+         calcLR(ctx, k, childI(ctx, k), inputV(ctx, k, 0));
+         break;
+      case 3: // LD
+         calcLD(ctx, k);
+         break;
+      }
+   }
+   ctx->plan.dirtyCnt=0;
+   if (out!=0) ctx->plan.solved=0;
+   return out;
+} // int pbSolve(pbCtx* ctx)
+
+// alloc the lanes of cnt scenarios for the compiled plan, every lane filled
+// with the node values: caller then changes the lanes of its scenarios
+int batchInit(pbCtx* ctx, batchTy* batchPtr, int cnt) {
+   if (batchPtr==NULL || cnt<1) return -1;
+   if (!ctx->plan.valid && pbCompileNodes(ctx)!=0) return -1;
+   int nodes=ctx->plan.nodes;
+   size_t nLanes=(size_t)nodes*cnt;
+   size_t iLanes=(size_t)ctx->plan.inputs*cnt;
+   batchPtr->ctx=ctx;
+   batchPtr->cnt=cnt;
+   batchPtr->nodes=nodes;
+   batchPtr->Vo=malloc(nLanes*sizeof(double));
+   batchPtr->yeld=malloc(nLanes*sizeof(double));
+   batchPtr->Iadj=malloc(nLanes*sizeof(double));
+   batchPtr->Io=malloc(nLanes*sizeof(double));
+   batchPtr->Po=malloc(nLanes*sizeof(double));
+   batchPtr->Pd=malloc(nLanes*sizeof(double));
+   batchPtr->Vi=malloc(iLanes*sizeof(double));
+   batchPtr->Ii=malloc(iLanes*sizeof(double));
+   batchPtr->R=malloc(iLanes*sizeof(double));
+   batchPtr->Pi=malloc(iLanes*sizeof(double));
+   batchPtr->fail=calloc(cnt, 1);
+   batchPtr->move=NULL;
+   batchPtr->G=NULL;
+   batchPtr->Go=NULL;
+   batchPtr->dI=NULL;
+   batchPtr->dIo=NULL;
+   if (ctx->plan.hasRS) { // Newton step on RS
+      batchPtr->G=calloc(iLanes, sizeof(double));
+      batchPtr->Go=calloc(nLanes, sizeof(double));
+      batchPtr->dI=calloc(nLanes, sizeof(double));
+      batchPtr->dIo=calloc(nLanes, sizeof(double));
+      batchPtr->move=calloc(cnt, 1);
+   }
+   if (!batchPtr->Vo || !batchPtr->yeld || !batchPtr->Iadj || !batchPtr->Io ||
+       !batchPtr->Po || !batchPtr->Pd || !batchPtr->Vi || !batchPtr->Ii ||
+       !batchPtr->R || !batchPtr->Pi || !batchPtr->fail ||
+       (ctx->plan.hasRS && (!batchPtr->G || !batchPtr->Go || !batchPtr->dI || !batchPtr->dIo || !batchPtr->move))) {
+      printf("ERROR: cannot allocate %d scenarios of %d nodes\n", cnt, nodes);
+      batchFree(batchPtr);
+      return -1;
+   }
+   for (int k=0; k<nodes; k++) {
+      nTy* node=ctx->plan.node[k];
+      for (int s=0; s<cnt; s++) {
+         size_t l=(size_t)k*cnt+s;
+         batchPtr->Vo[l]=*node->Vo;
+         batchPtr->yeld[l]=*node->yeld;
+         batchPtr->Iadj[l]=*node->Iadj;
+         batchPtr->Io[l]=0;
+         batchPtr->Po[l]=0;
+         batchPtr->Pd[l]=0;
+      }
+      for (int i=0; i<PlanIns(&ctx->plan, k); i++) {
+         for (int s=0; s<cnt; s++) {
+            size_t l=BatchInLane(&ctx->plan, k, i, s, cnt);
+            batchPtr->Vi[l]=node->Vi[i];
+            batchPtr->Ii[l]=node->Ii[i];
+            batchPtr->R[l]=node->R[i];
+            batchPtr->Pi[l]=node->Pi[i];
          }
-         if (nPtr->Ii[i]==0 && nPtr->R[i]!=0) { // know V,R ==> I,P
-            nPtr->Ii[i]=calcI(nPtr->Vi[i], nPtr->R[i]);
-            nPtr->Pi[i]=calcP(nPtr->Vi[i], nPtr->R[i]);
+      }
+   }
+   return 0;
+} // int batchInit(pbCtx* ctx, batchTy* batchPtr, int cnt)
+
+// free the lanes of all scenarios
+void batchFree(batchTy* batchPtr) {
+   if (batchPtr==NULL) return;
+   free(batchPtr->Vo);
+   free(batchPtr->yeld);
+   free(batchPtr->Iadj);
+   free(batchPtr->Io);
+   free(batchPtr->Po);
+   free(batchPtr->Pd);
+   free(batchPtr->Vi);
+   free(batchPtr->Ii);
+   free(batchPtr->R);
+   free(batchPtr->Pi);
+   free(batchPtr->G);
+   free(batchPtr->Go);
+   free(batchPtr->dI);
+   free(batchPtr->dIo);
+   free(batchPtr->fail);
+   free(batchPtr->move);
+   memset(batchPtr, 0, sizeof(batchTy));
+   return;
+} // void batchFree(batchTy* batchPtr)
+
+// copy the input voltage lanes of plan node k input i, from the node above
+static void batchInputV(batchTy* batchPtr, int k, int i) {
+   pbCtx* ctx=batchPtr->ctx;
+   int m=ctx->plan.in[k]+i;
+   if (ctx->plan.mode[m]&FixV) return; // lanes keep the given voltage
+   int cnt=batchPtr->cnt;
+   double* restrict Vi=batchPtr->Vi+(size_t)m*cnt;
+   const double* restrict Vo=batchPtr->Vo+(size_t)ctx->plan.up[m]*cnt;
+   memcpy(Vi, Vo, cnt*sizeof(double));
+} // void batchInputV(batchTy* batchPtr, int k, int i)
+
+// sum in Io lanes of plan node k the currents drawn by its children
+static void batchChildI(batchTy* batchPtr, int k) {
+   pbCtx* ctx=batchPtr->ctx;
+   int cnt=batchPtr->cnt;
+   double* restrict Io=batchPtr->Io+(size_t)k*cnt;
+   for (int s=0; s<cnt; s++) Io[s]=0;
+   for (int e=ctx->plan.first[k]; e<ctx->plan.first[k+1]; e++) {
+      const double* restrict Ii=batchPtr->Ii+BatchInLane(&ctx->plan, ctx->plan.child[e], ctx->plan.input[e], 0, cnt);
+      for (int s=0; s<cnt; s++) Io[s]+=Ii[s];
+   }
+} // void batchChildI(batchTy* batchPtr, int k)
+
+// input conductance lanes of plan node k, as calcG()
+static void batchG(batchTy* batchPtr, int k) {
+   pbCtx* ctx=batchPtr->ctx;
+   int cnt=batchPtr->cnt;
+   size_t l=(size_t)k*cnt, m=BatchInLane(&ctx->plan, k, 0, 0, cnt);
+   int ins=PlanIns(&ctx->plan, k);
+   double* restrict Go=batchPtr->Go+l;
+   double* restrict dIo=batchPtr->dIo+l;
+   double* restrict dI=batchPtr->dI+l;
+   double* restrict G=batchPtr->G+m;
+   const double* restrict Vi=batchPtr->Vi+m;
+   const double* restrict Ii=batchPtr->Ii+m;
+   const double* restrict R=batchPtr->R+m;
+   for (int s=0; s<cnt; s++) Go[s]=dIo[s]=0;
+   for (int e=ctx->plan.first[k]; e<ctx->plan.first[k+1]; e++) {
+      const double* restrict Gc=batchPtr->G+BatchInLane(&ctx->plan, ctx->plan.child[e], ctx->plan.input[e], 0, cnt);
+      const double* restrict dIc=batchPtr->dI+(size_t)ctx->plan.child[e]*cnt;
+      for (int s=0; s<cnt; s++) {
+         Go[s]+=Gc[s];
+         dIo[s]+=dIc[s];
+      }
+   }
+   memset(G, 0, ins*cnt*sizeof(double));
+   memset(dI, 0, cnt*sizeof(double));
+   switch (ctx->plan.type[k]) {
+   case 1: { // SR
+      const effTy* e=ctx->plan.eff[k];
+      const double* restrict Io=batchPtr->Io+l;
+      const double* restrict n=batchPtr->yeld+l;
+      for (int s=0; s<cnt; s++) G[s]=Vi[s]!=0 ? -Ii[s]/Vi[s] : 0;
+      if (e==NULL || e->Vi.cnt<2) break;
+      for (int s=0; s<cnt; s++) {
+         if (Vi[s]==0) continue;
+         double h=1e-6*Vi[s];
+         double dn=effLookup(e, Io[s], Vi[s]+h)-effLookup(e, Io[s], Vi[s]-h);
+         G[s]-=Ii[s]*dn/(2*h*n[s]);
+      }
+      break;
+   }
+   case 3: // LD
+      for (int i=0; i<ins; i++) {
+         u08 mode=ctx->plan.mode[ctx->plan.in[k]+i];
+         if (mode&FixV) continue;
+         double* restrict g=G+(size_t)i*cnt;
+         const double* restrict V=Vi+(size_t)i*cnt;
+         const double* restrict I=Ii+(size_t)i*cnt;
+         const double* restrict r=R+(size_t)i*cnt;
+         if (mode&LdR) {
+            for (int s=0; s<cnt; s++) g[s]=r[s]!=0 ? 1/r[s] : 0;
+         } else if (mode&LdP) {
+            for (int s=0; s<cnt; s++) g[s]=V[s]!=0 ? -I[s]/V[s] : 0;
          }
-         nPtr->Pd+=nPtr->Pi[i]; // total dissipation
-
-         // follow graph to root
-         //printf("follow graph to root ...\n");
-         //printf("s:%d\n", s);
-         //printf("following input i:%d\n", i);
-         //printf("name:'%s'\n", nPtr->name);
-         from=nPtr->from[i];
-         double Io=nPtr->Ii[i]; // pass current to node up
-         while (from!=NULL) { // IN node
-            //printf("\n");
-            //printf("name:'%s'\n", from->name);
-            //printf("type:%d\n", from->type);
-            type=from->type;
-            //printf("s:%d node:'%s' node:%p input:%d from:'%s' type:%d\n", s, nPtr->name, nPtr, i, from->name, type);
-            switch (type) {
-            case 0: // IN
-               //printf("case IN\n");
-               //printf("IN i:%d from->Io:%g\n", i, from->Io);
-               //printf("IN i:%d from->out:%d\n", i, from->out);
-               //printf("IN i:%d from->to[0]:%p\n", i, from->to[0]);
-               //printf("IN i:%d Io:%g\n", i, Io);
-               if (from->Vo==0) { printf("ERROR: Vo = 0\n"); out=-1; goto done; }
-               ret=calcIN(from, Io);
-               if (ret==1) goto skip; // stop graph exploration to root
-               break;
-            case 1: // SR
-               //printf("case SR\n");
-               //printf("SR i:%d node:%p name:%s from:%p\n", i, nPtr, nPtr->name, from);
-               //printf("SR i:%d from->name:%s\n", i, from->name);
-               //printf("SR i:%d from->Io:%g\n", i, from->Io);
-               //printf("SR i:%d from->out:%d\n", i, from->out);
-               //printf("SR i:%d from->to[0]:%p\n", i, from->to[0]);
-               //printf("SR i:%d from->to[0]->Ii[0]:%g\n", i, from->to[0]->Ii[0]);
-               // discover what is the output that connect to current son
-               //int o=0;
-               //for (; o<MaxOut || from->to[o]==NULL; o++) {
-               //   if (from->to[o]==nPtr) break;
-               //}
-               //printf("SR i:%d o:%d\n", i, o);
-               //printf("SR i:%d Io:%g\n", i, Io);
-               if (from->yeld==0) { printf("ERROR: yeld = 0\n"); out=-1; goto done; }
-               ret=calcSR(from, &Io);
-               if (ret==1) goto skip; // stop graph exploration to root
-               break;
-            case 2: // LR
-               //printf("LR i:%d from->Io:%g\n", i, from->Io);
-               ret=calcLR(from, &Io);
-               if (ret==1) goto skip; // stop graph exploration to root
-               break;
-            case 3: // LD
-               //printf("case LD\n");
-               printf("ERROR: usupported LD on root path\n");
-               return -1;
-               break;
-            case 4: // RS
-               //printf("case RS\n");
-               printf("WARN: RS on root path not fully tested\n");
-               if (from->out==0) { // RS not processed
-                  //printf("RS processing ...\n");
-                  if (from->R[0]>MaxRsValue) { printf("ERROR: RS > %d\n", MaxRsValue); out=-1; goto done; }
-                  ret=calcRS(from, Io, &Vo);
-                  if (missFrom!=NULL) {
-                     //printf("Processing late node...\n");
-                     double I0=0;
-                     if (missFrom->type==1) calcSR(missFrom, &I0);
-                     if (missFrom->type==2) calcLR(missFrom, &I0);
+      }
+      break;
+   case 4: { // RS
+      const double* restrict Io=batchPtr->Io+l;
+      const double* restrict Vo=batchPtr->Vo+l;
+      for (int s=0; s<cnt; s++) {
+         double den=1+R[s]*Go[s];
+         G[s]=den>0 ? Go[s]/den : 0;
+         dI[s]=den>0 ? dIo[s]+G[s]*(Vi[s]-Vo[s]-R[s]*(Io[s]+dIo[s])) : 0;
+      }
+      break;
+   }
+   }
+   if (ctx->plan.type[k]!=3 && ctx->plan.mode[ctx->plan.in[k]]&FixV) {
+      memset(G, 0, cnt*sizeof(double));
+      memset(dI, 0, cnt*sizeof(double));
+   }
+   return;
+} // void batchG(batchTy* batchPtr, int k)
+
+// RS voltage lanes from the input voltage, return the max output change.
+// Lanes still moving more than SolveTol are set in move
+static double batchRSv(batchTy* batchPtr, int k) {
+   int cnt=batchPtr->cnt;
+   size_t l=(size_t)k*cnt, m=BatchInLane(&batchPtr->ctx->plan, k, 0, 0, cnt);
+   batchInputV(batchPtr, k, 0);
+   double* restrict Vo=batchPtr->Vo+l;
+   double* restrict Po=batchPtr->Po+l;
+   double* restrict Pi=batchPtr->Pi+m;
+   const double* restrict Io=batchPtr->Io+l;
+   const double* restrict Go=batchPtr->Go+l;
+   const double* restrict dIo=batchPtr->dIo+l;
+   const double* Vi=batchPtr->Vi+m; // written by batchInputV() above
+   const double* restrict R=batchPtr->R+m;
+   u08* restrict move=batchPtr->move;
+   double dV=0;
+   for (int s=0; s<cnt; s++) { // Newton step, as calcRSv()
+      double RG=R[s]*Go[s];
+      RG=1+RG>0 ? RG : 0;
+      double V=(Vi[s]-R[s]*(Io[s]+dIo[s])+RG*Vo[s])/(1+RG);
+      double d=V-Vo[s];
+      d=d<0 ? -d : d;
+      dV=d>dV ? d : dV;
+      move[s]|=d>SolveTol;
+      Vo[s]=V;
+      Po[s]=V*Io[s];
+      Pi[s]=Vi[s]*Io[s];
+   }
+   return dV;
+} // double batchRSv(batchTy* batchPtr, int k)
+
+// calc all scenarios on the compiled plan, same sweep of calcNodes() done
+// on lanes: every node loop runs over contiguous scenarios. A lane with no
+// solution is set in fail, as calcNodes() returning -1
+int batchCalc(batchTy* batchPtr) {
+   pbCtx* ctx=batchPtr ? batchPtr->ctx : NULL;
+   if (ctx==NULL || !ctx->plan.valid || batchPtr->nodes!=ctx->plan.nodes) {
+      printf("ERROR: batch not initialized on current plan\n");
+      return -1;
+   }
+   int cnt=batchPtr->cnt;
+   memset(batchPtr->fail, 0, cnt);
+   if (ctx->plan.hasRS) { // start with no voltage drop on RS
+      for (int k=1; k<ctx->plan.nodes; k++) {
+         if (ctx->plan.type[k]!=4) continue;
+         batchInputV(batchPtr, k, 0);
+         memcpy(batchPtr->Vo+(size_t)k*cnt, batchPtr->Vi+BatchInLane(&ctx->plan, k, 0, 0, cnt), cnt*sizeof(double));
+      }
+   }
+   int iter=0;
+   double dV;
+   do {
+      for (int k=ctx->plan.nodes-1; k>=0; k--) { // leaves to root
+         size_t l=(size_t)k*cnt, m=BatchInLane(&ctx->plan, k, 0, 0, cnt);
+         // Io, Vi are also written by batchChildI(), batchInputV() and Vi,
+         // Ii, R, n read by batchG(): no restrict on them
+         double* restrict Vo=batchPtr->Vo+l;
+         double* Io=batchPtr->Io+l;
+         double* restrict Po=batchPtr->Po+l;
+         double* restrict Pd=batchPtr->Pd+l;
+         double* Vi=batchPtr->Vi+m;
+         double* Ii=batchPtr->Ii+m;
+         double* restrict Pi=batchPtr->Pi+m;
+         double* R=batchPtr->R+m;
+         double* n=batchPtr->yeld+l;
+         const double* restrict Iadj=batchPtr->Iadj+l;
+         switch (ctx->plan.type[k]) {
+         case 0: // IN
+            batchChildI(batchPtr, k);
+            for (int s=0; s<cnt; s++) Po[s]=Vo[s]*Io[s];
+            break;
+         case 1: // SR
+            batchChildI(batchPtr, k);
+            batchInputV(batchPtr, k, 0);
+            if (ctx->plan.eff[k]) { // n at the load of every scenario
+               const effTy* e=ctx->plan.eff[k];
+               for (int s=0; s<cnt; s++) n[s]=effLookup(e, Io[s], Vi[s]);
+            }
+            for (int s=0; s<cnt; s++) {
+               Po[s]=Vo[s]*Io[s];
+               if (n[s]==0) { // as calcNodes(): no solution
+                  batchPtr->fail[s]=1;
+                  Pd[s]=Pi[s]=Ii[s]=0;
+                  continue;
+               }
+               Pd[s]=Po[s]*(1/n[s]-1);
+               Pi[s]=Po[s]/n[s];
+               Ii[s]=Vi[s]!=0 ? Pi[s]/Vi[s] : 0;
+            }
+            break;
+         case 2: // LR
+            batchChildI(batchPtr, k);
+            batchInputV(batchPtr, k, 0);
+            for (int s=0; s<cnt; s++) {
+               Po[s]=Vo[s]*Io[s];
+               Ii[s]=Io[s]+Iadj[s];
+               Pd[s]=Io[s]*(Vi[s]-Vo[s])+Iadj[s]*Vi[s];
+               Pi[s]=Vi[s]*Ii[s];
+            }
+            break;
+         case 3: // LD
+            for (int s=0; s<cnt; s++) Pd[s]=0;
+            for (int i=0; i<PlanIns(&ctx->plan, k); i++) {
+               int mi=ctx->plan.in[k]+i;
+               if (ctx->plan.up[mi]<0) continue; // no input connection
+               batchInputV(batchPtr, k, i);
+               double* V=Vi+(size_t)i*cnt;
+               double* I=Ii+(size_t)i*cnt;
+               double* r=R+(size_t)i*cnt;
+               double* restrict P=Pi+(size_t)i*cnt;
+               if (ctx->plan.mode[mi]&LdI) { // know V,I ==> R,P
+                  for (int s=0; s<cnt; s++) r[s]=I[s]!=0 ? V[s]/I[s] : 0;
+               } else if (ctx->plan.mode[mi]&LdR) { // know V,R ==> I,P
+                  for (int s=0; s<cnt; s++) I[s]=r[s]!=0 ? V[s]/r[s] : 0;
+               } else if (ctx->plan.mode[mi]&LdP) { // know V,P ==> I,R
+                  for (int s=0; s<cnt; s++) {
+                     I[s]=V[s]!=0 ? P[s]/V[s] : 0;
+                     r[s]=I[s]!=0 ? V[s]/I[s] : 0;
                   }
-               } else {
-                  //printf("RS already processed, skip\n");
                }
-               break;
-            default:
-               printf("ERROR: unsupported type:%d\n", type);
-               return -1;
-            } // switch (type)
-            //printf("s:%d node:'%s'\n", s, nPtr->name);
-            //printf("going up following node:'%s' input i:%d\n", nPtr->name, i);
-            from=from->from[0];
-         } // while (from!=NULL)
-         skip: // stop graph exploration to root
-         //printf("s:%d node:'%s' input:%d check next input\n", s, nPtr->name, i);
-      } // for (int i=0; i<MaxIns; i++) // for every load input
-      //printf("s:%d node:'%s' check next node\n", s, nPtr->name);
-   } // for (int s=0; s<sect; s++) // INI sections = # nodes
-   done:
-   printf("done\n");
-   printf("\n");
-   return out;
-} // int calcNodes();
+               for (int s=0; s<cnt; s++) {
+                  P[s]=V[s]*I[s];
+                  Pd[s]+=P[s]; // total dissipation
+               }
+            }
+            break;
+         case 4: // RS
+            batchChildI(batchPtr, k);
+            for (int s=0; s<cnt; s++) {
+               Ii[s]=Io[s];
+               Pd[s]=R[s]*Io[s]*Io[s];
+            }
+            break;
+         default:
+            printf("ERROR: unsupported type:%d\n", ctx->plan.type[k]);
+            return -1;
+         } // switch (type)
+         if (ctx->plan.hasRS) batchG(batchPtr, k);
+      }
+      dV=0;
+      if (!ctx->plan.hasRS) break;
+      memset(batchPtr->move, 0, cnt);
+      for (int k=1; k<ctx->plan.nodes; k++) { // root to leaves: RS voltages
+         if (ctx->plan.type[k]!=4) continue;
+         double d=batchRSv(batchPtr, k);
+         if (d>dV) dV=d;
+      }
+      iter++;
+   } while (dV>SolveTol && iter<MaxSolveIter);
+   if (dV>SolveTol) { // lanes past the max power a RS can carry
+      for (int s=0; s<cnt; s++) batchPtr->fail[s]|=batchPtr->move[s];
+   }
+   return 0;
+} // int batchCalc(batchTy* batchPtr)
 
-int showStructData() {
+// copy inputs and results of scenario s into the nodes, as calcNodes() does.
+// -1 when the scenario has no solution
+int batchStore(batchTy* batchPtr, int s) {
+   pbCtx* ctx=batchPtr ? batchPtr->ctx : NULL;
+   if (ctx==NULL || s<0 || s>=batchPtr->cnt || batchPtr->nodes!=ctx->plan.nodes) return -1;
+   if (batchPtr->fail[s]) return -1;
+   int cnt=batchPtr->cnt;
+   for (int k=0; k<ctx->plan.nodes; k++) {
+      nTy* node=ctx->plan.node[k];
+      size_t l=(size_t)k*cnt+s;
+      *node->Vo=batchPtr->Vo[l];
+      *node->yeld=batchPtr->yeld[l];
+      *node->Iadj=batchPtr->Iadj[l];
+      *node->Io=batchPtr->Io[l];
+      *node->Po=batchPtr->Po[l];
+      *node->Pd=batchPtr->Pd[l];
+      for (int i=0; i<PlanIns(&ctx->plan, k); i++) {
+         size_t m=BatchInLane(&ctx->plan, k, i, s, cnt);
+         node->Vi[i]=batchPtr->Vi[m];
+         node->Ii[i]=batchPtr->Ii[m];
+         node->R[i]=batchPtr->R[m];
+         node->Pi[i]=batchPtr->Pi[m];
+      }
+      if (ctx->plan.type[k]==1 || ctx->plan.type[k]==2 || ctx->plan.type[k]==4) *node->DV=node->Vi[0]-*node->Vo;
+   }
+   return 0;
+} // int batchStore(batchTy* batchPtr, int s)
+
+int pbShowStructData(pbCtx* ctx) {
    // show struct data
    printf("show struct data\n");
-   int sect=nList.nodeCnt;
-   nTy* nPtr=nList.first;
-   for (int s=0; s<sect; s++, nPtr=nPtr->next) { // INI sections = # nodes
-      char nodeName[5];
+   int sect=ctx->nList.nodeCnt;
+   nTy* nPtr=nListFirst(&ctx->nList);
+   for (int s=0; s<sect; s++, nPtr=nListNext(&ctx->nList, nPtr)) { // INI sections = # nodes
+      const char* nodeName=nPtr->name;
       if (nPtr->type==-1) continue; // skip BOARD
       printf("node:%d\n", s);
-      printf("ptr addr:%p\n", nPtr);
-      strcpy(nodeName, nPtr->name);
+      printf("ptr addr:%p ix:%d\n", nPtr, nPtr->ix);
       printf("node:'%s' key:type=%d\n", nodeName, nPtr->type);
       printf("node:'%s' key:label='%s'\n", nodeName, nPtr->label);
       printf("node:'%s' key:refdes='%s'\n", nodeName, nPtr->refdes);
-      for (int i=0; i<MaxIns; i++) {
-         if (nPtr->from[i]==NULL) continue; // here break is better
-         printf("node:'%s' key:from[%d]=%p\n", nodeName, i, nPtr->from[i]);
+      for (int i=0; i<nPtr->ins; i++) {
+         if (nPtr->from[i]<0) continue; // here break is better
+         printf("node:'%s' key:from[%d]=%d\n", nodeName, i, nPtr->from[i]);
          printf("node:'%s' key:Vi[%d]  =%g\n", nodeName, i, nPtr->Vi[i]);
          printf("node:'%s' key:Ii[%d]  =%g\n", nodeName, i, nPtr->Ii[i]);
          printf("node:'%s' key:R[%d]   =%g\n", nodeName, i, nPtr->R[i]);
          printf("node:'%s' key:Pi[%d]  =%g\n", nodeName, i, nPtr->Pi[i]);
       }
-      printf("node:'%s' key:Iadj=%g\n", nodeName, nPtr->Iadj);
-      printf("node:'%s' key:yeld=%g\n", nodeName, nPtr->yeld);
-      printf("node:'%s' key:DV  =%g\n", nodeName, nPtr->DV);
-      printf("node:'%s' key:Pd  =%g\n", nodeName, nPtr->Pd);
-      printf("node:'%s' key:Vo  =%g\n", nodeName, nPtr->Vo);
-      printf("node:'%s' key:Io  =%g\n", nodeName, nPtr->Io);
-      printf("node:'%s' key:Po  =%g\n", nodeName, nPtr->Po);
-      for (int t=0; t<MaxOut; t++) {
-         if (nPtr->to[t]!=NULL) 
-         printf("node:'%s' key:to[%d]  =%p\n", nodeName, t, nPtr->to[t]);
+      printf("node:'%s' key:Iadj=%g\n", nodeName, *nPtr->Iadj);
+      printf("node:'%s' key:yeld=%g\n", nodeName, *nPtr->yeld);
+      printf("node:'%s' key:DV  =%g\n", nodeName, *nPtr->DV);
+      printf("node:'%s' key:Pd  =%g\n", nodeName, *nPtr->Pd);
+      printf("node:'%s' key:Vo  =%g\n", nodeName, *nPtr->Vo);
+      printf("node:'%s' key:Io  =%g\n", nodeName, *nPtr->Io);
+      printf("node:'%s' key:Po  =%g\n", nodeName, *nPtr->Po);
+      if (ctx->plan.valid && nPtr->pix>=0) { // children from the plan
+         int k=nPtr->pix;
+         for (int e=ctx->plan.first[k]; e<ctx->plan.first[k+1]; e++) {
+            printf("node:'%s' key:to[%d]  =%d\n", nodeName, e-ctx->plan.first[k], ctx->plan.node[ctx->plan.child[e]]->ix);
+         }
       }
       printf("node:'%s' key:out =%d\n", nodeName, nPtr->out);
       printf("\n");
    }
    return 0;
-} // int showStructData()
+} // int pbShowStructData(pbCtx* ctx)
 
-int clearNodes() { // clear node Vi, Pd and Io
+int pbClearNodes(pbCtx* ctx) { // clear node Vi, Pd and Io
    printf("clear node ...\n");
-   int sect=nList.nodeCnt;
-   nTy* nPtr=nList.first;
-   for (int s=0; s<sect; s++, nPtr=nPtr->next) { // INI sections = # nodes
+   int sect=ctx->nList.nodeCnt;
+   nTy* nPtr=nListFirst(&ctx->nList);
+   for (int s=0; s<sect; s++, nPtr=nListNext(&ctx->nList, nPtr)) { // INI sections = # nodes
       if (nPtr->type==-1) continue; // board
-      for (int i=0; i<MaxIns; i++) {
+      for (int i=0; i<nPtr->ins; i++) {
          nPtr->Vi[i]=0;
       }
-      nPtr->Pd=0;
-      nPtr->Io=0;
-      nPtr->Po=0;
+      *nPtr->Pd=0;
+      *nPtr->Io=0;
+      *nPtr->Po=0;
    }
    return 0;
 }
 
-int saveINI(char* fileName) {
-   char bufferPtr[5000]="";
-   int nodes=nList.nodeCnt;
-   printf("Writing sections:%d to INI file:'%s'\n", nodes, fileName);
-   int out=0;
-   //out+=sprintf(bufferPtr+out, "[BOARD]\n");
-   //out+=sprintf(bufferPtr+out, "label=%s\n", "ES3");
-   //out+=sprintf(bufferPtr+out, "\n");
-   nTy* nPtr=nList.first;
-   for (int n=0; n<nodes; n++, nPtr=nPtr->next) {
+// "key=value\n" of a double, key followed by i when not negative
+static void outKey(outTy* outPtr, const char* keyPtr, int i, double val) {
+   if (i>=0) outFmt(outPtr, "%s%d=", keyPtr, i);
+   else {
+      outStr(outPtr, keyPtr);
+      outMem(outPtr, "=", 1);
+   }
+   outDbl(outPtr, val);
+   outMem(outPtr, "\n", 1);
+   return;
+} // void outKey(outTy* outPtr, const char* keyPtr, int i, double val)
+
+// "key={v0,v1,...}\n" of a double vector
+static void outVec(outTy* outPtr, const char* keyPtr, const double* valPtr, int cnt) {
+   outStr(outPtr, keyPtr);
+   outMem(outPtr, "={", 2);
+   for (int c=0; c<cnt; c++) {
+      if (c) outMem(outPtr, ",", 1);
+      outDbl(outPtr, valPtr[c]);
+   }
+   outMem(outPtr, "}\n", 2);
+   return;
+} // void outVec(outTy* outPtr, const char* keyPtr, const double* valPtr, int cnt)
+
+// write the design with results as INI, streamed in OutLen chunks. Values
+// are the shortest decimal read back to the same double, so a result file
+// load again bit exact
+int pbSaveINI(pbCtx* ctx, char* fileName) {
+   int nodes=ctx->nList.nodeCnt;
+   if (PbLev(ctx)>=PRINTF) printf("Writing sections:%d to INI file:'%s'\n", nodes, fileName);
+   outTy out;
+   if (openOut(fileName, &out, OutLen)!=OK) {
+      printf("Cannot write file:'%s'. Quit\n", fileName);
+      return -1;
+   }
+   nTy* nPtr=nListFirst(&ctx->nList);
+   for (int n=0; n<nodes; n++, nPtr=nListNext(&ctx->nList, nPtr)) {
       int type=nPtr->type;
-      out+=sprintf(bufferPtr+out, "[%s]\n", nPtr->name);
-      out+=sprintf(bufferPtr+out, "label=%s\n", nPtr->label);
+      outFmt(&out, "[%s]\n", nPtr->name);
+      outFmt(&out, "label=%s\n", nPtr->label);
       if (type!=-1 && type!=0) { // no BOARD and IN
-         out+=sprintf(bufferPtr+out, "refdes=%s\n", nPtr->refdes);
+         outFmt(&out, "refdes=%s\n", nPtr->refdes);
       }
       if (type==3) { // LDx
-         for (int i=0; i<MaxIns; i++) {
-            if (nPtr->from[i]==NULL) continue; // LDx can have more than one
-            out+=sprintf(bufferPtr+out, "f%d=%s\n", i, nPtr->in[i]);
-            out+=sprintf(bufferPtr+out, "V%d=%g\n", i, nPtr->Vi[i]);
-            out+=sprintf(bufferPtr+out, "I%d=%g\n", i, nPtr->Ii[i]);
-            out+=sprintf(bufferPtr+out, "R%d=%g\n", i, nPtr->R[i]);
-            out+=sprintf(bufferPtr+out, "P%d=%g\n", i, nPtr->Pi[i]);
+         for (int i=0; i<nPtr->ins; i++) {
+            if (nPtr->from[i]<0) continue; // LDx can have more than one
+            outFmt(&out, "f%d=%s\n", i, nPtr->in[i]);
+            outKey(&out, "V", i, nPtr->Vi[i]);
+            outKey(&out, "I", i, nPtr->Ii[i]);
+            outKey(&out, "R", i, nPtr->R[i]);
+            outKey(&out, "P", i, nPtr->Pi[i]);
+            for (int p=0; p<ctx->profList.cnt; p++) { // res file is in current dir
+               profTy* profPtr=&ctx->profList.prof[p];
+               if (profPtr->node!=nPtr || profPtr->input!=i) continue;
+               outFmt(&out, "prof%d=%s\n", i, profPtr->fileName);
+               if (profPtr->kind!=ProfCsv) outKey(&out, "dt", i, profPtr->dt);
+            }
+            for (int o=0; o<ctx->optList.cnt; o++) {
+               optTy* optPtr=&ctx->optList.opt[o];
+               if (optPtr->node!=nPtr || optPtr->kind!=OptFeed || optPtr->input!=i) continue;
+               outFmt(&out, "f%dopt=%s\n", i, optPtr->names);
+            }
          }
       } else if (type!=-1 && type!=0) { // no BOARD and IN and LDx
-         out+=sprintf(bufferPtr+out, "f0=%s\n", nPtr->in[0]);
-         out+=sprintf(bufferPtr+out, "Vi=%g\n", nPtr->Vi[0]);
-         out+=sprintf(bufferPtr+out, "Ii=%g\n", nPtr->Ii[0]);
-         out+=sprintf(bufferPtr+out, "Pi=%g\n", nPtr->Pi[0]);
+         outFmt(&out, "f0=%s\n", nPtr->in[0]);
+         outKey(&out, "Vi", -1, nPtr->Vi[0]);
+         outKey(&out, "Ii", -1, nPtr->Ii[0]);
+         outKey(&out, "Pi", -1, nPtr->Pi[0]);
+         if (type==4) outKey(&out, "R", -1, nPtr->R[0]); // RS
+         for (int o=0; o<ctx->optList.cnt; o++) {
+            optTy* optPtr=&ctx->optList.opt[o];
+            if (optPtr->node==nPtr && optPtr->kind==OptFeed) outFmt(&out, "f0opt=%s\n", optPtr->names);
+         }
       }
       if (type!=-1 && type!=0) { // no BOARD and IN
          if (type!=3) { // no LOAD
-            out+=sprintf(bufferPtr+out, "DV=%g\n", nPtr->DV);
+            outKey(&out, "DV", -1, *nPtr->DV);
+            if (nPtr->DVmin!=0) outKey(&out, "DVmin", -1, nPtr->DVmin);
             if (!strncasecmp(nPtr->name, "SR", 2)) {
-               out+=sprintf(bufferPtr+out, "n=%g\n", nPtr->yeld);
+               outKey(&out, "n", -1, *nPtr->yeld);
+               if (nPtr->eff) outFmt(&out, "eff=\"%s\"\n", nPtr->eff->src);
             } else {
-               out+=sprintf(bufferPtr+out, "Iadj=%g\n", nPtr->Iadj);
+               outKey(&out, "Iadj", -1, *nPtr->Iadj);
+            }
+         }
+         outKey(&out, "Pd", -1, *nPtr->Pd);
+         for (int h=0; h<ctx->thermList.cnt; h++) {
+            thermTy* thPtr=&ctx->thermList.therm[h];
+            if (thPtr->node!=nPtr) continue;
+            outKey(&out, "Rth", -1, thPtr->Rth);
+            outKey(&out, "Ta", -1, thPtr->Ta);
+            outKey(&out, "Tmax", -1, thPtr->Tmax);
+            outKey(&out, "tc", -1, thPtr->tc);
+         }
+         for (int o=0; o<ctx->optList.cnt; o++) {
+            optTy* optPtr=&ctx->optList.opt[o];
+            if (optPtr->node!=nPtr || optPtr->kind==OptFeed) continue;
+            if (optPtr->kind==OptType) {
+               outKey(&out, (type==1) ? "asLR" : "asSR", -1, optPtr->val[0]);
+               continue;
             }
+            outVec(&out, "Voopt", optPtr->val, optPtr->cnt);
          }
-         out+=sprintf(bufferPtr+out, "Pd=%g\n", nPtr->Pd);
       }
       if (type==0) { // IN
-         out+=sprintf(bufferPtr+out, "V=%g\n", nPtr->Vo);
-         out+=sprintf(bufferPtr+out, "I=%g\n", nPtr->Io);
-         out+=sprintf(bufferPtr+out, "P=%g\n", nPtr->Po);
+         outKey(&out, "V", -1, *nPtr->Vo);
+         outKey(&out, "I", -1, *nPtr->Io);
+         outKey(&out, "P", -1, *nPtr->Po);
+         if (ctx->bat.cap>0) { // battery
+            outKey(&out, "Cap", -1, ctx->bat.cap);
+            outKey(&out, "SOC0", -1, ctx->bat.soc0);
+            outKey(&out, "Rint", -1, ctx->bat.Rint);
+            outKey(&out, "Vcut", -1, ctx->bat.Vcut);
+            outKey(&out, "dt", -1, ctx->bat.dt);
+            outVec(&out, "SOC", ctx->bat.soc.x, ctx->bat.soc.cnt);
+            outVec(&out, "Voc", ctx->bat.Voc, ctx->bat.soc.cnt);
+         }
       } else if (type!=-1 && type!=3) { // LDx
-         out+=sprintf(bufferPtr+out, "Vo=%g\n", nPtr->Vo);
-         out+=sprintf(bufferPtr+out, "Io=%g\n", nPtr->Io);
-         out+=sprintf(bufferPtr+out, "Po=%g\n", nPtr->Po);
+         outKey(&out, "Vo", -1, *nPtr->Vo);
+         outKey(&out, "Io", -1, *nPtr->Io);
+         outKey(&out, "Po", -1, *nPtr->Po);
       }
-      out+=sprintf(bufferPtr+out, "\n");
-      //printf("buffer[%d]:'\n%s\n'\n", i, bufferPtr);
+      outMem(&out, "\n", 1);
    }
-   //printf("\n");
-   //printf("buffer:'\n%s\n'\n", bufferPtr);
-   //int len=sizeof(bufferPtr);
-   //printf("out:%d len:%d\n", out, len);
-   FILE* filePtr=openWrite(fileName);
-   fwrite(bufferPtr, 1, out, filePtr);
-   fclose(filePtr);
-   printf("Written nodes:%d Bytes:%d\n", nodes-1, out);
+   off_t bytes=closeOut(&out);
+   if (bytes<0) {
+      printf("Cannot write file:'%s'. Quit\n", fileName);
+      return -1;
+   }
+   if (PbLev(ctx)>=PRINTF) printf("Written nodes:%d Bytes:%lld\n", nodes-1, (long long)bytes);
    return 0;
-} // int saveINIres(nTy* nPtr, int nodes, char* fileName)
+} // int pbSaveINI(pbCtx* ctx, char* fileName)
 
-int freeMem() {
-   nTy* nPtr=nList.first;
-   //printf("freeMem nPtr:%p\n", nPtr);
-   free(nPtr);
-   iniparser_freedict(graphPtr);
+int pbFreeMem(pbCtx* ctx) {
+   nListInit(&ctx->nList); // one reset, blocks kept for the next load
+   iniFree(&ctx->ini);
+   free(ctx->keyVal);
+   ctx->keyVal=NULL;
+   ctx->keyMax=0;
+   freePlan(&ctx->plan);
+   free(ctx->tolList.tol);
+   memset(&ctx->tolList, 0, sizeof(ctx->tolList));
+   profClear(ctx);
+   free(ctx->profList.prof);
+   batClear(ctx);
+   free(ctx->thermList.therm);
+   memset(&ctx->thermList, 0, sizeof(ctx->thermList));
+   optClear(ctx);
+   free(ctx->optList.opt);
+   memset(&ctx->optList, 0, sizeof(ctx->optList));
+   memset(&ctx->profList, 0, sizeof(ctx->profList));
    return 0;
+} // int pbFreeMem(pbCtx* ctx)
+
+// alloc an empty design: every thread can load, calc and save its own
+pbCtx* pbCtxNew() {
+   pbCtx* ctx=calloc(1, sizeof(pbCtx));
+   if (ctx==NULL) return NULL;
+   nListInit(&ctx->nList);
+   ctx->nList.plan=&ctx->plan;
+   ctx->lev=PRINTALL;
+   return ctx;
+} // pbCtx* pbCtxNew()
+
+void pbCtxFree(pbCtx* ctx) {
+   if (ctx==NULL) return;
+   pbFreeMem(ctx);
+   nListFree(&ctx->nList);
+   free(ctx);
+   return;
+} // void pbCtxFree(pbCtx* ctx)
+
+int loadINI(char* graphFile) {
+   return pbLoadINI(&pbCtxDef, graphFile);
+} // int loadINI(char* graphFile)
+
+int layoutNodes() {
+   return pbLayoutNodes(&pbCtxDef);
+} // int layoutNodes()
+
+int clearNodes() {
+   return pbClearNodes(&pbCtxDef);
+} // int clearNodes()
+
+int compileNodes() {
+   return pbCompileNodes(&pbCtxDef);
+} // int compileNodes()
+
+int calcNodes() {
+   return pbCalcNodes(&pbCtxDef);
+} // int calcNodes()
+
+int showStructData() {
+   return pbShowStructData(&pbCtxDef);
+} // int showStructData()
+
+int saveINI(char* fileName) {
+   return pbSaveINI(&pbCtxDef, fileName);
+} // int saveINI(char* fileName)
+
+int freeMem() {
+   return pbFreeMem(&pbCtxDef);
 } // int freeMem()
@@ -19,61 +19,468 @@
 #ifndef POWERB_H_
 #define POWERB_H_
 
+#include "comType.h"
+#include "fileIo.h"
+
 #define DefCliIniFile    "powerb.ini"     // default filename for input with node graph
 #define DefCliIniResFile "powerb.res.ini" // default filename used as output by the CLI
+#define DefCliLinFile    "powerb.lin.csv" // default filename of the linear load map
 #define DefGuiIniResFile "powerb.GUI.ini" // default filename used as output by the GUI
-#define MaxIns  3 // number of max input supply for a load, count from 0
-#define MaxOut 17 // 16 number of max load for a supply, count from 0
 #define MaxRserie 4 // number of max R in serie
 #define MaxRsValue 10 // maximum Ohmic value for series resistors
+#define MaxSolveIter 50 // max sweeps to settle voltages after RS
+#define SolveTol 1e-9   // V, settled when RS outputs change less than this
+
+#define EffBuckets 256 // max buckets to find an efficiency curve segment
+
+typedef struct effAxTy { // axis of an SR efficiency curve
+    int cnt;      // points given
+    double* x;    // [cnt+1] points, last repeated
+    double* w;    // [cnt] 1/(x[s+1]-x[s]), 0 on last
+    int buckets;  // uniform buckets on [x[0], x[cnt-1]]
+    double scale; // buckets per unit
+    u16* b;       // [buckets] segment at the bucket start
+} effAxTy;
 
-typedef struct nTy { char name[5]; // "IN", "SRxx", "LRxx", "LDxx"
+typedef struct effTy { // SR efficiency n(Io,Vi), bilinear between points
+    effAxTy Io;
+    effAxTy Vi;   // one point when n does not depend on Vi
+    double* n;    // [Vi.cnt+1][Io.cnt+1] efficiency, last row and column repeated
+    char* src;    // eff as read from INI, to save it back
+} effTy;
+
+typedef struct nTy { const char* name; // "IN", "SRxx", "LRxx", "LDxx", any length, interned
                      int type;     // IN=0, SR=1, LR=2, RS=4, LD=3
                      char label[15]; // any user string
                      char refdes[7]; // "Uxx" or "RNxxxx"
-                     struct nTy* from[MaxIns]; // SR,LR,RS has 1, LD up to MaxIns
-                     char in[MaxIns][5]; // used by the GUI
-                     double Vi[MaxIns];
-                     double Ii[MaxIns];
-                     double R[MaxIns];
-                     double Pi[MaxIns];
-                     double yeld;
-                     double Iadj;
-                     double DV;
-                     double Pd;
-                     double Vo;
-                     double Io;
-                     double Po;
-                     struct nTy* to[MaxOut]; // to leaf
-                     int out;
-                     int col; // used for GUI positioning
-                     int row; // used for GUI positioning
-                     struct nTy* prev;
-                     struct nTy* next;
+                     int ins;     // input slots: SR,LR,RS has 1, LD one for every fx key
+                     int inFirst; // first input slot in the pool, the pointers below start there
+                     int* from;   // [ins] pool index of node above, -1 if none
+                     const char** in; // [ins] name of node above, interned, "" if none
+                     double* Vi;  // [ins]
+                     double* Ii;  // [ins]
+                     double* R;   // [ins]
+                     double* Pi;  // [ins]
+                     double* yeld; // the solver values below are views of the pool columns at ix
+                     double* Iadj;
+                     double* DV;
+                     double* Pd;
+                     double* Vo;
+                     double* Io;
+                     double* Po;
+                     effTy* eff; // SR efficiency curve, NULL for constant yeld
+                     double DVmin; // SR,LR least Vi-Vo to keep regulation
+                     int out; // children in the plan
+                     int col; // used for GUI positioning, -1 until pbLayoutNodes()
+                     int row; // used for GUI positioning, -1 until pbLayoutNodes()
+                     int pix; // position in the evaluation plan, -1 if not in
+                     int ix;  // own pool index, -1 when deleted
                    } nTy;
 
-typedef struct nList { // needed to support GUI
-    nTy* first;
-    nTy* last;
-    int nodeCnt;
+#define NodeBlock 64 // nodes in every pool block
+#define NameChunk 4096 // bytes of every block of interned names
+
+typedef struct nameTabTy { // interned names: one copy of every string, nodes found by name
+    const char** str; // [max] open addressing on a case insensitive hash, NULL when free
+    int* ix;          // [max] pool index of the node named exactly str, -1 for none
+    int cnt;          // strings interned
+    int max;          // power of 2, kept at most half full
+    char** chunk;     // [chunks] storage of the strings, NameChunk bytes or one long string
+    int chunks;
+    char* fill;       // next free byte of the chunk in use
+    size_t left;      // bytes free at fill
+} nameTabTy;
+
+typedef struct nList { // node pool, needed to support GUI
+    nTy** block;   // [blocks] of NodeBlock nodes, a node never moves
+    int blocks;
+    int used;      // slots given, in add order, deleted ones too
+    int nodeCnt;   // nodes not deleted
+    int inputs;    // input slots given, in a row for every node
+    int inMax;     // input slots allocated
+    int* from;     // [inMax] input slots of all nodes, as in nTy
+    const char** in; // [inMax]
+    double* Vi;    // [inMax]
+    double* Ii;    // [inMax]
+    double* R;     // [inMax]
+    double* Pi;    // [inMax]
+    int nodeMax;   // node column slots allocated
+    double* yeld;  // [nodeMax] solver values of every node by pool index, as in nTy
+    double* Iadj;  // [nodeMax]
+    double* DV;    // [nodeMax]
+    double* Pd;    // [nodeMax]
+    double* Vo;    // [nodeMax]
+    double* Io;    // [nodeMax]
+    double* Po;    // [nodeMax]
+    nameTabTy names; // node names and the names of their inputs
     int init;
+    int placed;    // col/row filled by pbLayoutNodes(), cleared when nodes change
+    struct planTy* plan; // plan compiled from the list, not valid after links change
 } nListTy;
 
-extern nListTy nList; // double linked list of node values
+#define NodeAt(listPtr,ix) ((ix)<0 ? NULL : &(listPtr)->block[(ix)/NodeBlock][(ix)%NodeBlock]) // node of a pool index
+
+#define FixV 1 // plan mode: input voltage given, not taken from the node above
+#define LdI  2 // plan mode: load input at constant current
+#define LdR  4 // plan mode: load input at constant resistance
+#define LdP  8 // plan mode: load input at constant power
+
+typedef struct planTy { // compiled evaluation plan, built by compileNodes()
+    int nodes;    // nodes in plan, IN first then in topological order
+    int edges;    // links from a node to its children
+    int inputs;   // input slots of all nodes
+    nTy** node;   // plan position ==> node ptr
+    int* type;    // node type, copied for the sweep
+    int* ix;      // [nodes] pool index, the node values are in the nList columns at ix
+    int* slot;    // [nodes] first pool input slot, node k input i is nList column slot[k]+i
+    const effTy** eff; // [nodes] SR efficiency curve, copied for the sweep
+    int* in;      // [nodes+1] first input slot of every node, node k input i is slot in[k]+i
+    int* up;      // [inputs] plan position of node above an input or -1
+    u08* mode;    // [inputs] FixV|LdI|LdR|LdP of every input
+    int* first;   // [nodes+1] first child edge of every node
+    int* child;   // [edges] plan position of the child
+    int* input;   // [edges] child input fed by the edge
+    double* G;    // [inputs] dIi/dVi of every input, Newton step on RS
+    double* Go;   // [nodes] dIo/dVo, sum of G of the children
+    double* dI;   // [nodes] RS input current moved to its own Newton solution
+    double* dIo;  // [nodes] sum of dI of the children
+    int hasRS;    // RS need voltages to come down after currents went up
+    int valid;    // 0 when links changed and a new compile is needed
+    int solved;   // all nodes calculated, pbSolve() can calc only dirty ones
+    u08* dirty;   // [nodes] node changed by pbSet...() since last calc
+    int* dirtyList; // [nodes] plan position of dirty nodes
+    int dirtyCnt;
+} planTy;
+
+#define PlanIns(planPtr,k) ((planPtr)->in[(k)+1]-(planPtr)->in[k]) // input slots of plan node k
+
+struct pbCtx;
+
+typedef struct batchTy { // N scenarios on the plan, every field [node][cnt]
+    struct pbCtx* ctx; // design of the plan
+    int cnt;      // scenarios, lanes of every field
+    int nodes;    // plan nodes
+    double* Vo;   // [nodes][cnt] IN V and regulator Vo, result for RS
+    double* yeld; // [nodes][cnt] SR efficiency, result with eff curve
+    double* Iadj; // [nodes][cnt] LR adjust current
+    double* Io;   // [nodes][cnt] result
+    double* Po;   // [nodes][cnt] result
+    double* Pd;   // [nodes][cnt] result
+    double* Vi;   // [inputs][cnt] given when FixV, else result
+    double* Ii;   // [inputs][cnt] LD given when LdI, else result
+    double* R;    // [inputs][cnt] RS, LD given when LdR, else result
+    double* Pi;   // [inputs][cnt] LD given when LdP, else result
+    double* G;    // [inputs][cnt] dIi/dVi, only when plan has RS
+    double* Go;   // [nodes][cnt] dIo/dVo, only when plan has RS
+    double* dI;   // [nodes][cnt] RS Newton current correction, only with RS
+    double* dIo;  // [nodes][cnt] sum of dI of the children, only with RS
+    u08* fail;    // [cnt] 1 when the scenario has no solution, set by batchCalc()
+    u08* move;    // [cnt] RS voltage still moving in the last sweep, only with RS
+} batchTy;
+
+typedef struct linTy { // affine map of LD currents to node currents and powers
+    int loads;   // columns: LD inputs at constant current
+    int rows;    // 2 for IN and every regulator: input current, then P or Pd
+    int* load;   // [loads] plan input slot in[k]+i of every column
+    int* node;   // [rows/2] plan node of every row pair
+    double* c0;  // [rows] value with all the column currents at 0
+    double* T;   // [rows][loads] d row / d column current
+} linTy;
+
+#define TolVo   0 // tolerance of regulator Vo or IN V
+#define TolYeld 1 // tolerance of SR n
+#define TolIadj 2 // tolerance of LR Iadj
+#define TolR    3 // tolerance of RS R or LD Rx
+#define TolIi   4 // tolerance of LD Ix
+#define TolPi   5 // tolerance of LD Px
+#define TolUniform 0 // flat inside +-tol
+#define TolNormal  1 // gaussian, +-tol is 3 sigma, cut at +-tol
+
+typedef struct tolTy { // tolerance after a value: "I0=0.528 ±10% normal"
+    nTy* node;
+    int field;  // TolVo, TolYeld, TolIadj, TolR, TolIi, TolPi
+    int input;  // LD input, 0 for others
+    double nom; // nominal value
+    double tol; // +- as fraction of nom when rel, else absolute
+    int rel;    // tol given in %
+    int dist;   // TolUniform or TolNormal
+} tolTy;
+
+typedef struct tolListTy { // tolerances found by loadINI()
+    int cnt;
+    int max;
+    tolTy* tol;
+} tolListTy;
+
+#define ProfCsv 0 // load profile as "time,current" text lines
+#define ProfF32 1 // load profile as binary float array, a sample every dt
+#define ProfF64 2 // load profile as binary double array, a sample every dt
+
+typedef struct profTy { // load current waveform of a LD input: "prof0=ld1.csv"
+    nTy* node;
+    int input;      // LD input fed by the profile
+    int kind;       // ProfCsv, ProfF32, ProfF64
+    double dt;      // s between binary samples
+    char* fileName; // with the INI directory when relative
+} profTy;
+
+typedef struct profListTy { // load profiles found by loadINI()
+    int cnt;
+    int max;
+    profTy* prof;
+} profListTy;
+
+typedef struct batTy { // battery as IN: "Cap=2.6" Ah, V from SOC "Voc={...}"
+    double cap;   // Ah, 0 when IN is a fixed voltage
+    double soc0;  // state of charge at start, 0..1
+    double Rint;  // ohm internal resistance
+    double Vcut;  // V at the IN pins ending the runtime
+    double dt;    // s step without load profiles
+    effAxTy soc;  // state of charge points of the discharge curve
+    double* Voc;  // [soc.cnt+1] open circuit V, last repeated
+} batTy;
+
+#define TcRef 25 // C where n, Iadj, R and loads have the INI value
+
+typedef struct thermTy { // thermal data of a node: "Rth=40" junction to ambient
+    nTy* node;
+    double Rth;  // C/W theta_ja
+    double Ta;   // C ambient, BOARD Ta when not given
+    double Tmax; // C max junction
+    double tc;   // 1/C change from TcRef of SR n, LR Iadj, RS R or LD load
+    double Tj;   // C junction, by thermalSolve()
+} thermTy;
+
+typedef struct thermListTy { // nodes with thermal data, found by loadINI()
+    int cnt;
+    int max;
+    thermTy* therm;
+} thermListTy;
+
+#define OptVo   0 // candidate output voltages of a regulator: "Voopt={1.8,2.5}"
+#define OptType 1 // SR built as LR "asLR=0.002" Iadj, LR built as SR "asSR=0.9" n
+#define OptFeed 2 // other nodes that may feed a LD input or a SR, LR, RS: "f0opt=LR2,SR1"
+#define OptGoalPd 0 // optimize() minimum total Pd of regulators and RS
+#define OptGoalP  1 // optimize() minimum IN power
+
+typedef struct optTy { // alternative of the design, searched by optimize()
+    nTy* node;
+    int kind;    // OptVo, OptType, OptFeed
+    int input;   // input of OptFeed, 0 for others
+    int cnt;     // values of OptVo, 1 for OptType, nodes of OptFeed
+    double* val; // [cnt] Vo of OptVo, Iadj or n of OptType
+    char* names; // OptFeed node names as in file, comma separated
+} optTy;
+
+typedef struct optListTy { // design alternatives found by loadINI()
+    int cnt;
+    int max;
+    optTy* opt;
+} optListTy;
+
+typedef struct pbCtx { // a design: its nodes, INI file and analysis data
+    nListTy nList;      // pool of node values
+    iniTy ini;          // INI file split in sections and keys, kept for reloads
+    char** keyVal;      // [keyMax] values of the known keys of the section being loaded
+    int keyMax;
+    planTy plan;        // compiled evaluation plan of nList
+    tolListTy tolList;  // tolerances of nList values
+    profListTy profList; // load profiles of nList LD
+    batTy bat;          // battery of IN
+    thermListTy thermList; // thermal data of nList nodes
+    optListTy optList;  // design alternatives of nList nodes
+    u08 lev;            // print level cap of the design, lowered by analysis loops
+    const char* tag;    // printed before the warnings and errors of the design, NULL for none
+} pbCtx;
+
+extern pbCtx pbCtxDef; // design of the compatibility calls: loadINI(), calcNodes() ...
+
+#define PbLev(ctx) (dbgLev<(ctx)->lev ? dbgLev : (ctx)->lev) // print level of a design
+#define PbTag(ctx) ((ctx)->tag ? (ctx)->tag : "") // tag of a design, "" for none
+
+typedef struct ivTy { // interval [lo, hi] of a value
+    double lo;
+    double hi;
+} ivTy;
+
+typedef struct ivNodeTy { // bounds of the values of a plan node, as in nTy
+    ivTy* Vi;     // [inputs of the node]
+    ivTy* Ii;
+    ivTy* R;
+    ivTy* Pi;
+    ivTy yeld;
+    ivTy Iadj;
+    ivTy Pd;
+    ivTy Vo;
+    ivTy Io;
+    ivTy Po;
+} ivNodeTy;
+
+// segment of an efficiency axis holding v, clamped to the ends, and the
+// fraction f of v in it. Buckets are not wider than segments: no search
+static inline int effSeg(const effAxTy* a, double v, double* fPtr) {
+   v=v>a->x[0] ? v : a->x[0];
+   v=v<a->x[a->cnt-1] ? v : a->x[a->cnt-1];
+   int j=(int)((v-a->x[0])*a->scale);
+   j=j<a->buckets-1 ? j : a->buckets-1;
+   int s=a->b[j];
+   while (v>a->x[s+1]) s++; // at most once but with EffBuckets reached
+   *fPtr=(v-a->x[s])*a->w[s];
+   return s;
+} // int effSeg(const effAxTy* a, double v, double* fPtr)
+
+// SR efficiency at Io,Vi from its curve: bilinear, clamped to the curve ends
+static inline double effLookup(const effTy* e, double Io, double Vi) {
+   double x, y;
+   int ix=effSeg(&e->Io, Io, &x), iy=effSeg(&e->Vi, Vi, &y);
+   const double* n0=e->n+iy*(e->Io.cnt+1)+ix;
+   const double* n1=n0+e->Io.cnt+1;
+   double a=n0[0]+(n0[1]-n0[0])*x;
+   double b=n1[0]+(n1[1]-n1[0])*x;
+   return a+(b-a)*y;
+} // double effLookup(const effTy* e, double Io, double Vi)
+
+// battery open circuit voltage at a state of charge, linear between points
+static inline double batVoc(const batTy* batPtr, double soc) {
+   double f;
+   int s=effSeg(&batPtr->soc, soc, &f);
+   return batPtr->Voc[s]+(batPtr->Voc[s+1]-batPtr->Voc[s])*f;
+} // double batVoc(const batTy* batPtr, double soc)
+
+#define BatchLane(k,s,cnt)   ((size_t)(k)*(cnt)+(s))            // node k lane s
+#define BatchInLane(planPtr,k,i,s,cnt) (((size_t)(planPtr)->in[k]+(i))*(cnt)+(s)) // node k input i lane s
+
+
+void nListInit(nListTy* nListPtr); // init the node pool, empty it keeping the blocks when used
+
+nTy* nListAdd(nListTy* nListPtr); // add an empty node to the pool as last element, return its pointer
+
+void nListDel(nListTy* nListPtr, nTy* nodePtr); // delete a node from the pool, links to it cleared
+
+int nListInputs(nListTy* nListPtr, nTy* nodePtr, int ins); // give a node ins input slots, keeping the first ones
+
+nTy* nListFirst(const nListTy* nListPtr); // first node of the pool or NULL
+
+nTy* nListNext(const nListTy* nListPtr, const nTy* nodePtr); // next node in add order or NULL
+
+void nListFree(nListTy* nListPtr); // empty the pool and free its blocks
+
+const char* nListIntern(nListTy* nListPtr, const char* str); // the pool copy of str, NULL when out of memory
+
+int nListName(nListTy* nListPtr, nTy* nodePtr, const char* name); // name a node, found then by nListFind()
+
+nTy* nListFind(nListTy* nListPtr, const char* name); // node by name ignoring case, NULL when none
+
+effTy* effParse(const char* strPtr); // parse SR "Io:{...};n:{...}" curve, NULL on error
+
+void effFree(effTy* effPtr); // free an SR efficiency curve
 
-extern nTy* nPtr; // struct of nodes ptr
+int effAxis(effAxTy* axPtr, const double* x, int cnt); // fill a curve axis with its bucket table
 
+pbCtx* pbCtxNew(); // LIB: alloc an empty design, NULL on error
 
-void nListInit(nListTy* nListPtr); // init the double linked node list
+void pbCtxFree(pbCtx* ctx); // LIB: free a design with its nodes
 
-nTy* nListAdd(nListTy* nListPtr); // add an empty node to the double linked list as last element, return its pointer
+int pbLoadINI(pbCtx* ctx, char* graphFile); // LIB: load INI file in a design, or a compiled .pbc: parse, resolve, validate
 
-void nListDel(nListTy* nListPtr, nTy* nodePtr); // delete a node from the double linked list
+int pbParseINI(pbCtx* ctx, char* graphFile); // LIB: load stage 1, read INI file and fill the nodes, inputs by name
+
+int pbResolveNodes(pbCtx* ctx); // LIB: load stage 2, input names to node links
+
+int pbValidateNodes(pbCtx* ctx); // LIB: load stage 3, every node input chain up to IN, no loops
+
+int pbLayoutNodes(pbCtx* ctx); // LIB: place nodes col/row for the GUI, once after a load. Show graph matrix
+
+int pbLoadPBC(pbCtx* ctx, char* pbcFile); // LIB: load a compiled design, its INI when changed. Called by pbLoadINI()
+
+int pbSavePBC(pbCtx* ctx, char* graphFile, char* pbcFile); // LIB: write a design just loaded from graphFile as compiled .pbc
+
+int pbClearNodes(pbCtx* ctx); // clear node Vi, Pd and Io
+
+int pbCompileNodes(pbCtx* ctx); // LIB: compile nodes in a topological evaluation plan
+
+void freePlan(planTy* planPtr); // free the compiled plan
+
+int pbCalcNodes(pbCtx* ctx); // LIB: calc nodes
+
+void calcG(pbCtx* ctx, int k); // input conductance dIi/dVi of plan node k, its children done before
+
+int pbSetLoadCurrent(pbCtx* ctx, nTy* node, int input, double value); // LIB: set LD current, mark path to IN dirty
+
+int pbSetLoadR(pbCtx* ctx, nTy* node, int input, double value); // LIB: set LD or RS resistance, mark dirty
+
+int pbSetLoadPower(pbCtx* ctx, nTy* node, int input, double value); // LIB: set LD power, mark dirty
+
+int pbSetYeld(pbCtx* ctx, nTy* node, double value); // LIB: set SR efficiency, mark dirty
+
+int pbSetIadj(pbCtx* ctx, nTy* node, double value); // LIB: set LR adjust current, mark dirty
+
+int pbSetVo(pbCtx* ctx, nTy* node, double value); // LIB: set regulator Vo or IN V, mark dirty with nodes below
+
+int pbSolve(pbCtx* ctx); // LIB: calc only the dirty nodes, all when needed
+
+int batchInit(pbCtx* ctx, batchTy* batchPtr, int cnt); // LIB: alloc cnt scenarios filled with node values
+
+int batchCalc(batchTy* batchPtr); // LIB: calc all scenarios of the batch
+
+int batchStore(batchTy* batchPtr, int s); // LIB: copy scenario s in the nodes
+
+void batchFree(batchTy* batchPtr); // LIB: free the batch
+
+int parseTol(const char* strPtr, tolTy* tolPtr); // parse "value ±tol[%] [normal|uniform]"
+
+double tolSample(tolTy* tolPtr, u64 seed, u64 g, u32 t); // value of tolerance t for sample g
+
+double* tolLane(batchTy* batchPtr, tolTy* tolPtr, int s); // batch lane changed by a tolerance
+
+int monteCarlo(pbCtx* ctx, long samples, u64 seed, int threads); // LIB: Monte Carlo tolerance analysis
+
+double tolBound(tolTy* tolPtr, int side); // tolerance value at side -1 low, 0 nominal, +1 high
+
+ivNodeTy* ivAlloc(pbCtx* ctx); // LIB: interval nodes of the compiled plan, free() them
+
+int calcInterval(pbCtx* ctx, ivNodeTy* ivPtr); // LIB: bounds of all plan node values in one pass
+
+int worstCase(pbCtx* ctx, int refine, int threads); // LIB: worst case analysis, refine by split tolerances
+
+int profileEnergy(pbCtx* ctx, int threads); // LIB: stream load profiles, energy and peak power of nodes
+
+int batteryRun(pbCtx* ctx); // LIB: discharge the IN battery over the mission, runtime and dropouts
+
+int thermalSolve(pbCtx* ctx); // LIB: iterate calc and junction temperatures, show Tj and margin
+
+int sensitivity(pbCtx* ctx); // LIB: adjoint derivatives of IN P and regulator Pd by every parameter
+
+int linCompile(pbCtx* ctx, linTy* linPtr); // LIB: compile the affine LD currents map, -1 when nonlinear
+
+void linEval(const linTy* linPtr, const double* I, double* y, int cnt); // LIB: y=c0+T*I of cnt load vectors
+
+void linFree(linTy* linPtr); // LIB: free the linear map
+
+int linearSweep(pbCtx* ctx, char* sweepFile); // LIB: write the linear map, sweep the load vectors of a file
+
+int optimize(pbCtx* ctx, int goal, int threads); // LIB: search the design alternatives for min Pd or IN P
+
+int solveFiles(char** fileList, int files, int threads); // LIB: solve INI files on threads, res files and summary
+
+int serve(char* sockFile); // LIB: solver daemon on a Unix socket, designs kept loaded
+
+int pbShowStructData(pbCtx* ctx); // show struct data
+
+int pbSaveINI(pbCtx* ctx, char* fileName); // LIB: save INI of a design with results
+
+int pbFreeMem(pbCtx* ctx); // LIB: free the nodes and data of a design
+
+// compatibility calls on pbCtxDef, for CLI and GUI
 
 int loadINI(char* graphFile); // LIB: load INI file
 
+int layoutNodes(); // LIB: place nodes col/row for the GUI
+
 int clearNodes(); // clear node Vi, Pd and Io
 
+int compileNodes(); // LIB: compile nodes in a topological evaluation plan
+
 int calcNodes(); // LIB: calc nodes
 
 int showStructData(); // show struct data
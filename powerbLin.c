@@ -0,0 +1,310 @@
+/* PowerBudget v0.00.01a 2024/09/08 calculate power dissipation and budget */
+/* Copyright 2024 Valerio Messina http://users.iol.it/efa              */
+/* powerbLin.c is part of PowerBudget
+   PowerBudget is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   PowerBudget is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with PowerBudget. If not, see <http://www.gnu.org/licenses/>. */
+
+/* powerbLin.c LIB: linear map of the load currents, load vector sweeps */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "powerbLib.h"
+#include "fileIo.h"
+
+#define LinBlock 4096 // load vectors evaluated together
+
+// compile the loaded design in an affine map from the currents of the LD
+// inputs at constant current to input current and Pd of every regulator,
+// and to current and P of IN. With no RS every voltage is fixed: an SR
+// scale its output current by Vo/(n*Vi), a LR add Iadj, so each column is
+// the product of the scales on the path up to IN. Offsets are the design
+// with those currents at 0. Return 0, -1 on error or nonlinear design
+int linCompile(pbCtx* ctx, linTy* linPtr) {
+   memset(linPtr, 0, sizeof(*linPtr));
+   if (!ctx->plan.valid && pbCompileNodes(ctx)!=0) return -1;
+   if (!ctx->plan.solved && pbCalcNodes(ctx)!=0) return -1;
+   int nodes=ctx->plan.nodes;
+   for (int k=0; k<nodes; k++) {
+      nTy* node=ctx->plan.node[k];
+      if (ctx->plan.type[k]==4) {
+         printf("ERROR: RS:'%s' voltage drop moves with the load, not linear\n", node->name);
+         return -1;
+      }
+      if (ctx->plan.type[k]==1 && node->eff) {
+         printf("ERROR: SR:'%s' eff curve moves with the load, not linear\n", node->name);
+         return -1;
+      }
+      if (ctx->plan.type[k]==3) {
+         for (int i=0; i<PlanIns(&ctx->plan, k); i++) {
+            int m=ctx->plan.in[k]+i;
+            if (ctx->plan.up[m]>=0 && ctx->plan.mode[m]&LdI) linPtr->loads++;
+         }
+      } else linPtr->rows+=2; // IN, SR, LR
+   }
+   int loads=linPtr->loads, rows=linPtr->rows;
+   int* rowOf=malloc(nodes*sizeof(int));
+   double* a=malloc(nodes*sizeof(double)); // dIi/dIo
+   double* p=malloc(nodes*sizeof(double)); // dPd/dIo, dP/dIo for IN
+   double* Io0=calloc(nodes, sizeof(double)); // output current at columns 0
+   linPtr->load=malloc((loads ? loads : 1)*sizeof(int));
+   linPtr->node=malloc(rows/2*sizeof(int));
+   linPtr->c0=malloc(rows*sizeof(double));
+   linPtr->T=calloc((size_t)rows*(loads ? loads : 1), sizeof(double));
+   if (!rowOf || !a || !p || !Io0 || !linPtr->load || !linPtr->node || !linPtr->c0 || !linPtr->T) {
+      free(rowOf); free(a); free(p); free(Io0);
+      linFree(linPtr);
+      return -1;
+   }
+   int r=0, j=0;
+   for (int k=0; k<nodes; k++) {
+      nTy* node=ctx->plan.node[k];
+      rowOf[k]=-1;
+      switch (ctx->plan.type[k]) {
+      case 0: // IN
+         a[k]=1;
+         p[k]=*node->Vo;
+         break;
+      case 1: // SR
+         a[k]=*node->Vo/(*node->yeld*node->Vi[0]);
+         p[k]=*node->Vo*(1/(*node->yeld)-1);
+         break;
+      case 2: // LR
+         a[k]=1;
+         p[k]=node->Vi[0]-*node->Vo;
+         break;
+      case 3: // LD
+         for (int i=0; i<PlanIns(&ctx->plan, k); i++) {
+            int m=ctx->plan.in[k]+i;
+            if (ctx->plan.up[m]>=0 && ctx->plan.mode[m]&LdI) linPtr->load[j++]=m;
+         }
+         continue;
+      }
+      rowOf[k]=r;
+      linPtr->node[r]=k;
+      r++;
+   }
+   for (int k=nodes-1; k>=0; k--) { // offsets, leaves to root
+      nTy* node=ctx->plan.node[k];
+      if (ctx->plan.type[k]==3) { // R and P loads draw a fixed current
+         for (int i=0; i<PlanIns(&ctx->plan, k); i++) {
+            int m=ctx->plan.in[k]+i;
+            if (ctx->plan.up[m]>=0 && !(ctx->plan.mode[m]&LdI)) Io0[ctx->plan.up[m]]+=node->Ii[i];
+         }
+         continue;
+      }
+      double* c0=linPtr->c0+2*rowOf[k];
+      c0[0]=a[k]*Io0[k];
+      c0[1]=p[k]*Io0[k];
+      if (ctx->plan.type[k]==2) { // LR
+         c0[0]+=*node->Iadj;
+         c0[1]+=*node->Iadj*node->Vi[0];
+      }
+      if (k>0 && ctx->plan.up[ctx->plan.in[k]]>=0) Io0[ctx->plan.up[ctx->plan.in[k]]]+=c0[0];
+   }
+   for (j=0; j<loads; j++) { // walk every column up to IN
+      int m=linPtr->load[j];
+      double g=1;
+      for (int u=ctx->plan.up[m]; u>=0; u=(u>0) ? ctx->plan.up[ctx->plan.in[u]] : -1) {
+         double* T=linPtr->T+(size_t)2*rowOf[u]*loads+j;
+         T[0]+=g*a[u];
+         T[loads]+=g*p[u];
+         g*=a[u];
+      }
+   }
+   free(rowOf);
+   free(a);
+   free(p);
+   free(Io0);
+   return 0;
+} // int linCompile(pbCtx* ctx, linTy* linPtr)
+
+// y[cnt][rows]=c0+T*I of cnt load vectors I[cnt][loads]
+void linEval(const linTy* linPtr, const double* I, double* y, int cnt) {
+   int loads=linPtr->loads, rows=linPtr->rows;
+   for (int s=0; s<cnt; s++) {
+      const double* x=I+(size_t)s*loads;
+      double* ys=y+(size_t)s*rows;
+      for (int r=0; r<rows; r++) {
+         const double* T=linPtr->T+(size_t)r*loads;
+         double v=linPtr->c0[r];
+         for (int j=0; j<loads; j++) v+=T[j]*x[j];
+         ys[r]=v;
+      }
+   }
+   return;
+} // void linEval(const linTy* linPtr, const double* I, double* y, int cnt)
+
+void linFree(linTy* linPtr) {
+   free(linPtr->load);
+   free(linPtr->node);
+   free(linPtr->c0);
+   free(linPtr->T);
+   memset(linPtr, 0, sizeof(*linPtr));
+   return;
+} // void linFree(linTy* linPtr)
+
+// read the next load vector, as many currents as loads: a text line with
+// values split by ',' ';' or blanks, or binary float or double. Comments
+// and a header line are skipped. Return 1, 0 at end or -1 on error
+static int linRead(pbCtx* ctx, chunkTy* c, int kind, double* I, int loads, u64 n, const char* fileName) {
+   if (kind!=ProfCsv) {
+      size_t size=(kind==ProfF32) ? sizeof(float) : sizeof(double);
+      for (int j=0; j<loads; j++) {
+         if (c->fill-c->pos<size && readChunk(c)<size) {
+            if ((j!=0 || c->fill!=0) && PbLev(ctx)>=PRINTWARN) printf("WARN: sweep:'%s' ends inside a vector\n", fileName);
+            return 0;
+         }
+         if (kind==ProfF32) {
+            float f;
+            memcpy(&f, c->bufPtr+c->pos, sizeof(f));
+            I[j]=f;
+         } else {
+            memcpy(&I[j], c->bufPtr+c->pos, sizeof(double));
+         }
+         c->pos+=size;
+      }
+      return 1;
+   }
+   for (;;) {
+      char* linePtr=c->bufPtr+c->pos;
+      char* endPtr=memchr(linePtr, '\n', c->fill-c->pos);
+      if (endPtr==NULL) {
+         if (!c->eof) {
+            if (c->pos==0 && c->fill==c->size) {
+               printf("ERROR: sweep:'%s' line longer than %zu\n", fileName, c->size);
+               return -1;
+            }
+            readChunk(c);
+            continue;
+         }
+         if (c->pos>=c->fill) return 0;
+         endPtr=c->bufPtr+c->fill;
+      }
+      *endPtr='\0';
+      c->pos=endPtr-c->bufPtr;
+      if (c->pos<c->fill) c->pos++;
+      char* chPtr=linePtr;
+      while (*chPtr==' ' || *chPtr=='\t') chPtr++;
+      if (*chPtr=='#' || *chPtr=='\r' || *chPtr=='\0') continue;
+      int j;
+      for (j=0; j<loads; j++) {
+         char* numPtr;
+         I[j]=strtod(chPtr, &numPtr);
+         if (numPtr==chPtr) break;
+         for (chPtr=numPtr; *chPtr==' ' || *chPtr=='\t' || *chPtr==',' || *chPtr==';'; chPtr++) ;
+      }
+      if (j==loads) return 1;
+      if (j==0 && n==0) continue; // header line
+      printf("ERROR: sweep:'%s' need %d currents in line:'%s'\n", fileName, loads, linePtr);
+      return -1;
+   }
+} // int linRead(pbCtx* ctx, chunkTy* c, int kind, double* I, int loads, u64 n, const char* fileName)
+
+// compile the linear map and write it to DefCliLinFile, one row for every
+// output: c0 then the coefficient of every column. With a sweep file, take
+// its load vectors, columns in the map order, and show min, average and
+// max of every output. A block of vectors is one matrix product
+int linearSweep(pbCtx* ctx, char* sweepFile) {
+   linTy lin;
+   if (linCompile(ctx, &lin)!=0) return -1;
+   int out=0, loads=lin.loads, rows=lin.rows;
+   FILE* filePtr=openWrite(DefCliLinFile);
+   if (filePtr==NULL) {
+      linFree(&lin);
+      return -1;
+   }
+   fprintf(filePtr, "row,c0");
+   for (int j=0, k=0; j<loads; j++) { // loads are in plan order
+      int m=lin.load[j];
+      while (ctx->plan.in[k+1]<=m) k++;
+      fprintf(filePtr, ",%s:I%d", ctx->plan.node[k]->name, m-ctx->plan.in[k]);
+   }
+   fprintf(filePtr, "\n");
+   for (int r=0; r<rows; r++) {
+      int k=lin.node[r/2];
+      fprintf(filePtr, "%s:%s,%.17g", ctx->plan.node[k]->name, (r&1) ? ((k==0) ? "P" : "Pd") : "I", lin.c0[r]);
+      for (int j=0; j<loads; j++) fprintf(filePtr, ",%.17g", lin.T[(size_t)r*loads+j]);
+      fprintf(filePtr, "\n");
+   }
+   fclose(filePtr);
+   printf("Linear load map rows:%d loads:%d written:'%s'\n", rows, loads, DefCliLinFile);
+   if (sweepFile==NULL) {
+      printf("\n");
+      linFree(&lin);
+      return 0;
+   }
+
+   chunkTy chunk;
+   if (openChunk(sweepFile, &chunk, ChunkLen)!=OK) {
+      printf("ERROR: cannot open sweep:'%s'\n", sweepFile);
+      linFree(&lin);
+      return -1;
+   }
+   int kind=ProfCsv;
+   const char* extPtr=strrchr(sweepFile, '.');
+   if (extPtr && !strcasecmp(extPtr, ".f32")) kind=ProfF32;
+   if (extPtr && !strcasecmp(extPtr, ".f64")) kind=ProfF64;
+   double* I=malloc((size_t)LinBlock*(loads ? loads : 1)*sizeof(double));
+   double* y=malloc((size_t)LinBlock*rows*sizeof(double));
+   double* yMin=malloc(rows*sizeof(double));
+   double* yMax=malloc(rows*sizeof(double));
+   double* ySum=calloc(rows, sizeof(double));
+   u64* at=calloc(rows, sizeof(u64));
+   for (int r=0; r<rows; r++) {
+      yMin[r]=HUGE_VAL;
+      yMax[r]=-HUGE_VAL;
+   }
+   u64 n=0;
+   int more=1;
+   while (more) {
+      int cnt=0;
+      while (cnt<LinBlock) {
+         int ret=linRead(ctx, &chunk, kind, I+(size_t)cnt*loads, loads, n+cnt, sweepFile);
+         if (ret<0) { out=-1; goto done; }
+         if (ret==0) { more=0; break; }
+         cnt++;
+      }
+      linEval(&lin, I, y, cnt);
+      for (int s=0; s<cnt; s++) {
+         const double* ys=y+(size_t)s*rows;
+         for (int r=0; r<rows; r++) {
+            ySum[r]+=ys[r];
+            yMin[r]=fmin(yMin[r], ys[r]);
+            if (ys[r]>yMax[r]) {
+               yMax[r]=ys[r];
+               at[r]=n+s;
+            }
+         }
+      }
+      n+=cnt;
+   }
+   printf("Load vectors:%llu from:'%s'\n", (unsigned long long)n, sweepFile);
+   printf("node   refdes  val          min          avg          max  max at vector\n");
+   for (int r=0; r<rows && n>0; r++) {
+      nTy* node=ctx->plan.node[lin.node[r/2]];
+      printf("%-6s %-7s %-3s %12.6g %12.6g %12.6g %14llu\n", node->name, node->refdes,
+             (r&1) ? ((node->type==0) ? "P" : "Pd") : "I", yMin[r], ySum[r]/n, yMax[r], (unsigned long long)at[r]);
+   }
+   printf("\n");
+   done:
+   closeChunk(&chunk);
+   free(I);
+   free(y);
+   free(yMin);
+   free(yMax);
+   free(ySum);
+   free(at);
+   linFree(&lin);
+   return out;
+} // int linearSweep(pbCtx* ctx, char* sweepFile)
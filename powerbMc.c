@@ -0,0 +1,339 @@
+/* PowerBudget v0.00.01a 2024/09/08 calculate power dissipation and budget */
+/* Copyright 2024 Valerio Messina http://users.iol.it/efa              */
+/* powerbMc.c is part of PowerBudget
+   PowerBudget is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   PowerBudget is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with PowerBudget. If not, see <http://www.gnu.org/licenses/>. */
+
+/* powerbMc.c LIB: Monte Carlo tolerance analysis on the compiled plan */
+
+#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "powerbLib.h"
+#include "fileIo.h"
+
+#define McBlock   256 // samples calculated together as batch lanes
+#define McPilot  4096 // first samples used to set the histogram range
+#define McChunks 4096 // max work chunks, each sums its samples in order
+#define McBins   2048 // histogram bins between pilot min and max
+#define McMetrics   3 // Pd, Ii, Pi of every node, Io and Po for IN
+#define McRedraw   32 // max draws of a normal sample inside its tolerance, 16 pairs
+
+typedef struct mcStatTy { // partial statistic of a chunk
+    double sum;  // sum of x-ref
+    double sum2; // sum of (x-ref)^2
+    double min;
+    double max;
+} mcStatTy;
+
+typedef struct mcRunTy { // shared by all threads
+    pbCtx* ctx;      // design of the plan
+    long samples;    // samples to calc
+    u64 seed;        // first key of the counter based random numbers
+    long chunk;      // samples in a chunk, multiple of McBlock
+    int chunks;      // work chunks
+    long next;       // next chunk to calc
+    int vals;        // nodes*McMetrics
+    double* lo;      // [vals] histogram range from pilot
+    double* hi;      // [vals]
+    double* ref;     // [vals] pilot mean
+    mcStatTy* stat;  // [chunks][vals]
+    u32* hist;       // [vals][McBins+2] with under and overflow bins
+    pthread_mutex_t lock;
+} mcRunTy;
+
+static inline u64 mcMix(u64 x) { // splitmix64 finalizer
+   x+=0x9E3779B97F4A7C15ULL;
+   x=(x^(x>>30))*0xBF58476D1CE4E5B9ULL;
+   x=(x^(x>>27))*0x94D049BB133111EBULL;
+   return x^(x>>31);
+} // u64 mcMix(u64 x)
+
+// uniform in (0,1) from the counter: only depend on seed, sample, tolerance
+// and draw, so results do not depend on threads or chunk order
+static inline double mcRand(u64 seed, u64 g, u32 t, u32 d) {
+   u64 x=mcMix(seed^mcMix(g^mcMix(((u64)t<<8)|d)));
+   return ((x>>11)+0.5)*(1.0/9007199254740992.0);
+} // double mcRand(u64 seed, u64 g, u32 t, u32 d)
+
+// sample value of tolerance t for sample g
+double tolSample(tolTy* tolPtr, u64 seed, u64 g, u32 t) {
+   double d;
+   if (tolPtr->dist==TolNormal) { // tolerance is 3 sigma, draw again out of it
+      u32 r=0;
+      do {
+         double u1=mcRand(seed, g, t, r++);
+         double u2=mcRand(seed, g, t, r++);
+         d=sqrt(-2*log(u1))*cos(2*M_PI*u2)*tolPtr->tol/3;
+      } while (fabs(d)>tolPtr->tol && r<McRedraw);
+      if (fabs(d)>tolPtr->tol) d=(d<0) ? -tolPtr->tol : tolPtr->tol;
+   } else { // uniform in +-tolerance
+      d=(2*mcRand(seed, g, t, 0)-1)*tolPtr->tol;
+   }
+   if (tolPtr->rel) return tolPtr->nom*(1+d);
+   return tolPtr->nom+d;
+} // double tolSample(tolTy* tolPtr, u64 seed, u64 g, u32 t)
+
+// lane of the batch changed by tolerance t, NULL when not an input
+double* tolLane(batchTy* batchPtr, tolTy* tolPtr, int s) {
+   pbCtx* ctx=batchPtr->ctx;
+   int k=tolPtr->node->pix;
+   if (k<0) return NULL; // node not in plan
+   int cnt=batchPtr->cnt;
+   int i=tolPtr->input;
+   u08 mode=ctx->plan.mode[ctx->plan.in[k]+i];
+   switch (tolPtr->field) {
+   case TolVo:   return &batchPtr->Vo[BatchLane(k, s, cnt)];
+   case TolYeld: return &batchPtr->yeld[BatchLane(k, s, cnt)];
+   case TolIadj: return &batchPtr->Iadj[BatchLane(k, s, cnt)];
+   case TolR:
+      if (ctx->plan.type[k]==3 && !(mode&LdR)) return NULL;
+      return &batchPtr->R[BatchInLane(&ctx->plan, k, i, s, cnt)];
+   case TolIi:
+      if (!(mode&LdI)) return NULL;
+      return &batchPtr->Ii[BatchInLane(&ctx->plan, k, i, s, cnt)];
+   case TolPi:
+      if (!(mode&LdP)) return NULL;
+      return &batchPtr->Pi[BatchInLane(&ctx->plan, k, i, s, cnt)];
+   }
+   return NULL;
+} // double* tolLane(batchTy* batchPtr, tolTy* tolPtr, int s)
+
+// value of metric j of plan node k in lane s
+static inline double mcValue(batchTy* batchPtr, int k, int j, int s) {
+   pbCtx* ctx=batchPtr->ctx;
+   int cnt=batchPtr->cnt;
+   if (j==0) return batchPtr->Pd[BatchLane(k, s, cnt)];
+   if (ctx->plan.type[k]==0) { // IN: current and power given to the board
+      if (j==1) return batchPtr->Io[BatchLane(k, s, cnt)];
+      return batchPtr->Po[BatchLane(k, s, cnt)];
+   }
+   double v=0;
+   for (int i=0; i<PlanIns(&ctx->plan, k); i++) {
+      if (ctx->plan.up[ctx->plan.in[k]+i]<0) continue;
+      if (j==1) v+=batchPtr->Ii[BatchInLane(&ctx->plan, k, i, s, cnt)];
+      else v+=batchPtr->Pi[BatchInLane(&ctx->plan, k, i, s, cnt)];
+   }
+   return v;
+} // double mcValue(batchTy* batchPtr, int k, int j, int s)
+
+// sample and calc n lanes starting at sample g0
+static int mcBlock(mcRunTy* runPtr, batchTy* batchPtr, long g0, int n) {
+   pbCtx* ctx=batchPtr->ctx;
+   for (int t=0; t<ctx->tolList.cnt; t++) {
+      tolTy* tolPtr=&ctx->tolList.tol[t];
+      for (int s=0; s<n; s++) {
+         double* lanePtr=tolLane(batchPtr, tolPtr, s);
+         if (lanePtr==NULL) break;
+         *lanePtr=tolSample(tolPtr, runPtr->seed, g0+s, t);
+      }
+   }
+   return batchCalc(batchPtr);
+} // int mcBlock(mcRunTy* runPtr, batchTy* batchPtr, long g0, int n)
+
+typedef struct mcThreadTy {
+    mcRunTy* runPtr;
+    int ret;
+} mcThreadTy;
+
+// worker: take next chunk until done, sum in chunk stat and own histogram
+static void* mcThread(void* argPtr) {
+   mcThreadTy* thPtr=argPtr;
+   mcRunTy* runPtr=thPtr->runPtr;
+   pbCtx* ctx=runPtr->ctx;
+   int vals=runPtr->vals;
+   batchTy batch;
+   thPtr->ret=batchInit(ctx, &batch, McBlock);
+   if (thPtr->ret!=0) return NULL;
+   u32* hist=calloc((size_t)vals*(McBins+2), sizeof(u32));
+   for (;;) {
+      long c=__sync_fetch_and_add(&runPtr->next, 1);
+      if (c>=runPtr->chunks) break;
+      mcStatTy* stat=&runPtr->stat[(size_t)c*vals];
+      for (int v=0; v<vals; v++) {
+         stat[v].sum=0; stat[v].sum2=0;
+         stat[v].min=INFINITY; stat[v].max=-INFINITY;
+      }
+      long gEnd=(c+1)*runPtr->chunk;
+      if (gEnd>runPtr->samples) gEnd=runPtr->samples;
+      for (long g0=c*runPtr->chunk; g0<gEnd; g0+=McBlock) {
+         int n=(gEnd-g0<McBlock) ? gEnd-g0 : McBlock;
+         if (mcBlock(runPtr, &batch, g0, n)!=0) { thPtr->ret=-1; goto done; }
+         for (int s=0; s<n; s++) {
+            if (!batch.fail[s]) continue;
+            printf("ERROR: no solution for sample:%ld\n", g0+s);
+            thPtr->ret=-1; goto done;
+         }
+         for (int k=0; k<ctx->plan.nodes; k++) {
+            for (int j=0; j<McMetrics; j++) {
+               int v=k*McMetrics+j;
+               double lo=runPtr->lo[v], hi=runPtr->hi[v], ref=runPtr->ref[v];
+               double scale=(hi>lo) ? McBins/(hi-lo) : 0;
+               u32* h=&hist[(size_t)v*(McBins+2)];
+               for (int s=0; s<n; s++) {
+                  double x=mcValue(&batch, k, j, s);
+                  double d=x-ref;
+                  stat[v].sum+=d;
+                  stat[v].sum2+=d*d;
+                  if (x<stat[v].min) stat[v].min=x;
+                  if (x>stat[v].max) stat[v].max=x;
+                  long b=(x<lo) ? -1 : (long)((x-lo)*scale);
+                  if (b>=McBins) b=McBins;
+                  h[b+1]++;
+               }
+            }
+         }
+      }
+   }
+   done:
+   pthread_mutex_lock(&runPtr->lock);
+   for (size_t h=0; h<(size_t)vals*(McBins+2); h++) runPtr->hist[h]+=hist[h];
+   pthread_mutex_unlock(&runPtr->lock);
+   free(hist);
+   batchFree(&batch);
+   return NULL;
+} // void* mcThread(void* argPtr)
+
+// value at fraction q of the samples from the histogram
+static double mcPercentile(mcRunTy* runPtr, int v, double q, double min, double max) {
+   u32* h=&runPtr->hist[(size_t)v*(McBins+2)];
+   double want=q*runPtr->samples;
+   double cum=0;
+   double lo=runPtr->lo[v], hi=runPtr->hi[v];
+   double w=(hi-lo)/McBins;
+   if (h[0]>=want) return min; // in underflow
+   cum=h[0];
+   for (int b=0; b<McBins; b++) {
+      if (cum+h[b+1]>=want && h[b+1]>0) {
+         double x=lo+w*(b+(want-cum)/h[b+1]);
+         if (x<min) x=min;
+         if (x>max) x=max;
+         return x;
+      }
+      cum+=h[b+1];
+   }
+   return max; // in overflow
+} // double mcPercentile(mcRunTy* runPtr, int v, double q, double min, double max)
+
+// Monte Carlo: calc samples boards with toleranced values on threads, show
+// mean, sigma, min, max and percentiles of every node. threads=0 use all cores
+int monteCarlo(pbCtx* ctx, long samples, u64 seed, int threads) {
+   if (samples<1) return -1;
+   if (!ctx->plan.valid && pbCompileNodes(ctx)!=0) return -1;
+   if (threads<1) threads=sysconf(_SC_NPROCESSORS_ONLN);
+   if (threads<1) threads=1;
+   int active=0;
+   for (int t=0; t<ctx->tolList.cnt; t++) {
+      if (ctx->tolList.tol[t].node->pix>=0) active++;
+   }
+   printf("Monte Carlo samples:%ld seed:%llu threads:%d tolerances:%d\n", samples, (unsigned long long)seed, threads, active);
+   if (active==0) printf("WARN: no tolerance in file, all samples are nominal\n");
+   mcRunTy run;
+   memset(&run, 0, sizeof(run));
+   run.ctx=ctx;
+   run.samples=samples;
+   run.seed=seed;
+   run.vals=ctx->plan.nodes*McMetrics;
+   run.chunk=McBlock*16;
+   while ((samples+run.chunk-1)/run.chunk>McChunks) run.chunk*=2;
+   run.chunks=(samples+run.chunk-1)/run.chunk;
+   run.lo=malloc(run.vals*sizeof(double));
+   run.hi=malloc(run.vals*sizeof(double));
+   run.ref=calloc(run.vals, sizeof(double));
+   run.stat=malloc((size_t)run.chunks*run.vals*sizeof(mcStatTy));
+   run.hist=calloc((size_t)run.vals*(McBins+2), sizeof(u32));
+   pthread_mutex_init(&run.lock, NULL);
+   int out=0;
+
+   // pilot: first samples fix histogram range and reference for the sums
+   batchTy batch;
+   if (batchInit(ctx, &batch, McBlock)!=0) { out=-1; goto done; }
+   for (int v=0; v<run.vals; v++) { run.lo[v]=INFINITY; run.hi[v]=-INFINITY; }
+   long pilot=(samples<McPilot) ? samples : McPilot;
+   for (long g0=0; g0<pilot; g0+=McBlock) {
+      int n=(pilot-g0<McBlock) ? pilot-g0 : McBlock;
+      if (mcBlock(&run, &batch, g0, n)!=0) { out=-1; batchFree(&batch); goto done; }
+      for (int k=0; k<ctx->plan.nodes; k++) {
+         for (int j=0; j<McMetrics; j++) {
+            int v=k*McMetrics+j;
+            for (int s=0; s<n; s++) {
+               double x=mcValue(&batch, k, j, s);
+               run.ref[v]+=x/pilot;
+               if (x<run.lo[v]) run.lo[v]=x;
+               if (x>run.hi[v]) run.hi[v]=x;
+            }
+         }
+      }
+   }
+   batchFree(&batch);
+   for (int v=0; v<run.vals; v++) { // keep room for the tails
+      double span=run.hi[v]-run.lo[v];
+      if (span<=0) span=fabs(run.ref[v])*1e-6+1e-12;
+      run.lo[v]-=span/4;
+      run.hi[v]+=span/4;
+   }
+
+   pthread_t* th=malloc(threads*sizeof(pthread_t));
+   mcThreadTy* arg=malloc(threads*sizeof(mcThreadTy));
+   for (int t=0; t<threads; t++) {
+      arg[t].runPtr=&run;
+      arg[t].ret=0;
+      pthread_create(&th[t], NULL, mcThread, &arg[t]);
+   }
+   for (int t=0; t<threads; t++) {
+      pthread_join(th[t], NULL);
+      if (arg[t].ret!=0) out=-1;
+   }
+   free(th);
+   free(arg);
+   if (out!=0) goto done;
+
+   // merge chunks in order and show
+   const char* metric[McMetrics]={"Pd", "Ii", "Pi"};
+   const char* metricIn[McMetrics]={"Pd", "I", "P"};
+   printf("node   refdes  val       mean      sigma        min       p0.1         p1         p5        p50        p95        p99      p99.9        max\n");
+   for (int k=0; k<ctx->plan.nodes; k++) {
+      nTy* node=ctx->plan.node[k];
+      for (int j=0; j<McMetrics; j++) {
+         if (ctx->plan.type[k]==0 && j==0) continue; // no IN dissipation
+         int v=k*McMetrics+j;
+         double sum=0, sum2=0, min=INFINITY, max=-INFINITY;
+         for (int c=0; c<run.chunks; c++) {
+            mcStatTy* stat=&run.stat[(size_t)c*run.vals+v];
+            sum+=stat->sum;
+            sum2+=stat->sum2;
+            if (stat->min<min) min=stat->min;
+            if (stat->max>max) max=stat->max;
+         }
+         double mean=sum/samples;
+         double var=(samples>1) ? (sum2-sum*mean)/(samples-1) : 0;
+         if (var<0) var=0;
+         printf("%-6s %-7s %-3s %10.6g %10.4g %10.6g", node->name, node->refdes,
+                (ctx->plan.type[k]==0) ? metricIn[j] : metric[j], run.ref[v]+mean, sqrt(var), min);
+         const double q[]={0.001, 0.01, 0.05, 0.5, 0.95, 0.99, 0.999};
+         for (int p=0; p<7; p++) printf(" %10.6g", mcPercentile(&run, v, q[p], min, max));
+         printf(" %10.6g\n", max);
+      }
+   }
+   printf("\n");
+   done:
+   pthread_mutex_destroy(&run.lock);
+   free(run.lo);
+   free(run.hi);
+   free(run.ref);
+   free(run.stat);
+   free(run.hist);
+   return out;
+} // int monteCarlo(pbCtx* ctx, long samples, u64 seed, int threads)
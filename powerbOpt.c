@@ -0,0 +1,771 @@
+/* PowerBudget v0.00.01a 2024/09/08 calculate power dissipation and budget */
+/* Copyright 2024 Valerio Messina http://users.iol.it/efa              */
+/* powerbOpt.c is part of PowerBudget
+   PowerBudget is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   PowerBudget is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with PowerBudget. If not, see <http://www.gnu.org/licenses/>. */
+
+/* powerbOpt.c LIB: design optimizer, branch and bound on the alternatives */
+
+#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "powerbLib.h"
+#include "fileIo.h"
+
+#define OptBlock   256 // max combinations calculated together as batch lanes
+#define OptSplit     8 // work items for every thread, prefixes of the decisions
+#define OptMaxType  16 // max SR/LR type alternatives, 2^n plans are compiled
+#define OptEps   1e-12 // relative, a bound above the best by more is pruned
+#define OptVtol   1e-9 // V, rounding allowed on the dropout check
+#define OptLeast  4096 // max combinations to find the least value of a node
+#define OptMaxPlan 65536 // max plans of SR/LR types and SR, LR, RS feeds, each is compiled
+
+typedef struct optDecTy { // a decision of the search: Vo or feed of a LD input
+    optTy* optPtr;
+    nTy* node;
+    int choices;      // OptVo: values, OptFeed: inputs, the INI one first
+    int* slot;        // OptFeed: [choices] LD input of every choice
+    int ins;          // OptFeed: LD inputs before the wiring
+    double load;      // OptFeed: I, R or P of the INI input
+} optDecTy;
+
+typedef struct optLinkTy { // feed of a SR, LR or RS: a plan for every choice
+    optTy* optPtr;
+    nTy* node;
+    int choices;      // nodes that may feed it, the INI one first
+    int* from;        // [choices] nList ix of every choice
+} optLinkTy;
+
+typedef struct optRunTy { // shared by all threads
+    pbCtx* ctx;      // design searched
+    int goal;        // OptGoalPd or OptGoalP
+    int decs;        // decisions
+    optDecTy* dec;   // [decs] ordered leaves first
+    double* suf;     // [decs+1] combinations of decisions d and after
+    int* last;       // [nodes] last decision moving the node, -1 for none
+    double* least;   // [nodes] least value of the node on any choice, 0 when unknown
+    int bound;       // lower bounds are valid, every Pd and load is >=0
+    int prefix;      // decisions fixed by a work item
+    long items;      // work items
+    long next;       // next item to search
+    int leafDepth;   // first decision of the leaf blocks
+    int maxChoices;
+    double best;     // best value so far, INFINITY when none
+    int has;         // best found on this plan, ties go to the first choices
+    int* bestC;      // [decs] choices of best
+    u64 calc;        // combinations calculated
+    u64 pruned;      // subtrees cut by bound or dropout
+    int nodes0;      // nodes of the INI plan
+    nTy** node0;     // [nodes0] INI plan position ==> node ptr
+    int* in0;        // [nodes0+1] first input slot in the INI plan
+    u08* mode0;      // [inputs] input modes of the INI plan
+    pthread_mutex_t lock;
+} optRunTy;
+
+// set lane s to the choices c of every decision
+static void optLane(optRunTy* runPtr, batchTy* batchPtr, int s, const int* c) {
+   pbCtx* ctx=runPtr->ctx;
+   int cnt=batchPtr->cnt;
+   for (int d=0; d<runPtr->decs; d++) {
+      optDecTy* decPtr=&runPtr->dec[d];
+      int k=decPtr->node->pix;
+      if (decPtr->optPtr->kind==OptVo) {
+         batchPtr->Vo[BatchLane(k, s, cnt)]=decPtr->optPtr->val[c[d]];
+         continue;
+      }
+      for (int j=0; j<decPtr->choices; j++) { // only the chosen input draws
+         int i=decPtr->slot[j];
+         u08 mode=ctx->plan.mode[ctx->plan.in[k]+i];
+         double v=(j==c[d]) ? decPtr->load : 0;
+         if (mode&LdI) batchPtr->Ii[BatchInLane(&ctx->plan, k, i, s, cnt)]=v;
+         else if (mode&LdR) batchPtr->R[BatchInLane(&ctx->plan, k, i, s, cnt)]=v;
+         else batchPtr->Pi[BatchInLane(&ctx->plan, k, i, s, cnt)]=v;
+      }
+   }
+   return;
+} // void optLane(optRunTy* runPtr, batchTy* batchPtr, int s, const int* c)
+
+static inline int optDropout(batchTy* batchPtr, int k, int s) { // Vi-Vo<DVmin
+   pbCtx* ctx=batchPtr->ctx;
+   int cnt=batchPtr->cnt;
+   double DV=batchPtr->Vi[BatchInLane(&ctx->plan, k, 0, s, cnt)]-batchPtr->Vo[BatchLane(k, s, cnt)];
+   return DV<ctx->plan.node[k]->DVmin-OptVtol;
+} // int optDropout(batchTy* batchPtr, int k, int s)
+
+// lower bound of the goal in *boundPtr when the first t decisions are taken:
+// sum of Pd, or Pd and loads for IN P, of the nodes with known values, and
+// of the least value of the others. Return 0 when one of the regulators with
+// known values is out of regulation, or all decisions are taken on a lane
+// with no solution
+static int optBound(optRunTy* runPtr, batchTy* batchPtr, int s, int t, double* boundPtr) {
+   pbCtx* ctx=runPtr->ctx;
+   double b=0;
+   if (batchPtr->fail[s]) { // no solution: out when all decisions are taken
+      *boundPtr=-INFINITY; // else from the later first choices, no bound
+      return t<=runPtr->decs;
+   }
+   for (int k=1; k<ctx->plan.nodes; k++) {
+      int type=ctx->plan.type[k];
+      if (type==3 && runPtr->goal==OptGoalPd) continue;
+      if (runPtr->last[k]>=t) {
+         b+=runPtr->least[k];
+         continue;
+      }
+      if ((type==1 || type==2) && optDropout(batchPtr, k, s)) return 0;
+      b+=batchPtr->Pd[BatchLane(k, s, batchPtr->cnt)];
+   }
+   *boundPtr=b;
+   return 1;
+} // int optBound(optRunTy* runPtr, batchTy* batchPtr, int s, int t, double* boundPtr)
+
+// -1, 0, 1 as choices a before, same or after b
+static int optCmp(const int* a, const int* b, int decs) {
+   for (int d=0; d<decs; d++) {
+      if (a[d]!=b[d]) return (a[d]<b[d]) ? -1 : 1;
+   }
+   return 0;
+} // int optCmp(const int* a, const int* b, int decs)
+
+// calc all the combinations of decisions t and after, keep the best
+static int optLeaves(optRunTy* runPtr, batchTy* batchPtr, int* c, int t) {
+   int decs=runPtr->decs, n=(int)runPtr->suf[t];
+   for (int s=0; s<n; s++) { // last decision moving faster
+      for (int d=decs-1, r=s; d>=t; d--) {
+         c[d]=r%runPtr->dec[d].choices;
+         r/=runPtr->dec[d].choices;
+      }
+      optLane(runPtr, batchPtr, s, c);
+   }
+   if (batchCalc(batchPtr)!=0) return -1;
+   __sync_fetch_and_add(&runPtr->calc, n);
+   int sBest=-1;
+   double best=INFINITY, value;
+   for (int s=0; s<n; s++) { // first lane of the min is the first choices
+      if (!optBound(runPtr, batchPtr, s, decs+1, &value)) continue;
+      if (runPtr->goal==OptGoalP) value=batchPtr->Po[BatchLane(0, s, batchPtr->cnt)];
+      if (value<best) { best=value; sBest=s; }
+   }
+   if (sBest<0) return 0;
+   for (int d=decs-1, r=sBest; d>=t; d--) {
+      c[d]=r%runPtr->dec[d].choices;
+      r/=runPtr->dec[d].choices;
+   }
+   pthread_mutex_lock(&runPtr->lock);
+   if (best<runPtr->best || (best==runPtr->best && runPtr->has && optCmp(c, runPtr->bestC, decs)<0)) {
+      runPtr->best=best;
+      runPtr->has=1;
+      memcpy(runPtr->bestC, c, decs*sizeof(int));
+   }
+   pthread_mutex_unlock(&runPtr->lock);
+   return 0;
+} // int optLeaves(optRunTy* runPtr, batchTy* batchPtr, int* c, int t)
+
+static inline int optPrune(optRunTy* runPtr, double bound) {
+   pthread_mutex_lock(&runPtr->lock);
+   double best=runPtr->best;
+   pthread_mutex_unlock(&runPtr->lock);
+   return bound==INFINITY || bound>best+OptEps*fabs(best); // INFINITY: out of regulation on any choice
+} // int optPrune(optRunTy* runPtr, double bound)
+
+// depth first on decision t with c[0..t) taken: the choices are calculated
+// together with the later decisions at their first choice, the bound of the
+// nodes they fix decide the order and the choices to skip
+static int optSearch(optRunTy* runPtr, batchTy* leafPtr, batchTy* bndPtr, int* c, int t) {
+   if (t>=runPtr->leafDepth) return optLeaves(runPtr, leafPtr, c, t);
+   int decs=runPtr->decs, ch=runPtr->dec[t].choices;
+   double b[ch];
+   int ok[ch], ord[ch];
+   for (int d=t+1; d<decs; d++) c[d]=0;
+   for (int s=0; s<ch; s++) {
+      c[t]=s;
+      optLane(runPtr, bndPtr, s, c);
+      b[s]=-INFINITY;
+      ok[s]=1;
+      ord[s]=s;
+   }
+   if (runPtr->bound) {
+      if (batchCalc(bndPtr)!=0) return -1;
+      for (int s=0; s<ch; s++) ok[s]=optBound(runPtr, bndPtr, s, t+1, &b[s]);
+      for (int s=1; s<ch; s++) { // lowest bound first
+         int o=ord[s], p=s;
+         for (; p>0 && b[ord[p-1]]>b[o]; p--) ord[p]=ord[p-1];
+         ord[p]=o;
+      }
+   }
+   for (int p=0; p<ch; p++) {
+      int s=ord[p];
+      if (!ok[s] || optPrune(runPtr, b[s])) {
+         __sync_fetch_and_add(&runPtr->pruned, 1);
+         continue;
+      }
+      c[t]=s;
+      for (int d=t+1; d<decs; d++) c[d]=0;
+      if (optSearch(runPtr, leafPtr, bndPtr, c, t+1)!=0) return -1;
+   }
+   return 0;
+} // int optSearch(optRunTy* runPtr, batchTy* leafPtr, batchTy* bndPtr, int* c, int t)
+
+typedef struct optThreadTy {
+    optRunTy* runPtr;
+    int ret;
+} optThreadTy;
+
+// worker: take the next prefix of choices until done, search below it
+static void* optThread(void* argPtr) {
+   optThreadTy* thPtr=argPtr;
+   optRunTy* runPtr=thPtr->runPtr;
+   pbCtx* ctx=runPtr->ctx;
+   int decs=runPtr->decs, p=runPtr->prefix;
+   int leaves=(int)runPtr->suf[(p>runPtr->leafDepth) ? p : runPtr->leafDepth];
+   batchTy leaf, bnd;
+   thPtr->ret=batchInit(ctx, &leaf, leaves);
+   if (thPtr->ret!=0) return NULL;
+   thPtr->ret=batchInit(ctx, &bnd, runPtr->maxChoices);
+   if (thPtr->ret!=0) { batchFree(&leaf); return NULL; }
+   int* c=calloc(decs+1, sizeof(int));
+   for (;;) {
+      long item=__sync_fetch_and_add(&runPtr->next, 1);
+      if (item>=runPtr->items) break;
+      for (int d=p-1; d>=0; d--) {
+         c[d]=item%runPtr->dec[d].choices;
+         item/=runPtr->dec[d].choices;
+      }
+      for (int d=p; d<decs; d++) c[d]=0;
+      if (p>0 && p<runPtr->leafDepth && runPtr->bound) { // bound of the prefix
+         double b;
+         optLane(runPtr, &bnd, 0, c);
+         if (batchCalc(&bnd)!=0) { thPtr->ret=-1; break; }
+         if (!optBound(runPtr, &bnd, 0, p, &b) || optPrune(runPtr, b)) {
+            __sync_fetch_and_add(&runPtr->pruned, 1);
+            continue;
+         }
+      }
+      if (optSearch(runPtr, &leaf, &bnd, c, p)!=0) { thPtr->ret=-1; break; }
+   }
+   free(c);
+   batchFree(&leaf);
+   batchFree(&bnd);
+   return NULL;
+} // void* optThread(void* argPtr)
+
+// nodes moved by decision d: the node decided, up to IN the nodes its current
+// go through, below a Vo decided or a RS moved by its current
+static void optMoved(optRunTy* runPtr, int d, int* stack, u08* mark) {
+   pbCtx* ctx=runPtr->ctx;
+   optDecTy* decPtr=&runPtr->dec[d];
+   int top=0, v=decPtr->node->pix;
+   memset(mark, 0, ctx->plan.nodes);
+   stack[top++]=v;
+   while (top>0) {
+      int k=stack[--top];
+      if (mark[k]) continue;
+      mark[k]=1;
+      if (runPtr->last[k]<d) runPtr->last[k]=d;
+      for (int i=0; i<PlanIns(&ctx->plan, k); i++) {
+         int u=ctx->plan.up[ctx->plan.in[k]+i];
+         if (u>=0 && !mark[u]) stack[top++]=u;
+      }
+      if (ctx->plan.type[k]!=4 && !(k==v && decPtr->optPtr->kind==OptVo)) continue;
+      for (int e=ctx->plan.first[k]; e<ctx->plan.first[k+1]; e++) {
+         if (!mark[ctx->plan.child[e]]) stack[top++]=ctx->plan.child[e];
+      }
+   }
+   return;
+} // void optMoved(optRunTy* runPtr, int d, int* stack, u08* mark)
+
+// least value of every node on all the choices of the decisions moving it,
+// the others at the first choice. Nodes moved by a part of these decisions
+// take it from the same lanes, nodes with the most decisions go first
+static int optLeast(optRunTy* runPtr, const u08* moved) {
+   pbCtx* ctx=runPtr->ctx;
+   int nodes=ctx->plan.nodes, decs=runPtr->decs, out=0;
+   int* ord=malloc(nodes*sizeof(int));
+   int* num=calloc(nodes, sizeof(int));
+   int* dl=malloc((decs+1)*sizeof(int));
+   int* sub=malloc(nodes*sizeof(int));
+   int* c=calloc(decs+1, sizeof(int));
+   u08* done=calloc(nodes, 1);
+   for (int k=0; k<nodes; k++) {
+      ord[k]=k;
+      for (int d=0; d<decs; d++) num[k]+=moved[(size_t)k*decs+d];
+      runPtr->least[k]=0;
+   }
+   for (int p=1; p<nodes; p++) { // most decisions first
+      int o=ord[p], q=p;
+      for (; q>0 && num[ord[q-1]]<num[o]; q--) ord[q]=ord[q-1];
+      ord[q]=o;
+   }
+   batchTy batch;
+   if (batchInit(ctx, &batch, OptBlock)!=0) { out=-1; goto done; }
+   for (int p=0; p<nodes; p++) {
+      int k=ord[p], subs=0, dls=0;
+      double combs=1;
+      if (k==0 || done[k]) continue;
+      for (int d=0; d<decs; d++) {
+         if (!moved[(size_t)k*decs+d]) continue;
+         dl[dls++]=d;
+         combs*=runPtr->dec[d].choices;
+      }
+      if (combs>OptLeast) continue; // unknown, 0
+      for (int j=1; j<nodes; j++) { // nodes moved only by decisions of k
+         if (done[j]) continue;
+         int d=0;
+         while (d<decs && (!moved[(size_t)j*decs+d] || moved[(size_t)k*decs+d])) d++;
+         if (d<decs) continue;
+         done[j]=1;
+         sub[subs++]=j;
+         runPtr->least[j]=INFINITY;
+      }
+      for (long g0=0; g0<(long)combs; g0+=OptBlock) {
+         int n=((long)combs-g0<OptBlock) ? (long)combs-g0 : OptBlock;
+         for (int s=0; s<n; s++) {
+            for (int e=dls-1, r=g0+s; e>=0; e--) {
+               c[dl[e]]=r%runPtr->dec[dl[e]].choices;
+               r/=runPtr->dec[dl[e]].choices;
+            }
+            optLane(runPtr, &batch, s, c);
+         }
+         if (batchCalc(&batch)!=0) { out=-1; goto done; }
+         for (int i=0; i<subs; i++) {
+            int j=sub[i];
+            for (int s=0; s<n; s++) { // only choices in regulation
+               if (batch.fail[s]) { runPtr->least[j]=0; continue; } // the others at first choice, unknown
+               if ((ctx->plan.type[j]==1 || ctx->plan.type[j]==2) && optDropout(&batch, j, s)) continue;
+               double v=batch.Pd[BatchLane(j, s, batch.cnt)];
+               if (v<runPtr->least[j]) runPtr->least[j]=v;
+            }
+         }
+      }
+      for (int e=0; e<dls; e++) c[dl[e]]=0;
+   }
+   done:
+   batchFree(&batch);
+   free(ord);
+   free(num);
+   free(dl);
+   free(sub);
+   free(c);
+   free(done);
+   return out;
+} // int optLeast(optRunTy* runPtr, const u08* moved)
+
+static int cmpDecDown(const void* a, const void* b) { // leaves first
+   const optDecTy* da=a;
+   const optDecTy* db=b;
+   if (da->node->pix!=db->node->pix) return db->node->pix-da->node->pix;
+   return da->optPtr->input-db->optPtr->input;
+} // int cmpDecDown(const void* a, const void* b)
+
+// bounds need every Pd and load >=0 and IN P equal to their sum
+static int optBoundValid(optRunTy* runPtr) {
+   pbCtx* ctx=runPtr->ctx;
+   for (int k=1; k<ctx->plan.nodes; k++) {
+      nTy* node=ctx->plan.node[k];
+      switch (ctx->plan.type[k]) {
+      case 1: // SR
+         if (node->eff) {
+            const effTy* e=node->eff;
+            for (int v=0; v<(e->Vi.cnt+1)*(e->Io.cnt+1); v++) {
+               if (e->n[v]<=0 || e->n[v]>1) return 0;
+            }
+         } else if (*node->yeld<=0 || *node->yeld>1) return 0;
+         if (node->DVmin<0) return 0;
+         break;
+      case 2: // LR
+         if (*node->Iadj<0 || node->DVmin<0) return 0;
+         break;
+      case 3: // LD
+         for (int i=0; i<node->ins; i++) {
+            if (node->Ii[i]<0 || node->R[i]<0 || node->Pi[i]<0) return 0;
+         }
+         break;
+      case 4: // RS
+         if (node->R[0]<0) return 0;
+         break;
+      }
+      for (int i=0; i<PlanIns(&ctx->plan, k); i++) {
+         if (ctx->plan.mode[ctx->plan.in[k]+i]&FixV) return 0;
+      }
+   }
+   return 1;
+} // int optBoundValid(optRunTy* runPtr)
+
+// search all the choices of the decisions on the current plan with threads
+static int optPlan(optRunTy* runPtr, int threads) {
+   pbCtx* ctx=runPtr->ctx;
+   int decs=runPtr->decs, nodes=ctx->plan.nodes;
+   for (int d=0; d<decs; d++) { // choices of LD inputs on the plan
+      optDecTy* decPtr=&runPtr->dec[d];
+      if (decPtr->optPtr->kind!=OptFeed) continue;
+      for (int j=0; j<decPtr->choices; j++) {
+         int u=ctx->plan.up[ctx->plan.in[decPtr->node->pix]+decPtr->slot[j]];
+         if (u<0) {
+            printf("ERROR: LD:'%s' f%dopt node not connected to IN\n", decPtr->node->name, decPtr->slot[0]);
+            return -1;
+         }
+      }
+   }
+   runPtr->last=malloc(nodes*sizeof(int));
+   runPtr->least=malloc(nodes*sizeof(double));
+   int* stack=malloc((ctx->plan.inputs+ctx->plan.first[nodes]+1)*sizeof(int));
+   u08* mark=malloc(nodes);
+   u08* moved=calloc((size_t)nodes*decs+1, 1);
+   for (int k=0; k<nodes; k++) runPtr->last[k]=-1;
+   for (int d=0; d<decs; d++) {
+      optMoved(runPtr, d, stack, mark);
+      for (int k=0; k<nodes; k++) moved[(size_t)k*decs+d]=mark[k];
+   }
+   free(stack);
+   free(mark);
+   runPtr->bound=optBoundValid(runPtr);
+   int out=(runPtr->bound) ? optLeast(runPtr, moved) : 0;
+   free(moved);
+   if (out!=0) goto done;
+   runPtr->suf[decs]=1;
+   runPtr->maxChoices=1;
+   for (int d=decs-1; d>=0; d--) {
+      runPtr->suf[d]=runPtr->suf[d+1]*runPtr->dec[d].choices;
+      if (runPtr->dec[d].choices>runPtr->maxChoices) runPtr->maxChoices=runPtr->dec[d].choices;
+   }
+   runPtr->leafDepth=0;
+   while (runPtr->suf[runPtr->leafDepth]>OptBlock) runPtr->leafDepth++;
+   runPtr->prefix=0;
+   runPtr->items=1;
+   while (runPtr->prefix<runPtr->leafDepth && runPtr->items<(long)OptSplit*threads) {
+      runPtr->items*=runPtr->dec[runPtr->prefix++].choices;
+   }
+   runPtr->next=0;
+   runPtr->has=0;
+   pthread_t* th=malloc(threads*sizeof(pthread_t));
+   optThreadTy* arg=malloc(threads*sizeof(optThreadTy));
+   for (int t=0; t<threads; t++) {
+      arg[t].runPtr=runPtr;
+      arg[t].ret=0;
+      pthread_create(&th[t], NULL, optThread, &arg[t]);
+   }
+   for (int t=0; t<threads; t++) {
+      pthread_join(th[t], NULL);
+      if (arg[t].ret!=0) out=-1;
+   }
+   free(th);
+   free(arg);
+   done:
+   free(runPtr->last);
+   free(runPtr->least);
+   runPtr->last=NULL;
+   runPtr->least=NULL;
+   return out;
+} // int optPlan(optRunTy* runPtr, int threads)
+
+static nTy* optFind(pbCtx* ctx, const char* namePtr, int len) {
+   char name[len+1];
+   memcpy(name, namePtr, len);
+   name[len]='\0';
+   return nListFind(&ctx->nList, name);
+} // nTy* optFind(pbCtx* ctx, const char* namePtr, int len)
+
+// connect the other nodes of a feed decision to free inputs of the LD, with
+// the load of the INI input. Return 0 or -1 when not possible
+static int optWire(pbCtx* ctx, optDecTy* decPtr) {
+   nTy* ld=decPtr->node;
+   int i=decPtr->optPtr->input;
+   u08 mode=ctx->plan.mode[ctx->plan.in[ld->pix]+i];
+   decPtr->ins=ld->ins;
+   decPtr->choices=1;
+   decPtr->slot=malloc((strlen(decPtr->optPtr->names)+2)*sizeof(int)); // names and the INI one
+   if (decPtr->slot==NULL) return -1;
+   if (mode&FixV || !(mode&(LdI|LdR|LdP))) {
+      printf("ERROR: LD:'%s' f%dopt need a load input without V%d\n", ld->name, i, i);
+      return -1;
+   }
+   decPtr->slot[0]=i;
+   const char* chPtr=decPtr->optPtr->names;
+   while (*chPtr) {
+      while (*chPtr==' ' || *chPtr==',') chPtr++;
+      int len=0;
+      while (chPtr[len] && chPtr[len]!=',' && chPtr[len]!=' ') len++;
+      if (len==0) break;
+      nTy* from=optFind(ctx, chPtr, len);
+      if (from==NULL || from->type<0 || from->type==3 || from->ix==ld->from[i]) {
+         printf("ERROR: LD:'%s' f%dopt:'%.*s' is not a node to feed it\n", ld->name, i, len, chPtr);
+         return -1;
+      }
+      int j=0;
+      while (j<ld->ins && ld->from[j]>=0) j++;
+      if (j==ld->ins && nListInputs(&ctx->nList, ld, ld->ins+1)!=0) { // one more input
+         printf("ERROR: LD:'%s' f%dopt:'%s' out of memory\n", ld->name, i, from->name);
+         return -1;
+      }
+      ld->from[j]=from->ix;
+      ld->in[j]=from->name;
+      ld->Vi[j]=0;
+      ld->Ii[j]=ld->Ii[i];
+      ld->R[j]=ld->R[i];
+      ld->Pi[j]=ld->Pi[i];
+      decPtr->slot[decPtr->choices++]=j;
+      chPtr+=len;
+   }
+   decPtr->load=(mode&LdI) ? ld->Ii[i] : (mode&LdR) ? ld->R[i] : ld->Pi[i];
+   return 0;
+} // int optWire(pbCtx* ctx, optDecTy* decPtr)
+
+// back to the INI links of a feed decision
+static void optUnwire(pbCtx* ctx, optDecTy* decPtr) {
+   nTy* ld=decPtr->node;
+   for (int j=decPtr->choices-1; j>0; j--) {
+      int i=decPtr->slot[j];
+      if (i>=ld->ins) continue; // cleared going back to fewer inputs
+      ld->from[i]=-1;
+      ld->in[i]="";
+      ld->Vi[i]=ld->Ii[i]=ld->R[i]=ld->Pi[i]=0;
+   }
+   decPtr->choices=1;
+   if (decPtr->ins<ld->ins) nListInputs(&ctx->nList, ld, decPtr->ins); // INI inputs
+   return;
+} // void optUnwire(pbCtx* ctx, optDecTy* decPtr)
+
+// nodes that may feed the input of a SR, LR or RS, the INI one first.
+// Return 0 or -1 when one is not a node to feed it
+static int optLinks(pbCtx* ctx, optLinkTy* linkPtr) {
+   nTy* node=linkPtr->node;
+   linkPtr->choices=1;
+   linkPtr->from=malloc((strlen(linkPtr->optPtr->names)+2)*sizeof(int)); // names and the INI one
+   if (linkPtr->from==NULL) return -1;
+   linkPtr->from[0]=node->from[0];
+   const char* chPtr=linkPtr->optPtr->names;
+   while (*chPtr) {
+      while (*chPtr==' ' || *chPtr==',') chPtr++;
+      int len=0;
+      while (chPtr[len] && chPtr[len]!=',' && chPtr[len]!=' ') len++;
+      if (len==0) break;
+      nTy* from=optFind(ctx, chPtr, len);
+      if (from==NULL || from->type<0 || from->type==3 || from==node || from->ix==node->from[0]) {
+         printf("ERROR: node:'%s' f0opt:'%.*s' is not a node to feed it\n", node->name, len, chPtr);
+         return -1;
+      }
+      linkPtr->from[linkPtr->choices++]=from->ix;
+      chPtr+=len;
+   }
+   return 0;
+} // int optLinks(pbCtx* ctx, optLinkTy* linkPtr)
+
+// feed the SR, LR or RS by choice c, the plan is to compile again
+static inline void optLinkSet(pbCtx* ctx, optLinkTy* linkPtr, int c) {
+   linkPtr->node->from[0]=linkPtr->from[c];
+   linkPtr->node->in[0]=NodeAt(&ctx->nList, linkPtr->from[c])->name;
+   return;
+} // void optLinkSet(pbCtx* ctx, optLinkTy* linkPtr, int c)
+
+// compile the nodes, inputs keep the modes of the INI plan: after a calc the
+// nodes have all the load values and V, they would give other modes
+static int optCompile(optRunTy* runPtr) {
+   pbCtx* ctx=runPtr->ctx;
+   if (pbCompileNodes(ctx)!=0) return -1;
+   for (int k0=0; k0<runPtr->nodes0; k0++) {
+      int k=runPtr->node0[k0]->pix;
+      if (k<0) continue;
+      int ins=runPtr->in0[k0+1]-runPtr->in0[k0];
+      if (ins>PlanIns(&ctx->plan, k)) ins=PlanIns(&ctx->plan, k);
+      memcpy(&ctx->plan.mode[ctx->plan.in[k]], &runPtr->mode0[runPtr->in0[k0]], ins);
+   }
+   for (int d=0; d<runPtr->decs; d++) { // wired inputs as the INI one
+      optDecTy* decPtr=&runPtr->dec[d];
+      int k=decPtr->node->pix;
+      if (decPtr->optPtr->kind!=OptFeed || k<0) continue;
+      u08* modePtr=&ctx->plan.mode[ctx->plan.in[k]];
+      for (int j=1; j<decPtr->choices; j++) modePtr[decPtr->slot[j]]=modePtr[decPtr->slot[0]];
+   }
+   return 0;
+} // int optCompile(optRunTy* runPtr)
+
+// value of the goal on the calculated nodes
+static double optValue(pbCtx* ctx, int goal) {
+   if (goal==OptGoalP) return *ctx->plan.node[0]->Po;
+   double Pd=0;
+   for (int k=1; k<ctx->plan.nodes; k++) {
+      if (ctx->plan.type[k]!=3) Pd+=*ctx->plan.node[k]->Pd;
+   }
+   return Pd;
+} // double optValue(pbCtx* ctx, int goal)
+
+// search the design alternatives of the file for min total Pd of regulators
+// and RS, or min IN P, with every regulator Vi-Vo at least DVmin. Every SR/LR
+// type choice and SR, LR, RS feed choice is a plan, the ones with a loop of
+// inputs are skipped. On a plan a branch and bound over Vo and LD feeds: the
+// nodes fixed by the decisions taken give a lower bound, calculated on batch
+// lanes by threads. Show the best choices, then nodes are back to INI values
+int optimize(pbCtx* ctx, int goal, int threads) {
+   if (ctx->optList.cnt==0) {
+      printf("WARN: no design alternatives in file\n");
+      return 0;
+   }
+   if (!ctx->plan.valid && pbCompileNodes(ctx)!=0) return -1;
+   if (!ctx->plan.solved && pbCalcNodes(ctx)!=0) return -1;
+   if (threads<1) threads=sysconf(_SC_NPROCESSORS_ONLN);
+   if (threads<1) threads=1;
+   const char* goalPtr=(goal==OptGoalP) ? "IN P" : "Pd";
+   double ini=optValue(ctx, goal);
+   optRunTy run;
+   memset(&run, 0, sizeof(run));
+   run.ctx=ctx;
+   run.goal=goal;
+   run.dec=calloc(ctx->optList.cnt, sizeof(optDecTy));
+   optLinkTy* link=calloc(ctx->optList.cnt+1, sizeof(optLinkTy));
+   run.suf=malloc((ctx->optList.cnt+1)*sizeof(double));
+   run.bestC=calloc(ctx->optList.cnt+1, sizeof(int));
+   int* bestC=calloc(ctx->optList.cnt+1, sizeof(int));
+   run.nodes0=ctx->plan.nodes;
+   run.node0=malloc(ctx->plan.nodes*sizeof(nTy*));
+   run.in0=malloc((ctx->plan.nodes+1)*sizeof(int));
+   run.mode0=malloc(ctx->plan.inputs);
+   memcpy(run.node0, ctx->plan.node, ctx->plan.nodes*sizeof(nTy*));
+   memcpy(run.in0, ctx->plan.in, (ctx->plan.nodes+1)*sizeof(int));
+   memcpy(run.mode0, ctx->plan.mode, ctx->plan.inputs);
+   pthread_mutex_init(&run.lock, NULL);
+   u08 lev=ctx->lev;
+   int types=0, links=0, out=0, bound=1;
+   long plans=1, bestPlan=-1;
+   double best=INFINITY;
+   optTy* type[OptMaxType];
+   int typeOld[OptMaxType];
+   double parOld[OptMaxType];
+   for (int o=0; o<ctx->optList.cnt; o++) {
+      optTy* optPtr=&ctx->optList.opt[o];
+      if (optPtr->node->pix<0) continue;
+      if (optPtr->kind==OptType) {
+         if (types==OptMaxType) {
+            printf("ERROR: more than %d asLR/asSR alternatives\n", OptMaxType);
+            out=-1; goto done;
+         }
+         typeOld[types]=optPtr->node->type;
+         parOld[types]=(optPtr->node->type==1) ? *optPtr->node->Iadj : *optPtr->node->yeld;
+         type[types++]=optPtr;
+         continue;
+      }
+      if (optPtr->kind==OptFeed && optPtr->node->type!=3) { // SR, LR, RS feed
+         optLinkTy* linkPtr=&link[links++];
+         linkPtr->optPtr=optPtr;
+         linkPtr->node=optPtr->node;
+         if (optLinks(ctx, linkPtr)!=0) { out=-1; goto done; }
+         continue;
+      }
+      optDecTy* decPtr=&run.dec[run.decs++];
+      decPtr->optPtr=optPtr;
+      decPtr->node=optPtr->node;
+      decPtr->choices=optPtr->cnt;
+      if (optPtr->kind==OptFeed && optWire(ctx, decPtr)!=0) { out=-1; goto done; }
+   }
+   plans<<=types;
+   for (int j=0; j<links; j++) {
+      plans*=link[j].choices;
+      if (plans>OptMaxPlan) {
+         printf("ERROR: more than %d plans of asLR/asSR and f0opt alternatives\n", OptMaxPlan);
+         out=-1; goto done;
+      }
+   }
+   if (ctx->lev>PRINTBATCH) ctx->lev=PRINTBATCH;
+   if (optCompile(&run)!=0) { out=-1; goto done; }
+   qsort(run.dec, run.decs, sizeof(optDecTy), cmpDecDown); // same order on every plan
+   double combs=plans;
+   for (int d=0; d<run.decs; d++) combs*=run.dec[d].choices;
+   printf("Optimizer goal:min %s decisions:%d types:%d feeds:%d combinations:%g threads:%d\n", goalPtr, run.decs, types, links, combs, threads);
+   if (links>0 && ctx->lev>PRINTERROR) ctx->lev=PRINTERROR; // no warn on the nodes a loop leaves out
+   for (long plan=0; plan<plans; plan++) { // plan of every SR/LR type and feed choice
+      int mask=plan&((1<<types)-1);
+      long r=plan>>types;
+      for (int j=0; j<links; j++) {
+         optLinkSet(ctx, &link[j], r%link[j].choices);
+         r/=link[j].choices;
+      }
+      for (int j=0; j<types; j++) {
+         nTy* node=type[j]->node;
+         int as=(mask>>j)&1;
+         node->type=as ? 3-typeOld[j] : typeOld[j];
+         if (typeOld[j]==1) *node->Iadj=as ? type[j]->val[0] : parOld[j];
+         else *node->yeld=as ? type[j]->val[0] : parOld[j];
+      }
+      if (optCompile(&run)!=0) { out=-1; break; }
+      int k0=0;
+      while (k0<run.nodes0 && run.node0[k0]->pix>=0) k0++;
+      if (k0<run.nodes0) continue; // a feed in a loop of inputs, nodes left out
+      run.best=best;
+      if (optPlan(&run, threads)!=0) { out=-1; break; }
+      bound&=run.bound;
+      if (!run.has) continue;
+      best=run.best;
+      bestPlan=plan;
+      memcpy(bestC, run.bestC, run.decs*sizeof(int));
+   }
+   for (int j=0; j<types; j++) { // back to INI types
+      nTy* node=type[j]->node;
+      node->type=typeOld[j];
+      if (typeOld[j]==1) *node->Iadj=parOld[j];
+      else *node->yeld=parOld[j];
+   }
+   ctx->lev=lev;
+   if (out==0) {
+      printf("INI design %s:%g W\n", goalPtr, ini);
+      printf("calculated:%llu pruned subtrees:%llu%s\n", (unsigned long long)run.calc, (unsigned long long)run.pruned,
+             bound ? "" : " (no bound: negative Pd or load, or given V)");
+      if (bestPlan<0) {
+         printf("WARN: no combination keep every regulator Vi-Vo at least DVmin\n");
+      } else {
+         printf("Best %s:%g W, %g W less than INI design\n", goalPtr, best, ini-best);
+         printf("node   refdes  choice\n");
+         for (int j=0; j<types; j++) {
+            nTy* node=type[j]->node;
+            int as=(bestPlan>>j)&1;
+            const char* asPtr=((typeOld[j]==1)^as) ? "SR" : "LR";
+            if (as) printf("%-6s %-7s as %s %s=%g\n", node->name, node->refdes, asPtr, (typeOld[j]==1) ? "Iadj" : "n", type[j]->val[0]);
+            else printf("%-6s %-7s as %s\n", node->name, node->refdes, asPtr);
+         }
+         long r=bestPlan>>types;
+         for (int j=0; j<links; j++) {
+            nTy* node=link[j].node;
+            printf("%-6s %-7s f0=%s\n", node->name, node->refdes, NodeAt(&ctx->nList, link[j].from[r%link[j].choices])->name);
+            r/=link[j].choices;
+         }
+         for (int d=0; d<run.decs; d++) {
+            optDecTy* decPtr=&run.dec[d];
+            nTy* node=decPtr->node;
+            if (decPtr->optPtr->kind==OptVo) printf("%-6s %-7s Vo=%g\n", node->name, node->refdes, decPtr->optPtr->val[bestC[d]]);
+            else printf("%-6s %-7s f%d=%s\n", node->name, node->refdes, decPtr->optPtr->input, node->in[decPtr->slot[bestC[d]]]);
+         }
+      }
+      printf("\n");
+   }
+   done:
+   for (int d=0; d<run.decs; d++) { // back to INI links
+      if (run.dec[d].optPtr->kind==OptFeed) optUnwire(ctx, &run.dec[d]);
+   }
+   for (int j=0; j<links; j++) {
+      if (link[j].from) optLinkSet(ctx, &link[j], 0);
+      free(link[j].from);
+   }
+   free(link);
+   if (ctx->lev>PRINTBATCH) ctx->lev=PRINTBATCH;
+   if (optCompile(&run)!=0 || pbCalcNodes(ctx)!=0) out=-1;
+   ctx->lev=lev;
+   pthread_mutex_destroy(&run.lock);
+   free(run.node0);
+   free(run.in0);
+   free(run.mode0);
+   for (int d=0; d<run.decs; d++) free(run.dec[d].slot);
+   free(run.dec);
+   free(run.suf);
+   free(run.bestC);
+   free(bestC);
+   return out;
+} // int optimize(pbCtx* ctx, int goal, int threads)
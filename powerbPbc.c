@@ -0,0 +1,610 @@
+/* PowerBudget v0.00.01a 2024/09/08 calculate power dissipation and budget */
+/* Copyright 2024 Valerio Messina http://users.iol.it/efa              */
+/* powerbPbc.c is part of PowerBudget
+   PowerBudget is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   PowerBudget is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with PowerBudget. If not, see <http://www.gnu.org/licenses/>. */
+
+/* powerbPbc.c LIB: compiled designs, a loaded INI saved as binary .pbc */
+
+#include <stdio.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#include "powerbLib.h"
+#include "fileIo.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#define PbcMagic   "PBC\x1a"
+#define PbcVersion 2
+#define PbcEndian  0x01020304u // as written, another value is another byte order
+#define PbcAlign   8           // every table starts on a double
+
+// A .pbc holds the nodes as loadINI() leaves them: links resolved to node
+// indexes, GUI col/row left to pbLayoutNodes(). Tables are at offsets from
+// the file start, strings at offsets in the string table, curves at indexes
+// in the doubles
+typedef struct pbcHeadTy {
+    char magic[4];  // PbcMagic
+    u32 version;    // PbcVersion
+    u32 endian;     // PbcEndian
+    u32 headSize;   // sizeof(pbcHeadTy)
+    u64 fileSize;
+    u64 srcHash;    // FNV-1a of the INI bytes
+    s64 srcSize;    // INI bytes
+    s64 srcTime;    // INI mtime, s
+    u64 src;        // string: INI file name, absolute when possible
+    s32 nodes;      // in pool order, BOARD too
+    s32 inputs;     // input slots of all nodes, node after node
+    s32 tols;
+    s32 profs;
+    s32 therms;
+    s32 opts;
+    s32 effs;
+    s32 hasBat;     // 1 when bat is a battery
+    u64 nodeOff;    // [nodes] pbcNodeTy
+    u64 fromOff;    // [inputs] s32 node index above, -1 if none
+    u64 inOff;      // [inputs] u64 string: name of node above
+    u64 ViOff;      // [inputs] double
+    u64 IiOff;
+    u64 ROff;
+    u64 PiOff;
+    u64 tolOff;     // [tols] pbcTolTy
+    u64 profOff;    // [profs] pbcProfTy
+    u64 thermOff;   // [therms] pbcThermTy
+    u64 optOff;     // [opts] pbcOptTy
+    u64 effOff;     // [effs] pbcEffTy
+    u64 batOff;     // pbcBatTy
+    u64 dblOff;     // [dbls] double: curve points, Voopt values
+    u64 dbls;
+    u64 strOff;     // [strBytes] NUL terminated strings, last byte NUL
+    u64 strBytes;
+} pbcHeadTy;
+
+typedef struct pbcNodeTy {
+    u64 name;       // string
+    char label[16];
+    char refdes[8];
+    s32 type;
+    s32 ins;        // input slots, the next ones of the input tables
+    s32 eff;        // pbcEffTy index, -1 for constant yeld
+    s32 pad;
+    double yeld, Iadj, DV, Pd, Vo, Io, Po, DVmin;
+} pbcNodeTy;
+
+typedef struct pbcTolTy {
+    s32 node, field, input, rel, dist, pad;
+    double nom, tol;
+} pbcTolTy;
+
+typedef struct pbcProfTy {
+    s32 node, input, kind, pad;
+    double dt;
+    u64 fileName;   // string
+} pbcProfTy;
+
+typedef struct pbcThermTy {
+    s32 node, pad;
+    double Rth, Ta, Tmax, tc, Tj;
+} pbcThermTy;
+
+typedef struct pbcOptTy {
+    s32 node, kind, input, cnt;
+    u64 val;        // double index of cnt values, not for OptFeed
+    u64 names;      // string, only for OptFeed
+} pbcOptTy;
+
+typedef struct pbcEffTy {
+    s32 cI, cV;     // Io and Vi points
+    u64 Io;         // double index [cI]
+    u64 Vi;         // double index [cV]
+    u64 n;          // double index [cV+1][cI+1], last row and column repeated
+    u64 src;        // string: eff as read from INI
+} pbcEffTy;
+
+typedef struct pbcBatTy {
+    double cap, soc0, Rint, Vcut, dt;
+    s32 cnt, pad;   // SOC points
+    u64 soc;        // double index [cnt]
+    u64 Voc;        // double index [cnt+1]
+} pbcBatTy;
+
+typedef struct pbcBufTy { // file under construction
+    char* buf;
+    size_t fill;
+    size_t max;
+    int err;        // out of memory
+} pbcBufTy;
+
+// FNV-1a of the bytes of a file, to find a .pbc older than its INI
+static u64 pbcHash(const char* bufPtr, size_t len) {
+   u64 h=14695981039346656037ull;
+   for (size_t b=0; b<len; b++) h=(h^(u08)bufPtr[b])*1099511628211ull;
+   return h;
+} // u64 pbcHash(const char* bufPtr, size_t len)
+
+// append bytes aligned to PbcAlign, return their offset
+static u64 pbcPut(pbcBufTy* bPtr, const void* dataPtr, size_t bytes) {
+   size_t off=(bPtr->fill+PbcAlign-1)&~(size_t)(PbcAlign-1);
+   if (off+bytes>bPtr->max) {
+      size_t max=bPtr->max ? 2*bPtr->max : 1<<16;
+      while (max<off+bytes) max*=2;
+      char* bufPtr=realloc(bPtr->buf, max);
+      if (bufPtr==NULL) { bPtr->err=1; return 0; }
+      bPtr->buf=bufPtr;
+      bPtr->max=max;
+   }
+   memset(bPtr->buf+bPtr->fill, 0, off-bPtr->fill);
+   if (bytes) memcpy(bPtr->buf+off, dataPtr, bytes);
+   bPtr->fill=off+bytes;
+   return off;
+} // u64 pbcPut(pbcBufTy* bPtr, const void* dataPtr, size_t bytes)
+
+// append a string with its NUL, no alignment, return its offset
+static u64 pbcStr(pbcBufTy* bPtr, const char* strPtr) {
+   size_t bytes=strlen(strPtr)+1;
+   if (bPtr->fill+bytes>bPtr->max) {
+      size_t max=bPtr->max ? 2*bPtr->max : 1<<16;
+      while (max<bPtr->fill+bytes) max*=2;
+      char* bufPtr=realloc(bPtr->buf, max);
+      if (bufPtr==NULL) { bPtr->err=1; return 0; }
+      bPtr->buf=bufPtr;
+      bPtr->max=max;
+   }
+   memcpy(bPtr->buf+bPtr->fill, strPtr, bytes);
+   bPtr->fill+=bytes;
+   return bPtr->fill-bytes;
+} // u64 pbcStr(pbcBufTy* bPtr, const char* strPtr)
+
+// append doubles to the doubles table, return the index of the first
+static u64 pbcDbl(pbcBufTy* bPtr, const double* valPtr, int cnt) {
+   return pbcPut(bPtr, valPtr, cnt*sizeof(double))/sizeof(double);
+} // u64 pbcDbl(pbcBufTy* bPtr, const double* valPtr, int cnt)
+
+// write a design just loaded from graphFile in pbcFile, with the hash of
+// the INI to find it stale later. Return 0 or -1 on error
+int pbSavePBC(pbCtx* ctx, char* graphFile, char* pbcFile) {
+   int ret=-1;
+   nListTy* listPtr=&ctx->nList;
+   pbcBufTy file={NULL, 0, 0, 0}, str={NULL, 0, 0, 0}, dbl={NULL, 0, 0, 0};
+   int* mapPtr=malloc((listPtr->used+1)*sizeof(int)); // pool index ==> file index
+   char* srcPtr=NULL;
+   pbcHeadTy head;
+   memset(&head, 0, sizeof(head));
+   if (mapPtr==NULL) goto done;
+   struct stat st;
+   off_t srcLen=readFile(graphFile, &srcPtr);
+   if (srcLen<0 || stat(graphFile, &st)!=0) {
+      printf("Cannot read INI file:'%s'. Quit\n", graphFile);
+      goto done;
+   }
+   memcpy(head.magic, PbcMagic, 4);
+   head.version=PbcVersion;
+   head.endian=PbcEndian;
+   head.headSize=sizeof(pbcHeadTy);
+   head.srcHash=pbcHash(srcPtr, srcLen);
+   head.srcSize=srcLen;
+   head.srcTime=st.st_mtime;
+   char pathPtr[PATH_MAX+1];
+#ifndef _WIN32
+   if (realpath(graphFile, pathPtr)==NULL) snprintf(pathPtr, sizeof(pathPtr), "%s", graphFile);
+#else
+   if (_fullpath(pathPtr, graphFile, sizeof(pathPtr))==NULL) snprintf(pathPtr, sizeof(pathPtr), "%s", graphFile);
+#endif
+   pbcStr(&str, ""); // offset 0 is the empty string
+   head.src=pbcStr(&str, pathPtr);
+   pbcPut(&file, &head, sizeof(head)); // placeholder, written again at end
+
+   for (nTy* nPtr=nListFirst(listPtr); nPtr; nPtr=nListNext(listPtr, nPtr)) mapPtr[nPtr->ix]=head.nodes++;
+   pbcNodeTy* nodePtr=calloc(head.nodes ? head.nodes : 1, sizeof(pbcNodeTy));
+   if (nodePtr==NULL) goto done;
+   int n=0;
+   for (nTy* nPtr=nListFirst(listPtr); nPtr; nPtr=nListNext(listPtr, nPtr), n++) {
+      head.inputs+=nPtr->ins;
+      if (nPtr->eff) head.effs++;
+   }
+   s32* fromPtr=malloc((head.inputs+1)*sizeof(s32));
+   u64* inPtr=malloc((head.inputs+1)*sizeof(u64));
+   double* valPtr[4];
+   for (int v=0; v<4; v++) valPtr[v]=malloc((head.inputs+1)*sizeof(double));
+   pbcEffTy* effPtr=calloc(head.effs+1, sizeof(pbcEffTy));
+   if (fromPtr && inPtr && valPtr[0] && valPtr[1] && valPtr[2] && valPtr[3] && effPtr) {
+      int f=0, e=0;
+      n=0;
+      for (nTy* nPtr=nListFirst(listPtr); nPtr; nPtr=nListNext(listPtr, nPtr), n++) {
+         pbcNodeTy* pPtr=&nodePtr[n];
+         pPtr->name=pbcStr(&str, nPtr->name);
+         snprintf(pPtr->label, sizeof(pPtr->label), "%s", nPtr->label);
+         snprintf(pPtr->refdes, sizeof(pPtr->refdes), "%s", nPtr->refdes);
+         pPtr->type=nPtr->type;
+         pPtr->ins=nPtr->ins;
+         pPtr->eff=-1;
+         pPtr->yeld=*nPtr->yeld; pPtr->Iadj=*nPtr->Iadj; pPtr->DV=*nPtr->DV; pPtr->Pd=*nPtr->Pd;
+         pPtr->Vo=*nPtr->Vo; pPtr->Io=*nPtr->Io; pPtr->Po=*nPtr->Po; pPtr->DVmin=nPtr->DVmin;
+         for (int i=0; i<nPtr->ins; i++, f++) {
+            fromPtr[f]=nPtr->from[i]>=0 ? mapPtr[nPtr->from[i]] : -1;
+            inPtr[f]=nPtr->in[i][0] ? pbcStr(&str, nPtr->in[i]) : 0;
+            valPtr[0][f]=nPtr->Vi[i];
+            valPtr[1][f]=nPtr->Ii[i];
+            valPtr[2][f]=nPtr->R[i];
+            valPtr[3][f]=nPtr->Pi[i];
+         }
+         if (nPtr->eff) {
+            const effTy* ePtr=nPtr->eff;
+            effPtr[e].cI=ePtr->Io.cnt;
+            effPtr[e].cV=ePtr->Vi.cnt;
+            effPtr[e].Io=pbcDbl(&dbl, ePtr->Io.x, ePtr->Io.cnt);
+            effPtr[e].Vi=pbcDbl(&dbl, ePtr->Vi.x, ePtr->Vi.cnt);
+            effPtr[e].n=pbcDbl(&dbl, ePtr->n, (ePtr->Vi.cnt+1)*(ePtr->Io.cnt+1));
+            effPtr[e].src=pbcStr(&str, ePtr->src);
+            pPtr->eff=e++;
+         }
+      }
+      head.nodeOff=pbcPut(&file, nodePtr, head.nodes*sizeof(pbcNodeTy));
+      head.fromOff=pbcPut(&file, fromPtr, head.inputs*sizeof(s32));
+      head.inOff=pbcPut(&file, inPtr, head.inputs*sizeof(u64));
+      head.ViOff=pbcPut(&file, valPtr[0], head.inputs*sizeof(double));
+      head.IiOff=pbcPut(&file, valPtr[1], head.inputs*sizeof(double));
+      head.ROff=pbcPut(&file, valPtr[2], head.inputs*sizeof(double));
+      head.PiOff=pbcPut(&file, valPtr[3], head.inputs*sizeof(double));
+      head.effOff=pbcPut(&file, effPtr, head.effs*sizeof(pbcEffTy));
+   } else file.err=1;
+   free(nodePtr); free(fromPtr); free(inPtr); free(effPtr);
+   for (int v=0; v<4; v++) free(valPtr[v]);
+
+   head.tols=ctx->tolList.cnt;
+   head.tolOff=pbcPut(&file, NULL, 0);
+   for (int t=0; t<ctx->tolList.cnt; t++) {
+      const tolTy* tPtr=&ctx->tolList.tol[t];
+      pbcTolTy rec={mapPtr[tPtr->node->ix], tPtr->field, tPtr->input, tPtr->rel, tPtr->dist, 0, tPtr->nom, tPtr->tol};
+      pbcPut(&file, &rec, sizeof(rec));
+   }
+   head.profs=ctx->profList.cnt;
+   head.profOff=pbcPut(&file, NULL, 0);
+   for (int p=0; p<ctx->profList.cnt; p++) {
+      const profTy* pPtr=&ctx->profList.prof[p];
+      pbcProfTy rec={mapPtr[pPtr->node->ix], pPtr->input, pPtr->kind, 0, pPtr->dt, pbcStr(&str, pPtr->fileName)};
+      pbcPut(&file, &rec, sizeof(rec));
+   }
+   head.therms=ctx->thermList.cnt;
+   head.thermOff=pbcPut(&file, NULL, 0);
+   for (int t=0; t<ctx->thermList.cnt; t++) {
+      const thermTy* tPtr=&ctx->thermList.therm[t];
+      pbcThermTy rec={mapPtr[tPtr->node->ix], 0, tPtr->Rth, tPtr->Ta, tPtr->Tmax, tPtr->tc, tPtr->Tj};
+      pbcPut(&file, &rec, sizeof(rec));
+   }
+   head.opts=ctx->optList.cnt;
+   head.optOff=pbcPut(&file, NULL, 0);
+   for (int o=0; o<ctx->optList.cnt; o++) {
+      const optTy* oPtr=&ctx->optList.opt[o];
+      pbcOptTy rec={mapPtr[oPtr->node->ix], oPtr->kind, oPtr->input, oPtr->cnt, 0, 0};
+      if (oPtr->kind==OptFeed) rec.names=pbcStr(&str, oPtr->names);
+      else rec.val=pbcDbl(&dbl, oPtr->val, oPtr->cnt);
+      pbcPut(&file, &rec, sizeof(rec));
+   }
+   pbcBatTy bat;
+   memset(&bat, 0, sizeof(bat));
+   head.hasBat=(ctx->bat.cap!=0);
+   if (head.hasBat) {
+      bat.cap=ctx->bat.cap;
+      bat.soc0=ctx->bat.soc0;
+      bat.Rint=ctx->bat.Rint;
+      bat.Vcut=ctx->bat.Vcut;
+      bat.dt=ctx->bat.dt;
+      bat.cnt=ctx->bat.soc.cnt;
+      bat.soc=pbcDbl(&dbl, ctx->bat.soc.x, bat.cnt);
+      bat.Voc=pbcDbl(&dbl, ctx->bat.Voc, bat.cnt+1);
+   }
+   head.batOff=pbcPut(&file, &bat, sizeof(bat));
+   head.dbls=dbl.fill/sizeof(double);
+   head.dblOff=pbcPut(&file, dbl.buf, dbl.fill);
+   head.strBytes=str.fill;
+   head.strOff=pbcPut(&file, str.buf, str.fill);
+   head.fileSize=file.fill;
+   if (file.err || str.err || dbl.err) {
+      printf("No memory to compile:'%s'. Quit\n", graphFile);
+      goto done;
+   }
+   memcpy(file.buf, &head, sizeof(head));
+   FILE* filePtr=fopen(pbcFile, "wb");
+   if (filePtr==NULL) {
+      printf("Cannot write file:'%s'. Quit\n", pbcFile);
+      goto done;
+   }
+   size_t out=fwrite(file.buf, 1, file.fill, filePtr);
+   if (fclose(filePtr)!=0 || out!=file.fill) {
+      printf("Cannot write file:'%s'. Quit\n", pbcFile);
+      goto done;
+   }
+   if (PbLev(ctx)>=PRINTF) printf("Compiled nodes:%d to:'%s' Bytes:%zu\n", head.nodes, pbcFile, file.fill);
+   ret=0;
+   done:
+   free(mapPtr);
+   free(srcPtr);
+   free(file.buf);
+   free(str.buf);
+   free(dbl.buf);
+   return ret;
+} // int pbSavePBC(pbCtx* ctx, char* graphFile, char* pbcFile)
+
+// 1 when the INI a .pbc was compiled from changed, 0 when it did not or
+// cannot be read: the .pbc is then all there is
+static int pbcStale(const pbcHeadTy* headPtr, const char* srcPtr) {
+   struct stat st;
+   if (stat(srcPtr, &st)!=0) return 0;
+   if (st.st_size==headPtr->srcSize && st.st_mtime==headPtr->srcTime) return 0;
+   char* bufPtr;
+   off_t len=readFile((char*)srcPtr, &bufPtr);
+   if (len<0) return 0;
+   int stale=(len!=headPtr->srcSize || pbcHash(bufPtr, len)!=headPtr->srcHash);
+   free(bufPtr);
+   return stale;
+} // int pbcStale(const pbcHeadTy* headPtr, const char* srcPtr)
+
+// fill a cleared design from the bytes of a .pbc, Return 0 or -1 when the
+// file is not valid
+static int pbcFill(pbCtx* ctx, const char* basePtr, size_t len) {
+   const pbcHeadTy* headPtr=(const pbcHeadTy*)basePtr;
+   const pbcHeadTy head=*headPtr;
+   // tables inside the file and aligned, strings NUL terminated
+#define PbcFits(off, cnt, type) ((off)%PbcAlign==0 && (off)<=len && (u64)(cnt)<=(len-(off))/sizeof(type))
+   if (head.nodes<0 || head.inputs<0 || head.tols<0 || head.profs<0 || head.therms<0 || head.opts<0 || head.effs<0) return -1;
+   if (!PbcFits(head.nodeOff, head.nodes, pbcNodeTy) || !PbcFits(head.fromOff, head.inputs, s32) ||
+       !PbcFits(head.inOff, head.inputs, u64) || !PbcFits(head.ViOff, head.inputs, double) ||
+       !PbcFits(head.IiOff, head.inputs, double) || !PbcFits(head.ROff, head.inputs, double) ||
+       !PbcFits(head.PiOff, head.inputs, double) || !PbcFits(head.tolOff, head.tols, pbcTolTy) ||
+       !PbcFits(head.profOff, head.profs, pbcProfTy) || !PbcFits(head.thermOff, head.therms, pbcThermTy) ||
+       !PbcFits(head.optOff, head.opts, pbcOptTy) || !PbcFits(head.effOff, head.effs, pbcEffTy) ||
+       !PbcFits(head.batOff, 1, pbcBatTy) || !PbcFits(head.dblOff, head.dbls, double)) return -1;
+   if (head.strBytes==0 || head.strOff>len || head.strBytes>len-head.strOff) return -1;
+   const char* strPtr=basePtr+head.strOff;
+   if (strPtr[head.strBytes-1]!='\0') return -1;
+#define PbcStr(off) ((off)<head.strBytes ? strPtr+(off) : NULL)
+#define PbcDbl(ix, cnt) ((ix)<=head.dbls && (u64)(cnt)<=head.dbls-(ix) ? (const double*)(basePtr+head.dblOff)+(ix) : NULL)
+#define PbcNode(n) ((n)>=0 && (n)<head.nodes ? NodeAt(&ctx->nList, n) : NULL)
+   const pbcNodeTy* pNodePtr=(const pbcNodeTy*)(basePtr+head.nodeOff);
+   const s32* fromPtr=(const s32*)(basePtr+head.fromOff);
+   const u64* inPtr=(const u64*)(basePtr+head.inOff);
+   const double* ViPtr=(const double*)(basePtr+head.ViOff);
+   const double* IiPtr=(const double*)(basePtr+head.IiOff);
+   const double* RPtr=(const double*)(basePtr+head.ROff);
+   const double* PiPtr=(const double*)(basePtr+head.PiOff);
+   const pbcEffTy* pEffPtr=(const pbcEffTy*)(basePtr+head.effOff);
+
+   nListInit(&ctx->nList);
+   int f=0;
+   for (int n=0; n<head.nodes; n++) {
+      const pbcNodeTy* pPtr=&pNodePtr[n];
+      const char* namePtr=PbcStr(pPtr->name);
+      if (namePtr==NULL || pPtr->ins<1 || pPtr->ins>head.inputs-f) return -1;
+      nTy* nPtr=nListAdd(&ctx->nList);
+      if (nPtr==NULL || nListName(&ctx->nList, nPtr, namePtr)!=0 || nListInputs(&ctx->nList, nPtr, pPtr->ins)!=0) {
+         printf("No memory for node:'%s'. Quit\n", namePtr);
+         return -1;
+      }
+      nPtr->type=pPtr->type;
+      memcpy(nPtr->label, pPtr->label, sizeof(nPtr->label)); // pbcNodeTy has room for both
+      nPtr->label[sizeof(nPtr->label)-1]='\0';
+      memcpy(nPtr->refdes, pPtr->refdes, sizeof(nPtr->refdes));
+      nPtr->refdes[sizeof(nPtr->refdes)-1]='\0';
+      nPtr->out=0;
+      *nPtr->yeld=pPtr->yeld; *nPtr->Iadj=pPtr->Iadj; *nPtr->DV=pPtr->DV; *nPtr->Pd=pPtr->Pd;
+      *nPtr->Vo=pPtr->Vo; *nPtr->Io=pPtr->Io; *nPtr->Po=pPtr->Po; nPtr->DVmin=pPtr->DVmin;
+      for (int i=0; i<pPtr->ins; i++, f++) {
+         const char* inNamePtr=PbcStr(inPtr[f]);
+         if (fromPtr[f]<-1 || fromPtr[f]>=head.nodes || inNamePtr==NULL) return -1;
+         nPtr->from[i]=fromPtr[f]; // pool index: the pool was empty
+         nPtr->in[i]=inNamePtr[0] ? nListIntern(&ctx->nList, inNamePtr) : "";
+         if (nPtr->in[i]==NULL) return -1;
+         nPtr->Vi[i]=ViPtr[f];
+         nPtr->Ii[i]=IiPtr[f];
+         nPtr->R[i]=RPtr[f];
+         nPtr->Pi[i]=PiPtr[f];
+      }
+      if (pPtr->eff<0) continue;
+      if (pPtr->eff>=head.effs) return -1;
+      const pbcEffTy* ePtr=&pEffPtr[pPtr->eff];
+      if (ePtr->cI<1 || ePtr->cV<1 || ePtr->cI>USHRT_MAX || ePtr->cV>USHRT_MAX) return -1;
+      const double* IoPtr=PbcDbl(ePtr->Io, ePtr->cI);
+      const double* ViAxPtr=PbcDbl(ePtr->Vi, ePtr->cV);
+      const double* nValPtr=PbcDbl(ePtr->n, (u64)(ePtr->cV+1)*(ePtr->cI+1));
+      const char* srcPtr=PbcStr(ePtr->src);
+      if (IoPtr==NULL || ViAxPtr==NULL || nValPtr==NULL || srcPtr==NULL) return -1;
+      effTy* effPtr=calloc(1, sizeof(effTy));
+      nPtr->eff=effPtr;
+      size_t nBytes=(size_t)(ePtr->cV+1)*(ePtr->cI+1)*sizeof(double);
+      if (effPtr==NULL || effAxis(&effPtr->Io, IoPtr, ePtr->cI)!=0 || effAxis(&effPtr->Vi, ViAxPtr, ePtr->cV)!=0 ||
+          (effPtr->n=malloc(nBytes))==NULL || (effPtr->src=malloc(strlen(srcPtr)+1))==NULL) return -1;
+      memcpy(effPtr->n, nValPtr, nBytes);
+      strcpy(effPtr->src, srcPtr);
+   }
+
+   const pbcTolTy* pTolPtr=(const pbcTolTy*)(basePtr+head.tolOff);
+   if (head.tols>ctx->tolList.max) {
+      tolTy* tolPtr=realloc(ctx->tolList.tol, head.tols*sizeof(tolTy));
+      if (tolPtr==NULL) return -1;
+      ctx->tolList.tol=tolPtr;
+      ctx->tolList.max=head.tols;
+   }
+   for (int t=0; t<head.tols; t++) {
+      tolTy* tolPtr=&ctx->tolList.tol[t];
+      tolPtr->node=PbcNode(pTolPtr[t].node);
+      if (tolPtr->node==NULL) return -1;
+      tolPtr->field=pTolPtr[t].field;
+      tolPtr->input=pTolPtr[t].input;
+      tolPtr->nom=pTolPtr[t].nom;
+      tolPtr->tol=pTolPtr[t].tol;
+      tolPtr->rel=pTolPtr[t].rel;
+      tolPtr->dist=pTolPtr[t].dist;
+      if (tolPtr->input<0 || tolPtr->input>=tolPtr->node->ins) return -1;
+      ctx->tolList.cnt=t+1;
+   }
+
+   const pbcProfTy* pProfPtr=(const pbcProfTy*)(basePtr+head.profOff);
+   if (head.profs>ctx->profList.max) {
+      profTy* profPtr=realloc(ctx->profList.prof, head.profs*sizeof(profTy));
+      if (profPtr==NULL) return -1;
+      ctx->profList.prof=profPtr;
+      ctx->profList.max=head.profs;
+   }
+   for (int p=0; p<head.profs; p++) {
+      profTy* profPtr=&ctx->profList.prof[p];
+      const char* namePtr=PbcStr(pProfPtr[p].fileName);
+      profPtr->node=PbcNode(pProfPtr[p].node);
+      if (profPtr->node==NULL || namePtr==NULL) return -1;
+      profPtr->input=pProfPtr[p].input;
+      profPtr->kind=pProfPtr[p].kind;
+      profPtr->dt=pProfPtr[p].dt;
+      if (profPtr->input<0 || profPtr->input>=profPtr->node->ins) return -1;
+      profPtr->fileName=malloc(strlen(namePtr)+1);
+      if (profPtr->fileName==NULL) return -1;
+      strcpy(profPtr->fileName, namePtr);
+      ctx->profList.cnt=p+1;
+   }
+
+   const pbcThermTy* pThermPtr=(const pbcThermTy*)(basePtr+head.thermOff);
+   if (head.therms>ctx->thermList.max) {
+      thermTy* thPtr=realloc(ctx->thermList.therm, head.therms*sizeof(thermTy));
+      if (thPtr==NULL) return -1;
+      ctx->thermList.therm=thPtr;
+      ctx->thermList.max=head.therms;
+   }
+   for (int t=0; t<head.therms; t++) {
+      thermTy* thPtr=&ctx->thermList.therm[t];
+      thPtr->node=PbcNode(pThermPtr[t].node);
+      if (thPtr->node==NULL) return -1;
+      thPtr->Rth=pThermPtr[t].Rth;
+      thPtr->Ta=pThermPtr[t].Ta;
+      thPtr->Tmax=pThermPtr[t].Tmax;
+      thPtr->tc=pThermPtr[t].tc;
+      thPtr->Tj=pThermPtr[t].Tj;
+      ctx->thermList.cnt=t+1;
+   }
+
+   const pbcOptTy* pOptPtr=(const pbcOptTy*)(basePtr+head.optOff);
+   if (head.opts>ctx->optList.max) {
+      optTy* optPtr=realloc(ctx->optList.opt, head.opts*sizeof(optTy));
+      if (optPtr==NULL) return -1;
+      ctx->optList.opt=optPtr;
+      ctx->optList.max=head.opts;
+   }
+   for (int o=0; o<head.opts; o++) {
+      optTy* optPtr=&ctx->optList.opt[o];
+      memset(optPtr, 0, sizeof(optTy));
+      optPtr->node=PbcNode(pOptPtr[o].node);
+      optPtr->kind=pOptPtr[o].kind;
+      optPtr->input=pOptPtr[o].input;
+      optPtr->cnt=pOptPtr[o].cnt;
+      ctx->optList.cnt=o+1; // freed by optClear() from now on
+      if (optPtr->node==NULL || optPtr->cnt<1 || optPtr->input<0 || optPtr->input>=optPtr->node->ins) return -1;
+      if (optPtr->kind==OptFeed) {
+         const char* namesPtr=PbcStr(pOptPtr[o].names);
+         if (namesPtr==NULL || (optPtr->names=malloc(strlen(namesPtr)+1))==NULL) return -1;
+         strcpy(optPtr->names, namesPtr);
+      } else {
+         const double* valPtr=PbcDbl(pOptPtr[o].val, optPtr->cnt);
+         if (valPtr==NULL || (optPtr->val=malloc(optPtr->cnt*sizeof(double)))==NULL) return -1;
+         memcpy(optPtr->val, valPtr, optPtr->cnt*sizeof(double));
+      }
+   }
+
+   if (head.hasBat) {
+      const pbcBatTy* batPtr=(const pbcBatTy*)(basePtr+head.batOff);
+      const double* socPtr=PbcDbl(batPtr->soc, batPtr->cnt);
+      const double* VocPtr=PbcDbl(batPtr->Voc, (u64)batPtr->cnt+1);
+      if (batPtr->cnt<1 || socPtr==NULL || VocPtr==NULL) return -1;
+      ctx->bat.cap=batPtr->cap;
+      ctx->bat.soc0=batPtr->soc0;
+      ctx->bat.Rint=batPtr->Rint;
+      ctx->bat.Vcut=batPtr->Vcut;
+      ctx->bat.dt=batPtr->dt;
+      if (effAxis(&ctx->bat.soc, socPtr, batPtr->cnt)!=0) return -1;
+      ctx->bat.Voc=malloc((batPtr->cnt+1)*sizeof(double));
+      if (ctx->bat.Voc==NULL) return -1;
+      memcpy(ctx->bat.Voc, VocPtr, (batPtr->cnt+1)*sizeof(double));
+   }
+#undef PbcFits
+#undef PbcStr
+#undef PbcDbl
+#undef PbcNode
+   return 0;
+} // int pbcFill(pbCtx* ctx, const char* basePtr, size_t len)
+
+// load a compiled design in a cleared design, called by pbLoadINI(). When
+// its INI changed since the compile, the INI is loaded. Return 0 or -1
+int pbLoadPBC(pbCtx* ctx, char* pbcFile) {
+   const char* basePtr=NULL;
+   size_t len=0;
+#ifndef _WIN32
+   int fd=open(pbcFile, O_RDONLY);
+   struct stat st;
+   if (fd>=0 && fstat(fd, &st)==0 && st.st_size>=(off_t)sizeof(pbcHeadTy)) {
+      len=st.st_size;
+      void* mapPtr=mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapPtr!=MAP_FAILED) basePtr=mapPtr;
+   }
+   if (fd>=0) close(fd);
+#else
+   char* bufPtr=NULL;
+   off_t size=readFile(pbcFile, &bufPtr);
+   if (size>=(off_t)sizeof(pbcHeadTy)) { basePtr=bufPtr; len=size; }
+   else free(bufPtr);
+#endif
+   if (basePtr==NULL) {
+      printf("Cannot open file:'%s'. Quit\n", pbcFile);
+      return -1;
+   }
+   int ret=-1;
+   const pbcHeadTy* headPtr=(const pbcHeadTy*)basePtr;
+   if (memcmp(headPtr->magic, PbcMagic, 4)!=0 || headPtr->headSize!=sizeof(pbcHeadTy) || headPtr->fileSize!=len) {
+      printf("Not a compiled design:'%s'. Quit\n", pbcFile);
+      goto done;
+   }
+   if (headPtr->version!=PbcVersion || headPtr->endian!=PbcEndian) {
+      printf("Compiled design:'%s' of another version or machine, compile it again. Quit\n", pbcFile);
+      goto done;
+   }
+   const char* srcPtr="";
+   if (headPtr->strOff<len && headPtr->src<headPtr->strBytes && headPtr->src<len-headPtr->strOff) srcPtr=basePtr+headPtr->strOff+headPtr->src;
+   if (srcPtr[0] && memchr(srcPtr, '\0', len-(srcPtr-basePtr)) && pbcStale(headPtr, srcPtr)) {
+      char graphFile[strlen(srcPtr)+1];
+      strcpy(graphFile, srcPtr);
+      if (PbLev(ctx)>=PRINTWARN) printf("WARN: '%s' changed after its compile to:'%s', loading it\n", graphFile, pbcFile);
+#ifndef _WIN32
+      munmap((void*)basePtr, len);
+#else
+      free((void*)basePtr);
+#endif
+      return pbLoadINI(ctx, graphFile);
+   }
+   ret=pbcFill(ctx, basePtr, len);
+   if (ret!=0) printf("Invalid compiled design:'%s'. Quit\n", pbcFile);
+   else ret=pbValidateNodes(ctx); // the file is not trusted more than its INI
+   if (ret==0 && PbLev(ctx)>=PRINTF) {
+      printf("PBC file:'%s'\n", pbcFile);
+      printf("INI compiled:'%s'\n", srcPtr);
+      printf("Tot Nodes:%d\n", ctx->nList.nodeCnt);
+      printf("\n");
+   }
+   done:
+#ifndef _WIN32
+   munmap((void*)basePtr, len);
+#else
+   free((void*)basePtr);
+#endif
+   return ret;
+} // int pbLoadPBC(pbCtx* ctx, char* pbcFile)
@@ -0,0 +1,451 @@
+/* PowerBudget v0.00.01a 2024/09/08 calculate power dissipation and budget */
+/* Copyright 2024 Valerio Messina http://users.iol.it/efa              */
+/* powerbProf.c is part of PowerBudget
+   PowerBudget is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   PowerBudget is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with PowerBudget. If not, see <http://www.gnu.org/licenses/>. */
+
+/* powerbProf.c LIB: stream load current profiles through the compiled plan,
+   discharge the IN battery over them */
+
+#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "powerbLib.h"
+#include "fileIo.h"
+
+#define ProfLanes 1024 // time points calculated together as batch lanes
+#define BatMaxSteps 10000000ULL // battery steps before giving up the cutoff
+
+typedef struct profRdTy { // reader of one load profile, one chunk in memory
+    pbCtx* ctx;    // design, for its print level
+    profTy* profPtr;
+    chunkTy chunk;
+    int m;         // plan input slot in[k]+i fed by the profile
+    u64 n;         // samples read
+    double t, I;   // sample in use
+    double tNext;  // next sample time, HUGE_VAL at end
+    double INext;
+} profRdTy;
+
+typedef struct profJobTy { // a batch of time points solved by a thread
+    batchTy batch;
+    double* t;   // [ProfLanes] time of every point
+    double* dur; // [ProfLanes] s the point hold, until the next one
+    int used;    // lanes filled
+    int ret;
+} profJobTy;
+
+// read the next sample of a profile. Return 1, 0 at end or -1 on error
+static int profRead(profRdTy* rdPtr, double* tPtr, double* IPtr) {
+   chunkTy* c=&rdPtr->chunk;
+   profTy* profPtr=rdPtr->profPtr;
+   if (profPtr->kind!=ProfCsv) { // binary: fixed size samples
+      size_t size=(profPtr->kind==ProfF32) ? sizeof(float) : sizeof(double);
+      if (c->fill-c->pos<size && readChunk(c)<size) {
+         if (c->fill!=0 && PbLev(rdPtr->ctx)>=PRINTWARN) printf("WARN: profile:'%s' ends with %zu bytes\n", profPtr->fileName, c->fill);
+         return 0;
+      }
+      if (profPtr->kind==ProfF32) {
+         float f;
+         memcpy(&f, c->bufPtr+c->pos, sizeof(f));
+         *IPtr=f;
+      } else {
+         memcpy(IPtr, c->bufPtr+c->pos, sizeof(double));
+      }
+      c->pos+=size;
+      *tPtr=rdPtr->n*profPtr->dt;
+      rdPtr->n++;
+      return 1;
+   }
+   for (;;) { // text: "time,current" lines, skip comments and header
+      char* linePtr=c->bufPtr+c->pos;
+      char* endPtr=memchr(linePtr, '\n', c->fill-c->pos);
+      if (endPtr==NULL) {
+         if (!c->eof) {
+            if (c->pos==0 && c->fill==c->size) {
+               printf("ERROR: profile:'%s' line longer than %zu\n", profPtr->fileName, c->size);
+               return -1;
+            }
+            readChunk(c);
+            continue;
+         }
+         if (c->pos>=c->fill) return 0; // end of file
+         endPtr=c->bufPtr+c->fill; // last line without '\n'
+      }
+      *endPtr='\0';
+      c->pos=endPtr-c->bufPtr;
+      if (c->pos<c->fill) c->pos++;
+      char* chPtr=linePtr;
+      while (*chPtr==' ' || *chPtr=='\t') chPtr++;
+      if (*chPtr=='#' || *chPtr=='\r' || *chPtr=='\0') continue;
+      char* numPtr;
+      double t=strtod(chPtr, &numPtr);
+      if (numPtr==chPtr) {
+         if (rdPtr->n==0) continue; // header line
+         printf("ERROR: profile:'%s' bad line:'%s'\n", profPtr->fileName, linePtr);
+         return -1;
+      }
+      for (chPtr=numPtr; *chPtr==' ' || *chPtr=='\t' || *chPtr==',' || *chPtr==';'; chPtr++) ;
+      double I=strtod(chPtr, &numPtr);
+      if (numPtr==chPtr) {
+         printf("ERROR: profile:'%s' miss current in line:'%s'\n", profPtr->fileName, linePtr);
+         return -1;
+      }
+      *tPtr=t;
+      *IPtr=I;
+      rdPtr->n++;
+      return 1;
+   }
+} // int profRead(profRdTy* rdPtr, double* tPtr, double* IPtr)
+
+// move a profile to its next sample. Return 0 or -1 on error
+static int profAdvance(profRdTy* rdPtr) {
+   rdPtr->t=rdPtr->tNext;
+   rdPtr->I=rdPtr->INext;
+   int ret=profRead(rdPtr, &rdPtr->tNext, &rdPtr->INext);
+   if (ret<0) return -1;
+   if (ret==0) rdPtr->tNext=HUGE_VAL;
+   else if (rdPtr->tNext<rdPtr->t) {
+      printf("ERROR: profile:'%s' time going back at sample:%llu\n", rdPtr->profPtr->fileName, (unsigned long long)rdPtr->n);
+      return -1;
+   }
+   return 0;
+} // int profAdvance(profRdTy* rdPtr)
+
+typedef struct lineTy { // all profiles merged on one time line
+    pbCtx* ctx;  // design of the profiles
+    profRdTy* rd;
+    int profs;  // profiles opened
+    u08* mode;  // plan modes to restore at close
+    double t0;  // time of the first point
+    double t;   // time of the next point
+    int more;   // a next point exists
+} lineTy;
+
+// open the profiles of connected LD inputs, read their first two samples and
+// set the inputs at constant current. Return 0 or -1, then call lineClose()
+static int lineOpen(pbCtx* ctx, lineTy* linePtr) {
+   memset(linePtr, 0, sizeof(*linePtr));
+   linePtr->ctx=ctx;
+   linePtr->mode=malloc(ctx->plan.inputs*sizeof(u08));
+   linePtr->rd=calloc(ctx->profList.cnt ? ctx->profList.cnt : 1, sizeof(profRdTy));
+   if (linePtr->mode==NULL || linePtr->rd==NULL) return -1;
+   memcpy(linePtr->mode, ctx->plan.mode, ctx->plan.inputs*sizeof(u08));
+   for (int p=0; p<ctx->profList.cnt; p++) {
+      profTy* profPtr=&ctx->profList.prof[p];
+      int k=profPtr->node->pix;
+      int m=(k<0) ? -1 : ctx->plan.in[k]+profPtr->input;
+      if (m<0 || ctx->plan.up[m]<0) {
+         if (PbLev(ctx)>=PRINTWARN) printf("WARN: profile:'%s' on LD:'%s' input:%d not connected, skipped\n", profPtr->fileName, profPtr->node->name, profPtr->input);
+         continue;
+      }
+      profRdTy* rdPtr=&linePtr->rd[linePtr->profs];
+      rdPtr->ctx=ctx;
+      rdPtr->profPtr=profPtr;
+      rdPtr->m=m;
+      if (openChunk(profPtr->fileName, &rdPtr->chunk, ChunkLen)!=OK) {
+         printf("ERROR: cannot open profile:'%s'\n", profPtr->fileName);
+         return -1;
+      }
+      linePtr->profs++;
+      int ret=profRead(rdPtr, &rdPtr->tNext, &rdPtr->INext);
+      if (ret==0) printf("ERROR: profile:'%s' has no samples\n", profPtr->fileName);
+      if (ret<=0 || profAdvance(rdPtr)!=0) return -1;
+      ctx->plan.mode[m]=(ctx->plan.mode[m]&FixV)|LdI; // current from the profile
+   }
+   linePtr->t0=HUGE_VAL;
+   for (int r=0; r<linePtr->profs; r++) linePtr->t0=fmin(linePtr->t0, linePtr->rd[r].t);
+   linePtr->t=linePtr->t0;
+   linePtr->more=(linePtr->profs>0);
+   return 0;
+} // int lineOpen(pbCtx* ctx, lineTy* linePtr)
+
+// give the next point of the time line: currents I[profs], its time and the
+// s it hold, until the next point. Return 1, 0 at end or -1 on error
+static int lineNext(lineTy* linePtr, double* I, double* tPtr, double* durPtr) {
+   if (!linePtr->more) return 0;
+   profRdTy* rd=linePtr->rd;
+   double tn=HUGE_VAL;
+   for (int r=0; r<linePtr->profs; r++) {
+      I[r]=rd[r].I;
+      tn=fmin(tn, rd[r].tNext);
+   }
+   *tPtr=linePtr->t;
+   *durPtr=(tn<HUGE_VAL) ? tn-linePtr->t : 0;
+   if (tn==HUGE_VAL) {
+      linePtr->more=0;
+      return 1;
+   }
+   for (int r=0; r<linePtr->profs; r++) {
+      if (rd[r].tNext==tn && profAdvance(&rd[r])!=0) return -1;
+   }
+   linePtr->t=tn;
+   return 1;
+} // int lineNext(lineTy* linePtr, double* I, double* tPtr, double* durPtr)
+
+// close the profiles and restore the plan modes
+static void lineClose(lineTy* linePtr) {
+   for (int r=0; r<linePtr->profs; r++) closeChunk(&linePtr->rd[r].chunk);
+   if (linePtr->mode) memcpy(linePtr->ctx->plan.mode, linePtr->mode, linePtr->ctx->plan.inputs*sizeof(u08));
+   free(linePtr->mode);
+   free(linePtr->rd);
+   memset(linePtr, 0, sizeof(*linePtr));
+   return;
+} // void lineClose(lineTy* linePtr)
+
+static void* profThread(void* argPtr) {
+   profJobTy* jobPtr=argPtr;
+   jobPtr->ret=batchCalc(&jobPtr->batch);
+   return NULL;
+} // void* profThread(void* argPtr)
+
+// merge all profiles on one time line, a point every time a profile has a
+// sample and every current held until its next sample. Points go in batch
+// lanes, a batch per thread, and only one chunk of every file is in RAM.
+// Show energy, average and peak power of every node: P for IN, else Pd
+int profileEnergy(pbCtx* ctx, int threads) {
+   if (ctx->profList.cnt==0) {
+      printf("WARN: no load profile in file\n");
+      return 0;
+   }
+   if (!ctx->plan.valid && pbCompileNodes(ctx)!=0) return -1;
+   if (threads<1) threads=sysconf(_SC_NPROCESSORS_ONLN);
+   if (threads<1) threads=1;
+   int out=0, jobs=0;
+   lineTy line;
+   profJobTy* job=calloc(threads, sizeof(profJobTy));
+   pthread_t* th=malloc(threads*sizeof(pthread_t));
+   double* I=malloc(ctx->profList.cnt*sizeof(double));
+   double* E=calloc(ctx->plan.nodes, sizeof(double));
+   double* Pmax=malloc(ctx->plan.nodes*sizeof(double));
+   double* tMax=calloc(ctx->plan.nodes, sizeof(double));
+   for (int k=0; k<ctx->plan.nodes; k++) Pmax[k]=-HUGE_VAL;
+
+   if (lineOpen(ctx, &line)!=0) { out=-1; goto done; }
+   if (line.profs==0) goto done;
+   for (jobs=0; jobs<threads; jobs++) {
+      job[jobs].t=malloc(ProfLanes*sizeof(double));
+      job[jobs].dur=malloc(ProfLanes*sizeof(double));
+      if (batchInit(ctx, &job[jobs].batch, ProfLanes)!=0 || !job[jobs].t || !job[jobs].dur) {
+         jobs++;
+         out=-1;
+         goto done;
+      }
+   }
+
+   u64 points=0;
+   double tEnd=line.t0;
+   while (line.more) {
+      int run=0;
+      for (; run<threads && line.more; run++) { // fill batches in time order
+         profJobTy* jobPtr=&job[run];
+         int s;
+         for (s=0; s<ProfLanes && line.more; s++) {
+            if (lineNext(&line, I, &jobPtr->t[s], &jobPtr->dur[s])<0) { out=-1; goto done; }
+            for (int r=0; r<line.profs; r++) jobPtr->batch.Ii[(size_t)line.rd[r].m*ProfLanes+s]=I[r];
+            tEnd=jobPtr->t[s];
+         }
+         jobPtr->used=s;
+      }
+      for (int j=1; j<run; j++) pthread_create(&th[j], NULL, profThread, &job[j]);
+      profThread(&job[0]);
+      for (int j=1; j<run; j++) pthread_join(th[j], NULL);
+      for (int j=0; j<run; j++) { // integrate in time order
+         profJobTy* jobPtr=&job[j];
+         if (jobPtr->ret!=0) { out=-1; goto done; }
+         for (int s=0; s<jobPtr->used; s++) {
+            if (!jobPtr->batch.fail[s]) continue;
+            printf("ERROR: no solution at t:%g s of the load profiles\n", jobPtr->t[s]);
+            out=-1; goto done;
+         }
+         for (int k=0; k<ctx->plan.nodes; k++) {
+            const double* x=((ctx->plan.type[k]==0) ? jobPtr->batch.Po : jobPtr->batch.Pd)+(size_t)k*ProfLanes;
+            for (int s=0; s<jobPtr->used; s++) {
+               E[k]+=x[s]*jobPtr->dur[s];
+               if (x[s]>Pmax[k]) {
+                  Pmax[k]=x[s];
+                  tMax[k]=jobPtr->t[s];
+               }
+            }
+         }
+         points+=jobPtr->used;
+      }
+   }
+
+   double T=tEnd-line.t0;
+   printf("Load profiles:%d points:%llu time:%g s threads:%d\n", line.profs, (unsigned long long)points, T, threads);
+   printf("node   refdes  val     energy J      avg W     peak W   t peak s\n");
+   for (int k=0; k<ctx->plan.nodes; k++) {
+      nTy* node=ctx->plan.node[k];
+      printf("%-6s %-7s %-3s %12.6g %10.6g %10.6g %10.6g\n", node->name, node->refdes,
+             (ctx->plan.type[k]==0) ? "P" : "Pd", E[k], (T>0) ? E[k]/T : Pmax[k], Pmax[k], tMax[k]);
+   }
+   printf("\n");
+   done:
+   for (int j=0; j<jobs; j++) {
+      batchFree(&job[j].batch);
+      free(job[j].t);
+      free(job[j].dur);
+   }
+   lineClose(&line);
+   free(job);
+   free(th);
+   free(I);
+   free(E);
+   free(Pmax);
+   free(tMax);
+   return out;
+} // int profileEnergy(pbCtx* ctx, int threads)
+
+// solve the board with IN at V by the dirty nodes only, return IN current
+static double batSolve(pbCtx* ctx, nTy* in, double V, u64* solvesPtr, int* errPtr) {
+   pbSetVo(ctx, in, V);
+   if (pbSolve(ctx)!=0) *errPtr=1;
+   (*solvesPtr)++;
+   return *in->Io;
+} // double batSolve(pbCtx* ctx, nTy* in, double V, u64* solvesPtr, int* errPtr)
+
+// IN terminal voltage V=Voc-Rint*I(V), by secant steps from the V of the
+// step before. Return V or 0 when the battery cannot feed the load
+static double batTerminal(pbCtx* ctx, nTy* in, double Voc, double V, u64* solvesPtr, int* errPtr) {
+   if (ctx->bat.Rint==0) V=Voc;
+   double I=batSolve(ctx, in, V, solvesPtr, errPtr);
+   double F=V-Voc+ctx->bat.Rint*I;
+   if (fabs(F)<=SolveTol) return V;
+   double Vn=Voc-ctx->bat.Rint*I; // substitution first
+   for (int iter=0; iter<MaxSolveIter && !*errPtr; iter++) {
+      if (Vn<=0) return 0; // voltage collapse
+      double In=batSolve(ctx, in, Vn, solvesPtr, errPtr);
+      double Fn=Vn-Voc+ctx->bat.Rint*In;
+      if (fabs(Fn)<=SolveTol) return Vn;
+      double Vs=(Fn!=F) ? Vn-Fn*(Vn-V)/(Fn-F) : Voc-ctx->bat.Rint*In;
+      V=Vn;
+      F=Fn;
+      Vn=Vs;
+   }
+   return 0;
+} // double batTerminal(pbCtx* ctx, nTy* in, double Voc, double V, u64* solvesPtr, int* errPtr)
+
+// discharge the IN battery from SOC0 over the mission: the LD load profiles
+// repeated until cutoff, or the INI loads. A profile point longer than the
+// battery dt is split in dt steps. At every step IN:V sag with the SOC and
+// the load on Rint, and only the nodes it changes are calculated again.
+// Show runtime to cutoff and the regulators going out of regulation, when
+// their Vi-Vo is less than DVmin. At end nodes are back to the INI values
+int batteryRun(pbCtx* ctx) {
+   if (ctx->bat.cap<=0) {
+      printf("WARN: IN has no battery Cap\n");
+      return 0;
+   }
+   if (!ctx->plan.valid && pbCompileNodes(ctx)!=0) return -1;
+   if (!ctx->plan.solved && pbCalcNodes(ctx)!=0) return -1;
+   nTy* in=ctx->plan.node[0];
+   int out=0, err=0, dropouts=0;
+   u08 lev=ctx->lev;
+   double Vnom=*in->Vo;
+   lineTy line;
+   double* I=malloc((ctx->profList.cnt+1)*sizeof(double));
+   double* Iini=malloc((ctx->profList.cnt+1)*sizeof(double)); // LD currents to restore
+   u08* drop=calloc(ctx->plan.nodes, sizeof(u08));
+   for (int p=0; p<ctx->profList.cnt; p++) Iini[p]=ctx->profList.prof[p].node->Ii[ctx->profList.prof[p].input];
+   if (lineOpen(ctx, &line)!=0) { out=-1; goto done; }
+   printf("Battery Cap:%g Ah SOC0:%g Rint:%g ohm Vcut:%g V load profiles:%d\n", ctx->bat.cap, ctx->bat.soc0, ctx->bat.Rint, ctx->bat.Vcut, line.profs);
+   printf("t s          event    node   refdes       Vi       Vo\n");
+   if (ctx->lev>PRINTBATCH) ctx->lev=PRINTBATCH; // every step is a calc
+
+   double soc=ctx->bat.soc0, V=batVoc(&ctx->bat, soc), t=0, tOff=0;
+   double Ah=0, Wh=0, Vmin=HUGE_VAL, Imax=0;
+   u64 steps=0, solves=0;
+   const char* endPtr=NULL;
+   while (endPtr==NULL && steps<BatMaxSteps) {
+      double tp=0, dur=BatMaxSteps*ctx->bat.dt; // INI loads: dt steps to the end
+      if (line.profs>0) { // next point of the mission
+         int ret=lineNext(&line, I, &tp, &dur);
+         if (ret<0) { out=-1; goto done; }
+         if (ret==0) { // mission over: again from start
+            double span=t-tOff;
+            lineClose(&line);
+            if (span<=0 || lineOpen(ctx, &line)!=0) {
+               if (span<=0) printf("ERROR: load profiles last 0 s\n");
+               out=-1;
+               goto done;
+            }
+            tOff+=span;
+            continue;
+         }
+         for (int r=0; r<line.profs; r++) {
+            profTy* profPtr=line.rd[r].profPtr;
+            pbSetLoadCurrent(ctx, profPtr->node, profPtr->input, I[r]);
+         }
+         tp+=tOff-line.t0;
+      }
+      u64 n=1;
+      double h=dur;
+      if (dur>ctx->bat.dt) {
+         n=(u64)ceil(dur/ctx->bat.dt);
+         h=dur/n;
+      }
+      for (u64 j=0; j<n && endPtr==NULL && steps<BatMaxSteps; j++) {
+         t=tp+j*h;
+         steps++;
+         V=batTerminal(ctx, in, batVoc(&ctx->bat, soc), V, &solves, &err);
+         if (err) { out=-1; goto done; }
+         if (V==0) { endPtr="no operating point"; break; }
+         if (V<ctx->bat.Vcut) { endPtr="Vcut"; break; }
+         Vmin=fmin(Vmin, V);
+         Imax=fmax(Imax, *in->Io);
+         for (int k=1; k<ctx->plan.nodes; k++) { // regulators in or out of regulation
+            if (ctx->plan.type[k]!=1 && ctx->plan.type[k]!=2) continue;
+            nTy* node=ctx->plan.node[k];
+            u08 d=(node->Vi[0]-*node->Vo<node->DVmin);
+            if (d==drop[k]) continue;
+            drop[k]=d;
+            dropouts+=d;
+            printf("%-12.6g %-8s %-6s %-7s %8.5g %8.5g\n", t, d ? "dropout" : "regulate", node->name, node->refdes, node->Vi[0], *node->Vo);
+         }
+         double q=*in->Io*h/3600; // Ah
+         if (q>0 && q>=soc*ctx->bat.cap) { // empty inside the step
+            double hEnd=soc*ctx->bat.cap*3600/(*in->Io);
+            t+=hEnd;
+            Ah+=soc*ctx->bat.cap;
+            Wh+=V*soc*ctx->bat.cap;
+            soc=0;
+            endPtr="SOC 0";
+            break;
+         }
+         soc-=q/ctx->bat.cap;
+         Ah+=q;
+         Wh+=V*q;
+         t+=h;
+      }
+   }
+   if (endPtr) printf("Runtime:%g s (%g h) to %s\n", t, t/3600, endPtr);
+   else printf("WARN: no cutoff after:%g s (%llu steps)\n", t, (unsigned long long)steps);
+   printf("SOC:%g Vmin:%g V Ipeak:%g A used:%g Ah %g Wh steps:%llu solves:%llu dropouts:%d\n",
+          soc, Vmin, Imax, Ah, Wh, (unsigned long long)steps, (unsigned long long)solves, dropouts);
+   printf("\n");
+   done:
+   for (int p=0; p<ctx->profList.cnt; p++) { // back to INI values
+      pbSetLoadCurrent(ctx, ctx->profList.prof[p].node, ctx->profList.prof[p].input, Iini[p]);
+   }
+   pbSetVo(ctx, in, Vnom);
+   lineClose(&line);
+   if (pbSolve(ctx)!=0) out=-1;
+   ctx->lev=lev;
+   free(I);
+   free(Iini);
+   free(drop);
+   return out;
+} // int batteryRun(pbCtx* ctx)
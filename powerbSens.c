@@ -0,0 +1,252 @@
+/* PowerBudget v0.00.01a 2024/09/08 calculate power dissipation and budget */
+/* Copyright 2024 Valerio Messina http://users.iol.it/efa              */
+/* powerbSens.c is part of PowerBudget
+   PowerBudget is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   PowerBudget is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with PowerBudget. If not, see <http://www.gnu.org/licenses/>. */
+
+/* powerbSens.c LIB: adjoint sensitivity of IN power and regulator Pd */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "powerbLib.h"
+#include "fileIo.h"
+
+#define SensTop 5 // parameters shown for every regulator Pd
+
+#define ParLd   0 // LD input: I, R or P as the input is given
+#define ParYeld 1 // SR n
+#define ParIadj 2 // LR Iadj
+#define ParVo   3 // IN V, SR or LR Vo
+
+typedef struct sensParTy { // a parameter of a plan node
+    int k;
+    int i;     // LD input
+    int kind;  // ParLd, ParYeld, ParIadj, ParVo
+    double d;  // derivative of the output by the parameter
+    double e;  // W moved by a 100% change of the parameter, |value*d|
+} sensParTy;
+
+typedef struct srPartTy { // partial derivatives of SR at its solution
+    double IiIo, Iin, IiVo;       // input current by Io, n and Vo, by Vi is G
+    double PdIo, PdVi, Pdn, PdVo; // dissipation by Io, Vi, n and Vo
+} srPartTy;
+
+// SR partials, n moving with Io and Vi along the eff curve when given
+static srPartTy srPart(nTy* node) {
+   srPartTy p;
+   double n=*node->yeld, Vo=*node->Vo, Io=*node->Io, Vi=node->Vi[0];
+   double nIo=0, nVi=0;
+   if (node->eff) { // eff is piecewise bilinear: central differences
+      double h=1e-6*fmax(fabs(Io), 1e-9);
+      nIo=(effLookup(node->eff, Io+h, Vi)-effLookup(node->eff, Io-h, Vi))/(2*h);
+      h=1e-6*fmax(fabs(Vi), 1e-9);
+      nVi=(effLookup(node->eff, Io, Vi+h)-effLookup(node->eff, Io, Vi-h))/(2*h);
+   }
+   p.Iin=-node->Ii[0]/n;
+   p.IiIo=Vo/(n*Vi)+p.Iin*nIo;
+   p.IiVo=Io/(n*Vi);
+   p.Pdn=-Vo*Io/(n*n);
+   p.PdIo=Vo*(1/n-1)+p.Pdn*nIo;
+   p.PdVi=p.Pdn*nVi;
+   p.PdVo=Io*(1/n-1);
+   return p;
+} // srPartTy srPart(nTy* node)
+
+// one adjoint sweep for the output of plan node o: IN P when o is 0, else
+// Pd of the regulator o. The tree is linear around the solution, with
+// G=dIi/dVi of every input from calcG(). Leaves to root: beta, how the
+// output move with the input voltage of a node, its current going up
+// apart. Root to leaves: mu, how it move with a current drawn from the
+// output of a node, voltage drops of RS above included. Then nu, how it
+// move with the output voltage of IN or a regulator, and the parameters
+static void sensSweep(pbCtx* ctx, int o, double* beta, double* sumB, double* mu, sensParTy* par, int pars) {
+   int nodes=ctx->plan.nodes;
+   for (int k=nodes-1; k>0; k--) { // leaves to root
+      nTy* node=ctx->plan.node[k];
+      beta[k]=0;
+      if (ctx->plan.type[k]==4) {
+         double den=1+node->R[0]*ctx->plan.Go[k];
+         if (den<=0) den=1; // as calcG()
+         beta[k]=sumB[k]/den;
+      }
+      if (k==o && ctx->plan.type[k]==1) beta[k]=srPart(node).PdVi;
+      if (k==o && ctx->plan.type[k]==2) beta[k]=*node->Io+*node->Iadj;
+      if (ctx->plan.mode[ctx->plan.in[k]]&FixV) beta[k]=0;
+      int u=ctx->plan.up[ctx->plan.in[k]];
+      if (ctx->plan.type[k]!=3 && u>=0) sumB[u]+=beta[k];
+   }
+   mu[0]=(o==0) ? *ctx->plan.node[0]->Vo : 0;
+   for (int k=1; k<nodes; k++) { // root to leaves
+      nTy* node=ctx->plan.node[k];
+      int u=ctx->plan.up[ctx->plan.in[k]];
+      double muU=(u>=0) ? mu[u] : 0;
+      switch (ctx->plan.type[k]) {
+      case 1: { // SR
+         srPartTy p=srPart(node);
+         mu[k]=muU*p.IiIo+((k==o) ? p.PdIo : 0);
+         break;
+      }
+      case 2: // LR
+         mu[k]=muU+((k==o) ? node->Vi[0]-*node->Vo : 0);
+         break;
+      case 4: { // RS: the current drops the output of R
+         double den=1+node->R[0]*ctx->plan.Go[k];
+         if (den<=0) den=1;
+         mu[k]=(muU-node->R[0]*sumB[k])/den;
+         break;
+      }
+      default:
+         mu[k]=0;
+      }
+   }
+   for (int p=0; p<pars; p++) { // derivatives of the parameters
+      sensParTy* parPtr=&par[p];
+      int k=parPtr->k;
+      nTy* node=ctx->plan.node[k];
+      int u=(k>0) ? ctx->plan.up[ctx->plan.in[k]+parPtr->i] : -1;
+      double muU=(u>=0) ? mu[u] : 0;
+      double d=0;
+      switch (parPtr->kind) {
+      case ParLd: { // I, R or P drawn from the node above
+         u08 mode=ctx->plan.mode[ctx->plan.in[k]+parPtr->i];
+         double Vi=node->Vi[parPtr->i];
+         if (mode&LdI) d=muU;
+         else if (mode&LdR) d=-muU*Vi/(node->R[parPtr->i]*node->R[parPtr->i]);
+         else if (mode&LdP) d=muU/Vi;
+         break;
+      }
+      case ParYeld: {
+         srPartTy sp=srPart(node);
+         d=muU*sp.Iin+((k==o) ? sp.Pdn : 0);
+         break;
+      }
+      case ParIadj:
+         d=muU+((k==o) ? node->Vi[0] : 0);
+         break;
+      case ParVo: { // nu: children see the new voltage
+         for (int e=ctx->plan.first[k]; e<ctx->plan.first[k+1]; e++) {
+            int c=ctx->plan.child[e];
+            double b=(ctx->plan.type[c]==3) ? 0 : beta[c];
+            d+=b+ctx->plan.G[ctx->plan.in[c]+ctx->plan.input[e]]*mu[k];
+         }
+         if (ctx->plan.type[k]==0) d+=(o==0) ? *node->Io : 0;
+         if (ctx->plan.type[k]==1) {
+            srPartTy sp=srPart(node);
+            d+=muU*sp.IiVo+((k==o) ? sp.PdVo : 0);
+         }
+         if (ctx->plan.type[k]==2) d+=(k==o) ? -*node->Io : 0;
+         break;
+      }
+      }
+      parPtr->d=d;
+   }
+   return;
+} // void sensSweep(pbCtx* ctx, int o, double* beta, double* sumB, double* mu, sensParTy* par, int pars)
+
+// value and name of a parameter
+static double parValue(pbCtx* ctx, const sensParTy* parPtr, char* namePtr) {
+   nTy* node=ctx->plan.node[parPtr->k];
+   int i=parPtr->i;
+   switch (parPtr->kind) {
+   case ParLd: {
+      u08 mode=ctx->plan.mode[ctx->plan.in[parPtr->k]+i];
+      if (mode&LdI) { sprintf(namePtr, "I%d", i); return node->Ii[i]; }
+      if (mode&LdR) { sprintf(namePtr, "R%d", i); return node->R[i]; }
+      sprintf(namePtr, "P%d", i);
+      return node->Pi[i];
+   }
+   case ParYeld: strcpy(namePtr, "n"); return *node->yeld;
+   case ParIadj: strcpy(namePtr, "Iadj"); return *node->Iadj;
+   }
+   strcpy(namePtr, (node->type==0) ? "V" : "Vo");
+   return *node->Vo;
+} // double parValue(pbCtx* ctx, const sensParTy* parPtr, char* namePtr)
+
+static int cmpEffect(const void* a, const void* b) { // largest effect first
+   const sensParTy* pa=a;
+   const sensParTy* pb=b;
+   return (pa->e<pb->e) - (pa->e>pb->e);
+} // int cmpEffect(const void* a, const void* b)
+
+// derivatives of IN power and of every regulator Pd by every LD load, SR n,
+// LR Iadj and IN, SR, LR output voltage, around the calculated solution.
+// One adjoint sweep for every output, not one calc for every parameter.
+// Ranked by the W moved by a 100% change of the parameter, value*d
+int sensitivity(pbCtx* ctx) {
+   if (!ctx->plan.valid && pbCompileNodes(ctx)!=0) return -1;
+   if (!ctx->plan.solved && pbCalcNodes(ctx)!=0) return -1;
+   int nodes=ctx->plan.nodes, pars=0;
+   sensParTy* par=malloc((ctx->plan.inputs+nodes)*sizeof(sensParTy));
+   double* beta=malloc(nodes*sizeof(double));
+   double* sumB=malloc(nodes*sizeof(double));
+   double* mu=malloc(nodes*sizeof(double));
+   for (int k=nodes-1; k>=0; k--) calcG(ctx, k); // conductance of every input
+   for (int k=0; k<nodes; k++) { // parameters
+      sensParTy p={k, 0, ParVo, 0, 0};
+      switch (ctx->plan.type[k]) {
+      case 0: // IN
+      case 2: // LR
+         par[pars++]=p;
+         if (ctx->plan.type[k]==2) { p.kind=ParIadj; par[pars++]=p; }
+         break;
+      case 1: // SR
+         par[pars++]=p;
+         if (ctx->plan.node[k]->eff==NULL) { p.kind=ParYeld; par[pars++]=p; }
+         break;
+      case 3: // LD
+         p.kind=ParLd;
+         for (p.i=0; p.i<PlanIns(&ctx->plan, k); p.i++) {
+            u08 mode=ctx->plan.mode[ctx->plan.in[k]+p.i];
+            if (ctx->plan.up[ctx->plan.in[k]+p.i]>=0 && mode&(LdI|LdR|LdP)) par[pars++]=p;
+         }
+         break;
+      }
+   }
+
+   char name[8];
+   memset(sumB, 0, nodes*sizeof(double));
+   sensSweep(ctx, 0, beta, sumB, mu, par, pars);
+   for (int p=0; p<pars; p++) par[p].e=fabs(par[p].d*parValue(ctx, &par[p], name));
+   qsort(par, pars, sizeof(sensParTy), cmpEffect);
+   printf("Sensitivity of IN P:%g W, parameters:%d\n", *ctx->plan.node[0]->Po, pars);
+   printf("node   refdes  par         value    dP/dpar   W per 100%%\n");
+   for (int p=0; p<pars; p++) {
+      nTy* node=ctx->plan.node[par[p].k];
+      double v=parValue(ctx, &par[p], name);
+      printf("%-6s %-7s %-5s %11.5g %11.5g %11.5g\n", node->name, node->refdes, name, v, par[p].d, v*par[p].d);
+   }
+   printf("\n");
+   printf("Sensitivity of regulator Pd, top %d parameters\n", SensTop);
+   printf("node   refdes       Pd W  par node  par         value   dPd/dpar   W per 100%%\n");
+   for (int o=1; o<nodes; o++) {
+      if (ctx->plan.type[o]!=1 && ctx->plan.type[o]!=2) continue;
+      memset(sumB, 0, nodes*sizeof(double));
+      sensSweep(ctx, o, beta, sumB, mu, par, pars);
+      for (int p=0; p<pars; p++) par[p].e=fabs(par[p].d*parValue(ctx, &par[p], name));
+      qsort(par, pars, sizeof(sensParTy), cmpEffect);
+      nTy* node=ctx->plan.node[o];
+      for (int p=0; p<pars && p<SensTop && par[p].d!=0; p++) {
+         double v=parValue(ctx, &par[p], name);
+         if (p==0) printf("%-6s %-7s %10.5g", node->name, node->refdes, *node->Pd);
+         else printf("%-6s %-7s %10s", "", "", "");
+         printf("  %-8s  %-5s %11.5g %11.5g %11.5g\n", ctx->plan.node[par[p].k]->name, name, v, par[p].d, v*par[p].d);
+      }
+   }
+   printf("\n");
+   free(par);
+   free(beta);
+   free(sumB);
+   free(mu);
+   return 0;
+} // int sensitivity(pbCtx* ctx)
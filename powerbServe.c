@@ -0,0 +1,373 @@
+/* PowerBudget v0.00.01a 2024/09/08 calculate power dissipation and budget */
+/* Copyright 2024 Valerio Messina http://users.iol.it/efa              */
+/* powerbServe.c is part of PowerBudget
+   PowerBudget is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   PowerBudget is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with PowerBudget. If not, see <http://www.gnu.org/licenses/>. */
+
+/* powerbServe.c LIB: solver daemon on a Unix socket, designs kept loaded */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <strings.h>
+
+#include "powerbLib.h"
+#include "fileIo.h"
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define ServeDesigns  64 // designs kept loaded
+#define ServeClients  32 // connections served together
+#define ServeNameLen  32 // max design name, with the NUL
+#define ServeMaxFrame (1<<20) // max request bytes
+
+typedef struct designTy { // a loaded design, by name
+    char name[ServeNameLen];
+    pbCtx* ctx;
+} designTy;
+
+typedef struct clientTy { // a connection and its partial request
+    int fd;
+    char* buf;   // received bytes, a frame is 4 bytes length LE then text
+    size_t fill;
+    size_t max;
+} clientTy;
+
+typedef struct replyTy { // answer under construction, reused by all requests
+    char* buf;   // 4 bytes length then text
+    size_t fill;
+    size_t max;
+} replyTy;
+
+static volatile sig_atomic_t serveStop; // set by SIGINT, SIGTERM
+
+static void serveSignal(int sig) {
+   (void)sig;
+   serveStop=1;
+   return;
+} // void serveSignal(int sig)
+
+// append to the reply as printf, the buffer grows only when a reply is
+// bigger than all the ones before
+static void replyAdd(replyTy* replyPtr, const char* fmtPtr, ...) {
+   va_list ap;
+   for (;;) {
+      size_t room=replyPtr->max-replyPtr->fill;
+      va_start(ap, fmtPtr);
+      int len=vsnprintf(replyPtr->buf+replyPtr->fill, room, fmtPtr, ap);
+      va_end(ap);
+      if (len<0) return;
+      if ((size_t)len<room) {
+         replyPtr->fill+=len;
+         return;
+      }
+      replyPtr->max=2*replyPtr->max+len;
+      replyPtr->buf=realloc(replyPtr->buf, replyPtr->max);
+   }
+} // void replyAdd(replyTy* replyPtr, const char* fmtPtr, ...)
+
+// send the reply as one frame, 0 or -1 when the client is gone
+static int replySend(int fd, replyTy* replyPtr) {
+   u32 len=replyPtr->fill-4;
+   for (int b=0; b<4; b++) replyPtr->buf[b]=(len>>(8*b))&0xFF;
+   size_t sent=0;
+   while (sent<replyPtr->fill) {
+      ssize_t n=send(fd, replyPtr->buf+sent, replyPtr->fill-sent, MSG_NOSIGNAL);
+      if (n<0 && errno==EINTR) continue;
+      if (n<=0) return -1;
+      sent+=n;
+   }
+   return 0;
+} // int replySend(int fd, replyTy* replyPtr)
+
+static designTy* designFind(designTy* design, const char* namePtr) {
+   for (int d=0; d<ServeDesigns; d++) {
+      if (design[d].ctx && !strcmp(design[d].name, namePtr)) return &design[d];
+   }
+   return NULL;
+} // designTy* designFind(designTy* design, const char* namePtr)
+
+// results of a node on one line, full precision
+static void replyNode(replyTy* replyPtr, nTy* node) {
+   replyAdd(replyPtr, "\n%s", node->name);
+   if (node->type>=1) {
+      for (int i=0; i<node->ins; i++) {
+         if (node->from[i]<0) continue;
+         replyAdd(replyPtr, " Vi%d=%.17g Ii%d=%.17g", i, node->Vi[i], i, node->Ii[i]);
+         if (node->type==3) replyAdd(replyPtr, " R%d=%.17g P%d=%.17g", i, node->R[i], i, node->Pi[i]);
+      }
+   }
+   if (node->type>=0 && node->type!=3) {
+      replyAdd(replyPtr, " Vo=%.17g Io=%.17g Po=%.17g", *node->Vo, *node->Io, *node->Po);
+   }
+   if (node->type>=1 && node->type!=3) replyAdd(replyPtr, " Pd=%.17g", *node->Pd);
+   if (node->type==1) replyAdd(replyPtr, " n=%.17g", *node->yeld);
+   return;
+} // void replyNode(replyTy* replyPtr, nTy* node)
+
+// set a value of a node by its INI key: V or Vo, n, Iadj, R, Ix, Rx, Px.
+// -1 on a value that loadINI() rejects too
+static int nodeSet(pbCtx* ctx, nTy* node, const char* keyPtr, double value) {
+   if (!strcmp(keyPtr, "V") || !strcmp(keyPtr, "Vo")) return pbSetVo(ctx, node, value);
+   if (!strcmp(keyPtr, "n")) return pbSetYeld(ctx, node, value);
+   if (!strcmp(keyPtr, "Iadj")) return pbSetIadj(ctx, node, value);
+   if (!strcmp(keyPtr, "R") && node->type==4) return pbSetLoadR(ctx, node, 0, value);
+   if ((keyPtr[0]=='I' || keyPtr[0]=='R' || keyPtr[0]=='P') && keyPtr[1]>='0' && keyPtr[1]<='9') {
+      char* endPtr;
+      long i=strtol(keyPtr+1, &endPtr, 10);
+      if (*endPtr!='\0' || i>=node->ins) return -1;
+      if (keyPtr[0]=='I') return pbSetLoadCurrent(ctx, node, i, value);
+      if (keyPtr[0]=='R') return pbSetLoadR(ctx, node, i, value);
+      return pbSetLoadPower(ctx, node, i, value);
+   }
+   return -1;
+} // int nodeSet(pbCtx* ctx, nTy* node, const char* keyPtr, double value)
+
+// run the request in reqPtr, NUL terminated, and fill the reply. Return 1
+// to stop the daemon
+static int serveRequest(designTy* design, char* reqPtr, replyTy* replyPtr) {
+   char* arg[6];
+   int args=0;
+   char* savePtr;
+   for (char* tokPtr=strtok_r(reqPtr, " \t\r\n", &savePtr); tokPtr && args<6; tokPtr=strtok_r(NULL, " \t\r\n", &savePtr)) {
+      arg[args++]=tokPtr;
+   }
+   replyPtr->fill=4;
+   if (args==0) { replyAdd(replyPtr, "ERR empty request"); return 0; }
+   const char* cmdPtr=arg[0];
+   if (!strcmp(cmdPtr, "shutdown")) {
+      replyAdd(replyPtr, "OK");
+      return 1;
+   }
+   if (!strcmp(cmdPtr, "list")) {
+      replyAdd(replyPtr, "OK");
+      for (int d=0; d<ServeDesigns; d++) {
+         if (design[d].ctx) replyAdd(replyPtr, "\n%s nodes:%d", design[d].name, design[d].ctx->nList.nodeCnt);
+      }
+      return 0;
+   }
+   if (args<2) { replyAdd(replyPtr, "ERR invalid request:'%s'", cmdPtr); return 0; }
+   designTy* dPtr=designFind(design, arg[1]);
+   if (!strcmp(cmdPtr, "load") && args==3) { // in a new design, it replace the old one only when good
+      if (strlen(arg[1])>=ServeNameLen) { replyAdd(replyPtr, "ERR design name too long"); return 0; }
+      if (dPtr==NULL) {
+         for (int d=0; d<ServeDesigns && dPtr==NULL; d++) {
+            if (design[d].ctx==NULL) dPtr=&design[d];
+         }
+         if (dPtr==NULL) { replyAdd(replyPtr, "ERR more than %d designs", ServeDesigns); return 0; }
+      }
+      pbCtx* newPtr=pbCtxNew();
+      if (newPtr==NULL) { replyAdd(replyPtr, "ERR no memory"); return 0; }
+      newPtr->lev=PRINTWARN;
+      if (pbLoadINI(newPtr, arg[2])!=0 || pbCalcNodes(newPtr)!=0) {
+         pbCtxFree(newPtr);
+         replyAdd(replyPtr, "ERR cannot load:'%s'", arg[2]);
+         return 0;
+      }
+      if (dPtr->ctx) pbCtxFree(dPtr->ctx);
+      else strcpy(dPtr->name, arg[1]);
+      dPtr->ctx=newPtr;
+      replyAdd(replyPtr, "OK nodes:%d", dPtr->ctx->nList.nodeCnt);
+      return 0;
+   }
+   if (dPtr==NULL) { replyAdd(replyPtr, "ERR no design:'%s'", arg[1]); return 0; }
+   pbCtx* ctx=dPtr->ctx;
+   if (!strcmp(cmdPtr, "set") && args==5) {
+      nTy* node=nListFind(&ctx->nList, arg[2]);
+      char* endPtr;
+      double value=strtod(arg[4], &endPtr);
+      if (node==NULL) replyAdd(replyPtr, "ERR no node:'%s'", arg[2]);
+      else if (*endPtr!='\0' || endPtr==arg[4]) replyAdd(replyPtr, "ERR invalid value:'%s'", arg[4]);
+      else if (nodeSet(ctx, node, arg[3], value)!=0) replyAdd(replyPtr, "ERR cannot set:'%s' of:'%s' to:'%s'", arg[3], arg[2], arg[4]);
+      else replyAdd(replyPtr, "OK");
+      return 0;
+   }
+   if (!strcmp(cmdPtr, "solve") && args==2) {
+      if (pbSolve(ctx)!=0) { replyAdd(replyPtr, "ERR no solution"); return 0; } // the design stay loaded, a set may fix it
+      double Pd=0;
+      for (int k=1; k<ctx->plan.nodes; k++) {
+         if (ctx->plan.type[k]!=3) Pd+=*ctx->plan.node[k]->Pd;
+      }
+      nTy* in=ctx->plan.node[0];
+      replyAdd(replyPtr, "OK V=%.17g I=%.17g P=%.17g Pd=%.17g", *in->Vo, *in->Io, *in->Po, Pd);
+      return 0;
+   }
+   if (!strcmp(cmdPtr, "get") && (args==2 || args==3)) {
+      if (args==3) {
+         nTy* node=nListFind(&ctx->nList, arg[2]);
+         if (node==NULL) { replyAdd(replyPtr, "ERR no node:'%s'", arg[2]); return 0; }
+         replyAdd(replyPtr, "OK");
+         replyNode(replyPtr, node);
+         return 0;
+      }
+      replyAdd(replyPtr, "OK");
+      for (nTy* nPtr=nListFirst(&ctx->nList); nPtr; nPtr=nListNext(&ctx->nList, nPtr)) {
+         if (nPtr->type>=0) replyNode(replyPtr, nPtr);
+      }
+      return 0;
+   }
+   if (!strcmp(cmdPtr, "save") && args==3) {
+      if (pbSaveINI(ctx, arg[2])!=0) replyAdd(replyPtr, "ERR cannot save:'%s'", arg[2]);
+      else replyAdd(replyPtr, "OK");
+      return 0;
+   }
+   if (!strcmp(cmdPtr, "drop") && args==2) {
+      pbCtxFree(ctx);
+      dPtr->ctx=NULL;
+      replyAdd(replyPtr, "OK");
+      return 0;
+   }
+   replyAdd(replyPtr, "ERR invalid request:'%s'", cmdPtr);
+   return 0;
+} // int serveRequest(designTy* design, char* reqPtr, replyTy* replyPtr)
+
+// read what the client sent and answer every whole frame. Return 0, -1
+// when the client is gone or sent a bad frame, 1 to stop the daemon
+static int serveClient(clientTy* cPtr, designTy* design, replyTy* replyPtr) {
+   if (cPtr->max-cPtr->fill<4096) {
+      cPtr->max=2*cPtr->max+4096;
+      cPtr->buf=realloc(cPtr->buf, cPtr->max);
+   }
+   ssize_t n=recv(cPtr->fd, cPtr->buf+cPtr->fill, cPtr->max-cPtr->fill-1, 0);
+   if (n<0 && errno==EINTR) return 0;
+   if (n<=0) return -1;
+   cPtr->fill+=n;
+   size_t pos=0;
+   int out=0;
+   while (out==0 && cPtr->fill-pos>=4) {
+      const u08* lenPtr=(const u08*)cPtr->buf+pos;
+      u32 len=lenPtr[0] | lenPtr[1]<<8 | lenPtr[2]<<16 | (u32)lenPtr[3]<<24;
+      if (len>ServeMaxFrame) return -1;
+      if (cPtr->fill-pos-4<len) {
+         if (cPtr->max<len+5) { // room for the whole frame and its NUL
+            cPtr->max=len+5;
+            cPtr->buf=realloc(cPtr->buf, cPtr->max);
+         }
+         break;
+      }
+      char* reqPtr=cPtr->buf+pos+4;
+      char end=reqPtr[len];
+      reqPtr[len]='\0';
+      out=serveRequest(design, reqPtr, replyPtr);
+      reqPtr[len]=end;
+      pos+=4+len;
+      if (replySend(cPtr->fd, replyPtr)!=0) return -1;
+   }
+   memmove(cPtr->buf, cPtr->buf+pos, cPtr->fill-pos);
+   cPtr->fill-=pos;
+   return out;
+} // int serveClient(clientTy* cPtr, designTy* design, replyTy* replyPtr)
+
+// solver daemon: keep designs loaded by name and answer framed requests on
+// the Unix socket sockFile, until "shutdown", SIGINT or SIGTERM. A frame is
+// 4 bytes length, little endian, then the text:
+//   load D FILE        load and calc FILE as design D
+//   set D NODE KEY V   set V, Vo, n, Iadj, R or LD Ix, Rx, Px of NODE
+//   solve D            calc only what set changed: IN V I P and total Pd
+//   get D [NODE]       results of every node or of NODE
+//   save D FILE        write the res INI of D
+//   drop D             forget D
+//   list               loaded designs
+//   shutdown           stop the daemon
+// Every answer is a frame starting with "OK" or "ERR"
+int serve(char* sockFile) {
+   struct sockaddr_un addr;
+   if (strlen(sockFile)>=sizeof(addr.sun_path)) {
+      printf("Socket name too long:'%s'. Quit\n", sockFile);
+      return -1;
+   }
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family=AF_UNIX;
+   strcpy(addr.sun_path, sockFile);
+   int lfd=socket(AF_UNIX, SOCK_STREAM, 0);
+   if (lfd<0) {
+      printf("Cannot open socket. Quit\n");
+      return -1;
+   }
+   unlink(sockFile); // left by a daemon before
+   if (bind(lfd, (struct sockaddr*)&addr, sizeof(addr))!=0 || listen(lfd, ServeClients)!=0) {
+      printf("Cannot listen on socket:'%s'. Quit\n", sockFile);
+      close(lfd);
+      return -1;
+   }
+   struct sigaction sa;
+   memset(&sa, 0, sizeof(sa));
+   sa.sa_handler=serveSignal;
+   sigaction(SIGINT, &sa, NULL);
+   sigaction(SIGTERM, &sa, NULL);
+   serveStop=0;
+
+   designTy* design=calloc(ServeDesigns, sizeof(designTy));
+   clientTy* client=calloc(ServeClients, sizeof(clientTy));
+   struct pollfd fds[ServeClients+1];
+   replyTy reply={malloc(4096), 4, 4096};
+   int clients=0;
+   printf("Serving on:'%s'\n", sockFile);
+   fflush(stdout);
+   while (!serveStop) {
+      fds[0].fd=lfd;
+      fds[0].events=(clients<ServeClients) ? POLLIN : 0;
+      for (int c=0; c<clients; c++) {
+         fds[c+1].fd=client[c].fd;
+         fds[c+1].events=POLLIN;
+      }
+      if (poll(fds, clients+1, -1)<0) {
+         if (errno==EINTR) continue;
+         break;
+      }
+      for (int c=clients-1; c>=0 && !serveStop; c--) {
+         if (!(fds[c+1].revents&(POLLIN|POLLHUP|POLLERR))) continue;
+         int ret=serveClient(&client[c], design, &reply);
+         if (ret>0) serveStop=1;
+         if (ret<0) { // gone: last client takes its place
+            close(client[c].fd);
+            free(client[c].buf);
+            client[c]=client[--clients];
+         }
+      }
+      if (fds[0].revents&POLLIN && !serveStop) {
+         int fd=accept(lfd, NULL, NULL);
+         if (fd>=0) {
+            memset(&client[clients], 0, sizeof(clientTy));
+            client[clients++].fd=fd;
+         }
+      }
+   }
+   for (int c=0; c<clients; c++) {
+      close(client[c].fd);
+      free(client[c].buf);
+   }
+   close(lfd);
+   unlink(sockFile);
+   for (int d=0; d<ServeDesigns; d++) pbCtxFree(design[d].ctx);
+   free(design);
+   free(client);
+   free(reply.buf);
+   printf("Served\n");
+   return 0;
+} // int serve(char* sockFile)
+
+#else
+
+int serve(char* sockFile) {
+   printf("Unix socket:'%s' not supported on this system. Quit\n", sockFile);
+   return -1;
+} // int serve(char* sockFile)
+
+#endif
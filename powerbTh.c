@@ -0,0 +1,156 @@
+/* PowerBudget v0.00.01a 2024/09/08 calculate power dissipation and budget */
+/* Copyright 2024 Valerio Messina http://users.iol.it/efa              */
+/* powerbTh.c is part of PowerBudget
+   PowerBudget is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   PowerBudget is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with PowerBudget. If not, see <http://www.gnu.org/licenses/>. */
+
+/* powerbTh.c LIB: coupled electro-thermal solve, junction temperatures */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "powerbLib.h"
+#include "fileIo.h"
+
+#define ThermTol 1e-3    // C, settled when no Tj moves more than this
+#define ThermMaxIter 50  // max passes of calc and Tj
+#define ThermRunaway 1e3 // C, Tj above this is a thermal runaway
+
+// set the temperature dependent values of a node at Tj from its INI values
+// in base[ins]: n of SR, Iadj of LR, R of RS, every load input of LD.
+// Return -1 when Tj take a value out of its valid range
+static int thermSet(pbCtx* ctx, thermTy* thPtr, const double* base, double Tj) {
+   nTy* node=thPtr->node;
+   double f=1+thPtr->tc*(Tj-TcRef);
+   if (f<0) f=0;
+   int out=0;
+   switch (node->type) {
+   case 1: // SR
+      if (node->eff==NULL) out=pbSetYeld(ctx, node, fmin(base[0]*f, 1));
+      break;
+   case 2: // LR
+      out=pbSetIadj(ctx, node, base[0]*f);
+      break;
+   case 4: // RS
+      out=pbSetLoadR(ctx, node, 0, base[0]*f);
+      break;
+   case 3: // LD: load current scale with f
+      for (int i=0; i<node->ins && out==0; i++) {
+         u08 mode=ctx->plan.mode[ctx->plan.in[node->pix]+i];
+         if (mode&LdI) out=pbSetLoadCurrent(ctx, node, i, base[i]*f);
+         else if (mode&LdR && f>0) out=pbSetLoadR(ctx, node, i, base[i]/f);
+         else if (mode&LdP) out=pbSetLoadPower(ctx, node, i, base[i]*f);
+      }
+      break;
+   }
+   if (out!=0) printf("Tj:%g of node:'%s' out of its valid values. Quit\n", Tj, node->name);
+   return out;
+} // int thermSet(pbCtx* ctx, thermTy* thPtr, const double* base, double Tj)
+
+// alternate the calc of the nodes with Tj=Ta+Pd*Rth of the nodes with
+// thermal data, until no Tj moves more than ThermTol. A secant step on the
+// Pd slope of every node speed up the strongly heated ones. Every pass calc
+// only the nodes changed by the temperature on the compiled plan. Show Tj
+// and margin to Tmax, then nodes are back to the INI values
+int thermalSolve(pbCtx* ctx) {
+   if (ctx->thermList.cnt==0) {
+      printf("WARN: no thermal data in file\n");
+      return 0;
+   }
+   if (!ctx->plan.valid && pbCompileNodes(ctx)!=0) return -1;
+   if (!ctx->plan.solved && pbCalcNodes(ctx)!=0) return -1;
+   int out=0, iter=0, cnt=ctx->thermList.cnt;
+   u08 lev=ctx->lev;
+   double dT=0;
+   int* off=malloc((cnt+1)*sizeof(int)); // base of therm h at off[h]
+   off[0]=0;
+   for (int h=0; h<cnt; h++) off[h+1]=off[h]+ctx->thermList.therm[h].node->ins;
+   double* base=malloc(off[cnt]*sizeof(double));
+   double* TjOld=malloc(cnt*sizeof(double)); // pass before, for the secant
+   double* PdOld=malloc(cnt*sizeof(double));
+   for (int h=0; h<cnt; h++) { // INI values at TcRef
+      thermTy* thPtr=&ctx->thermList.therm[h];
+      nTy* node=thPtr->node;
+      double* b=base+off[h];
+      if (node->pix<0) continue;
+      for (int i=0; i<node->ins; i++) {
+         u08 mode=ctx->plan.mode[ctx->plan.in[node->pix]+i];
+         b[i]=(mode&LdI) ? node->Ii[i] : (mode&LdR) ? node->R[i] : node->Pi[i];
+      }
+      if (node->type==1) b[0]=*node->yeld;
+      if (node->type==2) b[0]=*node->Iadj;
+      if (node->type==4) b[0]=node->R[0];
+      if (node->type==1 && node->eff && thPtr->tc!=0 && PbLev(ctx)>=PRINTWARN) {
+         printf("WARN: SR:'%s' has eff curve, tc not used\n", node->name);
+      }
+      thPtr->Tj=thPtr->Ta+*node->Pd*thPtr->Rth;
+   }
+   if (ctx->lev>PRINTBATCH) ctx->lev=PRINTBATCH; // every pass is a calc
+   do {
+      for (int h=0; h<cnt; h++) {
+         if (ctx->thermList.therm[h].node->pix<0) continue;
+         if (thermSet(ctx, &ctx->thermList.therm[h], base+off[h], ctx->thermList.therm[h].Tj)!=0) out=-1;
+      }
+      if (out!=0 || pbSolve(ctx)!=0) { out=-1; break; }
+      dT=0;
+      for (int h=0; h<cnt; h++) { // next Tj by a secant step on Tj=Ta+Pd(Tj)*Rth
+         thermTy* thPtr=&ctx->thermList.therm[h];
+         double Pd=*thPtr->node->Pd;
+         double Tj=thPtr->Ta+Pd*thPtr->Rth;
+         dT=fmax(dT, fabs(Tj-thPtr->Tj));
+         double next=Tj;
+         if (iter>0 && thPtr->Tj!=TjOld[h]) {
+            double k=thPtr->Rth*(Pd-PdOld[h])/(thPtr->Tj-TjOld[h]); // dTj/dTj
+            if (k<0.9) next=thPtr->Tj+(Tj-thPtr->Tj)/(1-k);
+         }
+         TjOld[h]=thPtr->Tj;
+         PdOld[h]=Pd;
+         thPtr->Tj=(dT>ThermTol) ? next : Tj;
+      }
+      iter++;
+      if (!(dT<ThermRunaway)) break;
+   } while (dT>ThermTol && iter<ThermMaxIter);
+   for (int h=0; h<cnt; h++) { // Tj of the last calc
+      thermTy* thPtr=&ctx->thermList.therm[h];
+      thPtr->Tj=thPtr->Ta+*thPtr->node->Pd*thPtr->Rth;
+   }
+   ctx->lev=lev;
+
+   if (out==0) {
+      if (dT>ThermTol) printf("WARN: junction temperatures not stable after %d passes, thermal runaway?\n", iter);
+      else printf("Junction temperatures stable after %d passes\n", iter);
+      printf("node   refdes       Pd W     Ta C     Tj C   Tmax C margin C\n");
+      for (int h=0; h<cnt; h++) {
+         thermTy* thPtr=&ctx->thermList.therm[h];
+         nTy* node=thPtr->node;
+         if (node->pix<0) continue;
+         double margin=thPtr->Tmax-thPtr->Tj;
+         printf("%-6s %-7s %10.5g %8.4g %8.4g %8.4g %8.4g%s\n", node->name, node->refdes, *node->Pd,
+                thPtr->Ta, thPtr->Tj, thPtr->Tmax, margin, (margin<0) ? " OVER" : "");
+      }
+      printf("IN P:%g W at temperature\n", *ctx->plan.node[0]->Po);
+      printf("\n");
+   }
+   if (ctx->lev>PRINTBATCH) ctx->lev=PRINTBATCH;
+   for (int h=0; h<cnt; h++) { // back to INI values
+      if (ctx->thermList.therm[h].node->pix<0) continue;
+      thermSet(ctx, &ctx->thermList.therm[h], base+off[h], TcRef);
+   }
+   if (pbSolve(ctx)!=0) out=-1;
+   ctx->lev=lev;
+   free(off);
+   free(base);
+   free(TjOld);
+   free(PdOld);
+   return out;
+} // int thermalSolve(pbCtx* ctx)
@@ -0,0 +1,442 @@
+/* PowerBudget v0.00.01a 2024/09/08 calculate power dissipation and budget */
+/* Copyright 2024 Valerio Messina http://users.iol.it/efa              */
+/* powerbWc.c is part of PowerBudget
+   PowerBudget is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   PowerBudget is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with PowerBudget. If not, see <http://www.gnu.org/licenses/>. */
+
+/* powerbWc.c LIB: worst case analysis, interval bounds and box refinement */
+
+#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "powerbLib.h"
+#include "fileIo.h"
+
+#define WcBoxes 4096 // max sub boxes of the tolerance box in a refine
+
+static inline ivTy ivVal(double v) { ivTy r={v, v}; return r; }
+
+static inline ivTy ivAdd(ivTy a, ivTy b) { ivTy r={a.lo+b.lo, a.hi+b.hi}; return r; }
+
+static inline ivTy ivSub(ivTy a, ivTy b) { ivTy r={a.lo-b.hi, a.hi-b.lo}; return r; }
+
+static inline ivTy ivMul(ivTy a, ivTy b) {
+   double p1=a.lo*b.lo, p2=a.lo*b.hi, p3=a.hi*b.lo, p4=a.hi*b.hi;
+   ivTy r;
+   r.lo=fmin(fmin(p1, p2), fmin(p3, p4));
+   r.hi=fmax(fmax(p1, p2), fmax(p3, p4));
+   return r;
+} // ivTy ivMul(ivTy a, ivTy b)
+
+static inline ivTy ivSqr(ivTy a) { // a*a without the dependency of ivMul
+   if (a.lo>=0) { ivTy r={a.lo*a.lo, a.hi*a.hi}; return r; }
+   if (a.hi<=0) { ivTy r={a.hi*a.hi, a.lo*a.lo}; return r; }
+   ivTy r={0, fmax(a.lo*a.lo, a.hi*a.hi)};
+   return r;
+} // ivTy ivSqr(ivTy a)
+
+static inline ivTy ivDiv(ivTy a, ivTy b) { // as calcI(): 0 when b is 0
+   if (b.lo==0 && b.hi==0) return ivVal(0);
+   if (b.lo<=0 && b.hi>=0) { ivTy r={-INFINITY, INFINITY}; return r; }
+   ivTy inv={1/b.hi, 1/b.lo};
+   return ivMul(a, inv);
+} // ivTy ivDiv(ivTy a, ivTy b)
+
+// value of a tolerance at its side: -1 low, 0 nominal, +1 high
+double tolBound(tolTy* tolPtr, int side) {
+   if (tolPtr->rel) return tolPtr->nom*(1+side*tolPtr->tol);
+   return tolPtr->nom+side*tolPtr->tol;
+} // double tolBound(tolTy* tolPtr, int side)
+
+// interval of a node changed by a tolerance, NULL when not an input
+static ivTy* ivField(pbCtx* ctx, ivNodeTy* ivPtr, tolTy* tolPtr) {
+   int k=tolPtr->node->pix;
+   if (k<0) return NULL; // node not in plan
+   int i=tolPtr->input;
+   u08 mode=ctx->plan.mode[ctx->plan.in[k]+i];
+   switch (tolPtr->field) {
+   case TolVo:   return &ivPtr[k].Vo;
+   case TolYeld: return &ivPtr[k].yeld;
+   case TolIadj: return &ivPtr[k].Iadj;
+   case TolR:
+      if (ctx->plan.type[k]==3 && !(mode&LdR)) return NULL;
+      return &ivPtr[k].R[i];
+   case TolIi:
+      if (!(mode&LdI)) return NULL;
+      return &ivPtr[k].Ii[i];
+   case TolPi:
+      if (!(mode&LdP)) return NULL;
+      return &ivPtr[k].Pi[i];
+   }
+   return NULL;
+} // ivTy* ivField(pbCtx* ctx, ivNodeTy* ivPtr, tolTy* tolPtr)
+
+// input voltage interval of plan node k input i
+static inline ivTy ivInputV(pbCtx* ctx, ivNodeTy* ivPtr, int k, int i) {
+   int m=ctx->plan.in[k]+i;
+   if (ctx->plan.mode[m]&FixV) return ivPtr[k].Vi[i];
+   return ivPtr[ctx->plan.up[m]].Vo;
+} // ivTy ivInputV(pbCtx* ctx, ivNodeTy* ivPtr, int k, int i)
+
+// RS output voltage interval from input, return the max bound change
+static double ivRSv(pbCtx* ctx, ivNodeTy* ivPtr, int k) {
+   ivNodeTy* n=&ivPtr[k];
+   ivTy Vo=n->Vo;
+   n->Vi[0]=ivInputV(ctx, ivPtr, k, 0);
+   n->Vo=ivSub(n->Vi[0], ivMul(n->R[0], n->Io));
+   n->Po=ivMul(n->Vo, n->Io);
+   n->Pi[0]=ivMul(n->Vi[0], n->Io);
+   return fmax(fabs(n->Vo.lo-Vo.lo), fabs(n->Vo.hi-Vo.hi));
+} // double ivRSv(pbCtx* ctx, ivNodeTy* ivPtr, int k)
+
+// power drawn from plan node k by its children: the input power of a child
+// fed at Vo, so a P/V current is not multiplied back by V as an independent
+// value, else Vo*Ii. RS input power is known only after ivRSv()
+static ivTy ivDrawn(pbCtx* ctx, ivNodeTy* ivPtr, int k) {
+   ivTy P=ivVal(0);
+   for (int e=ctx->plan.first[k]; e<ctx->plan.first[k+1]; e++) {
+      int c=ctx->plan.child[e], i=ctx->plan.input[e];
+      if (ctx->plan.type[c]!=4 && !(ctx->plan.mode[ctx->plan.in[c]+i]&FixV)) P=ivAdd(P, ivPtr[c].Pi[i]);
+      else P=ivAdd(P, ivMul(ivPtr[k].Vo, ivPtr[c].Ii[i]));
+   }
+   return P;
+} // ivTy ivDrawn(pbCtx* ctx, ivNodeTy* ivPtr, int k)
+
+// both a and b bound the same value: their intersection
+static inline ivTy ivMeet(ivTy a, ivTy b) { ivTy r={fmax(a.lo, b.lo), fmin(a.hi, b.hi)}; return r; }
+
+// SR efficiency bounds over the Io, Vi box: bilinear between curve points,
+// so the extremes are on box corners or where curve points cross the box
+static ivTy ivEff(const effTy* e, ivTy Io, ivTy Vi) {
+   double f;
+   int x0=effSeg(&e->Io, Io.lo, &f)+1, x1=effSeg(&e->Io, Io.hi, &f);
+   int y0=effSeg(&e->Vi, Vi.lo, &f)+1, y1=effSeg(&e->Vi, Vi.hi, &f);
+   ivTy r={ HUGE_VAL, -HUGE_VAL };
+   for (int y=y0-1; y<=y1+1; y++) { // box edge, points inside, box edge
+      double v=y<y0 ? Vi.lo : (y>y1 ? Vi.hi : e->Vi.x[y]);
+      for (int x=x0-1; x<=x1+1; x++) {
+         double i=x<x0 ? Io.lo : (x>x1 ? Io.hi : e->Io.x[x]);
+         double n=effLookup(e, i, v);
+         r.lo=fmin(r.lo, n);
+         r.hi=fmax(r.hi, n);
+      }
+   }
+   return r;
+} // ivTy ivEff(const effTy* e, ivTy Io, ivTy Vi)
+
+// interval nodes of the plan with their inputs in one block, free() it
+ivNodeTy* ivAlloc(pbCtx* ctx) {
+   int nodes=ctx->plan.nodes, inputs=ctx->plan.inputs;
+   ivNodeTy* ivPtr=malloc(nodes*sizeof(ivNodeTy)+4*(size_t)inputs*sizeof(ivTy));
+   if (ivPtr==NULL) return NULL;
+   ivTy* inPtr=(ivTy*)(ivPtr+nodes);
+   for (int k=0; k<nodes; k++) {
+      int m=ctx->plan.in[k];
+      ivPtr[k].Vi=inPtr+m;
+      ivPtr[k].Ii=inPtr+inputs+m;
+      ivPtr[k].R=inPtr+2*inputs+m;
+      ivPtr[k].Pi=inPtr+3*inputs+m;
+   }
+   return ivPtr;
+} // ivNodeTy* ivAlloc(pbCtx* ctx)
+
+// bounds of every node value in one leaves to root pass of the plan, each
+// toleranced value in box[t] of its tolList position, or in [lo, hi] of the
+// tolerance when box is NULL
+static int ivCalc(pbCtx* ctx, ivNodeTy* ivPtr, const ivTy* box) {
+   for (int k=0; k<ctx->plan.nodes; k++) { // nominal values
+      nTy* node=ctx->plan.node[k];
+      ivNodeTy* n=&ivPtr[k];
+      n->Vo=ivVal(*node->Vo);
+      n->yeld=ivVal(*node->yeld);
+      n->Iadj=ivVal(*node->Iadj);
+      n->Io=ivVal(0);
+      n->Po=ivVal(0);
+      n->Pd=ivVal(0);
+      for (int i=0; i<PlanIns(&ctx->plan, k); i++) {
+         n->Vi[i]=ivVal(node->Vi[i]);
+         n->Ii[i]=ivVal(node->Ii[i]);
+         n->R[i]=ivVal(node->R[i]);
+         n->Pi[i]=ivVal(node->Pi[i]);
+      }
+   }
+   for (int t=0; t<ctx->tolList.cnt; t++) { // toleranced values
+      ivTy* fieldPtr=ivField(ctx, ivPtr, &ctx->tolList.tol[t]);
+      if (fieldPtr==NULL) continue;
+      if (box) { *fieldPtr=box[t]; continue; }
+      double lo=tolBound(&ctx->tolList.tol[t], -1), hi=tolBound(&ctx->tolList.tol[t], 1);
+      fieldPtr->lo=fmin(lo, hi);
+      fieldPtr->hi=fmax(lo, hi);
+   }
+   if (ctx->plan.hasRS) { // start with no voltage drop on RS
+      for (int k=1; k<ctx->plan.nodes; k++) {
+         if (ctx->plan.type[k]!=4) continue;
+         ivPtr[k].Io=ivVal(0);
+         ivRSv(ctx, ivPtr, k);
+      }
+   }
+   int iter=0;
+   double dV;
+   do {
+      for (int k=ctx->plan.nodes-1; k>=0; k--) { // leaves to root
+         ivNodeTy* n=&ivPtr[k];
+         ivTy Io=ivVal(0);
+         for (int e=ctx->plan.first[k]; e<ctx->plan.first[k+1]; e++) {
+            Io=ivAdd(Io, ivPtr[ctx->plan.child[e]].Ii[ctx->plan.input[e]]);
+         }
+         switch (ctx->plan.type[k]) {
+         case 0: // IN
+            n->Io=Io;
+            n->Po=ivMeet(ivMul(n->Vo, Io), ivDrawn(ctx, ivPtr, k));
+            break;
+         case 1: // SR
+            n->Io=Io;
+            n->Vi[0]=ivInputV(ctx, ivPtr, k, 0);
+            if (ctx->plan.node[k]->eff) n->yeld=ivEff(ctx->plan.node[k]->eff, Io, n->Vi[0]);
+            if (n->yeld.lo<=0) { printf("ERROR: yeld <= 0 in tolerance\n"); return -1; }
+            n->Po=ivMeet(ivMul(n->Vo, Io), ivDrawn(ctx, ivPtr, k));
+            n->Pi[0]=ivDiv(n->Po, n->yeld);
+            n->Pd=ivMul(n->Po, ivSub(ivDiv(ivVal(1), n->yeld), ivVal(1)));
+            n->Ii[0]=ivDiv(n->Pi[0], n->Vi[0]);
+            break;
+         case 2: // LR
+            n->Io=Io;
+            n->Vi[0]=ivInputV(ctx, ivPtr, k, 0);
+            n->Po=ivMeet(ivMul(n->Vo, Io), ivDrawn(ctx, ivPtr, k));
+            n->Ii[0]=ivAdd(Io, n->Iadj);
+            n->Pd=ivAdd(ivMul(Io, ivSub(n->Vi[0], n->Vo)), ivMul(n->Iadj, n->Vi[0]));
+            n->Pi[0]=ivMul(n->Vi[0], n->Ii[0]);
+            break;
+         case 3: // LD
+            n->Pd=ivVal(0);
+            for (int i=0; i<PlanIns(&ctx->plan, k); i++) {
+               int m=ctx->plan.in[k]+i;
+               if (ctx->plan.up[m]<0) continue; // no input connection
+               ivTy V=ivInputV(ctx, ivPtr, k, i);
+               n->Vi[i]=V;
+               if (ctx->plan.mode[m]&LdI) { // know V,I ==> R,P
+                  n->R[i]=ivDiv(V, n->Ii[i]);
+                  n->Pi[i]=ivMul(V, n->Ii[i]);
+               } else if (ctx->plan.mode[m]&LdR) { // know V,R ==> I,P
+                  n->Ii[i]=ivDiv(V, n->R[i]);
+                  n->Pi[i]=ivDiv(ivSqr(V), n->R[i]);
+               } else if (ctx->plan.mode[m]&LdP) { // know V,P ==> I,R
+                  n->Ii[i]=ivDiv(n->Pi[i], V);
+                  n->R[i]=ivDiv(ivSqr(V), n->Pi[i]);
+               } else {
+                  n->Pi[i]=ivVal(0);
+               }
+               n->Pd=ivAdd(n->Pd, n->Pi[i]);
+            }
+            break;
+         case 4: // RS
+            n->Io=Io;
+            n->Ii[0]=Io;
+            n->Pd=ivMul(n->R[0], ivSqr(Io));
+            break;
+         }
+      }
+      dV=0;
+      if (!ctx->plan.hasRS) break;
+      for (int k=1; k<ctx->plan.nodes; k++) { // root to leaves: RS voltages
+         if (ctx->plan.type[k]!=4) continue;
+         double d=ivRSv(ctx, ivPtr, k);
+         if (d>dV) dV=d;
+      }
+      iter++;
+   } while (dV>SolveTol && iter<MaxSolveIter);
+   if (dV>SolveTol && PbLev(ctx)>=PRINTWARN) printf("WARN: RS bounds not stable after %d iterations\n", iter);
+   return 0;
+} // int ivCalc(pbCtx* ctx, ivNodeTy* ivPtr, const ivTy* box)
+
+// bounds of every node value in one leaves to root pass of the plan, all
+// toleranced values in their [lo, hi]. ivPtr from ivAlloc()
+int calcInterval(pbCtx* ctx, ivNodeTy* ivPtr) {
+   if (!ctx->plan.valid && pbCompileNodes(ctx)!=0) return -1;
+   return ivCalc(ctx, ivPtr, NULL);
+} // int calcInterval(pbCtx* ctx, ivNodeTy* ivPtr)
+
+// worst case metric of plan node k: input power for IN, Pd for others
+static inline ivTy wcValue(pbCtx* ctx, ivNodeTy* ivPtr, int k) {
+   return (ctx->plan.type[k]==0) ? ivPtr[k].Po : ivPtr[k].Pd;
+} // ivTy wcValue(pbCtx* ctx, ivNodeTy* ivPtr, int k)
+
+typedef struct wcRunTy { // sub boxes shared by all threads
+    pbCtx* ctx;   // design of the plan
+    int pars;     // split tolerances
+    int* tol;     // [pars] tolList position
+    int* pieces;  // [pars] sub intervals of the tolerance
+    int boxes;    // sub boxes to calc, product of pieces
+    ivTy* full;   // [tolList.cnt] range of every tolerance
+    ivTy* out;    // [plan.nodes] union of the metric over the sub boxes
+    int next;     // next sub box to calc
+    int ret;
+    pthread_mutex_t lock;
+} wcRunTy;
+
+// worker: take next sub box until done, join its metrics in out
+static void* wcThread(void* argPtr) {
+   wcRunTy* runPtr=argPtr;
+   pbCtx* ctx=runPtr->ctx;
+   int nodes=ctx->plan.nodes, cnt=ctx->tolList.cnt;
+   ivNodeTy* ivPtr=ivAlloc(ctx);
+   ivTy* box=malloc((cnt+1)*sizeof(ivTy));
+   ivTy* un=malloc(nodes*sizeof(ivTy));
+   if (ivPtr==NULL || box==NULL || un==NULL) { runPtr->ret=-1; goto done; }
+   for (int k=0; k<nodes; k++) { un[k].lo=HUGE_VAL; un[k].hi=-HUGE_VAL; }
+   memcpy(box, runPtr->full, cnt*sizeof(ivTy));
+   for (;;) {
+      int b=__sync_fetch_and_add(&runPtr->next, 1);
+      if (b>=runPtr->boxes) break;
+      for (int p=0; p<runPtr->pars; p++) { // piece j of tolerance p, mixed radix
+         int t=runPtr->tol[p], s=runPtr->pieces[p], j=b%s;
+         double lo=runPtr->full[t].lo, w=(runPtr->full[t].hi-lo)/s;
+         b/=s;
+         box[t].lo=lo+j*w; // same expression as hi of piece j-1: no gaps
+         box[t].hi=(j==s-1) ? runPtr->full[t].hi : lo+(j+1)*w;
+      }
+      if (ivCalc(ctx, ivPtr, box)!=0) { runPtr->ret=-1; break; }
+      for (int k=0; k<nodes; k++) {
+         ivTy v=wcValue(ctx, ivPtr, k);
+         un[k].lo=fmin(un[k].lo, v.lo);
+         un[k].hi=fmax(un[k].hi, v.hi);
+      }
+   }
+   pthread_mutex_lock(&runPtr->lock);
+   for (int k=0; k<nodes; k++) {
+      runPtr->out[k].lo=fmin(runPtr->out[k].lo, un[k].lo);
+      runPtr->out[k].hi=fmax(runPtr->out[k].hi, un[k].hi);
+   }
+   pthread_mutex_unlock(&runPtr->lock);
+   done:
+   free(ivPtr);
+   free(box);
+   free(un);
+   return NULL;
+} // void* wcThread(void* argPtr)
+
+// calc all sub boxes of the run on threads
+static int wcBoxes(wcRunTy* runPtr, int threads) {
+   runPtr->next=0;
+   runPtr->ret=0;
+   pthread_mutex_init(&runPtr->lock, NULL);
+   pthread_t* th=malloc(threads*sizeof(pthread_t));
+   for (int t=0; t<threads; t++) pthread_create(&th[t], NULL, wcThread, runPtr);
+   for (int t=0; t<threads; t++) pthread_join(th[t], NULL);
+   free(th);
+   pthread_mutex_destroy(&runPtr->lock);
+   return runPtr->ret;
+} // int wcBoxes(wcRunTy* runPtr, int threads)
+
+// worst case: guaranteed bounds of IN power and of every Pd by intervals.
+// With refine, the tolerances that widen the loose bounds most are split in
+// sub intervals and the bounds are the union over all the sub boxes: still
+// guaranteed, tighter as a value used twice (as P/V then V) is bound closer
+int worstCase(pbCtx* ctx, int refine, int threads) {
+   if (!ctx->plan.valid && pbCompileNodes(ctx)!=0) return -1;
+   if (threads<1) threads=sysconf(_SC_NPROCESSORS_ONLN);
+   if (threads<1) threads=1;
+   int nodes=ctx->plan.nodes, cnt=ctx->tolList.cnt;
+   ivNodeTy* ivPtr=ivAlloc(ctx);
+   if (ivPtr==NULL) return -1;
+   int out=calcInterval(ctx, ivPtr);
+   if (out!=0) { free(ivPtr); return out; }
+   wcRunTy run;
+   memset(&run, 0, sizeof(run));
+   run.ctx=ctx;
+   run.tol=malloc((cnt+1)*sizeof(int));
+   run.pieces=malloc((cnt+1)*sizeof(int));
+   run.full=malloc((cnt+1)*sizeof(ivTy));
+   run.out=malloc(nodes*sizeof(ivTy));
+   ivTy* bound=malloc(nodes*sizeof(ivTy));
+   double* weight=malloc((cnt+1)*sizeof(double));
+   ivTy* box=malloc((cnt+1)*sizeof(ivTy));
+   int pars=0, loose=0;
+   for (int t=0; t<cnt; t++) { // only tolerances that are inputs
+      tolTy* tolPtr=&ctx->tolList.tol[t];
+      double lo=tolBound(tolPtr, -1), hi=tolBound(tolPtr, 1);
+      run.full[t].lo=fmin(lo, hi);
+      run.full[t].hi=fmax(lo, hi);
+      box[t]=ivVal(tolPtr->nom);
+      if (ivField(ctx, ivPtr, tolPtr)==NULL) continue;
+      run.tol[pars++]=t;
+   }
+   for (int k=0; k<nodes; k++) {
+      bound[k]=wcValue(ctx, ivPtr, k);
+      if (bound[k].hi-bound[k].lo>SolveTol) loose++;
+   }
+   run.boxes=1;
+   if (refine && pars>0 && loose>0) {
+      // weight: loose bound widths made by a tolerance alone, others nominal
+      for (int p=0; p<pars; p++) {
+         int t=run.tol[p];
+         box[t]=run.full[t];
+         out=ivCalc(ctx, ivPtr, box);
+         box[t]=ivVal(ctx->tolList.tol[t].nom);
+         if (out!=0) goto done;
+         weight[p]=0;
+         for (int k=0; k<nodes; k++) {
+            double w=bound[k].hi-bound[k].lo;
+            if (w<=SolveTol) continue;
+            ivTy v=wcValue(ctx, ivPtr, k);
+            weight[p]+=(v.hi-v.lo)/w;
+         }
+         run.pieces[p]=1;
+      }
+      for (;;) { // double the pieces of the heaviest tolerance per piece
+         int best=-1;
+         for (int p=0; p<pars; p++) {
+            if (weight[p]<=0) continue;
+            if (best<0 || weight[p]/run.pieces[p]>weight[best]/run.pieces[best]) best=p;
+         }
+         if (best<0 || 2*run.boxes>WcBoxes) break;
+         run.pieces[best]*=2;
+         run.boxes*=2;
+      }
+      for (int p=0; p<pars; p++) { // keep only the split tolerances
+         if (run.pieces[p]<2) continue;
+         run.tol[run.pars]=run.tol[p];
+         run.pieces[run.pars++]=run.pieces[p];
+      }
+   }
+   printf("Worst case tolerances:%d threads:%d refine:%s", pars, threads, refine ? "yes" : "no");
+   if (run.pars>0) printf(" split:%d boxes:%d", run.pars, run.boxes);
+   printf("\n");
+   if (run.pars>0) {
+      for (int k=0; k<nodes; k++) { run.out[k].lo=HUGE_VAL; run.out[k].hi=-HUGE_VAL; }
+      out=wcBoxes(&run, threads);
+      if (out!=0) goto done;
+      for (int k=0; k<nodes; k++) { // both are guaranteed, keep the tighter
+         bound[k].lo=fmax(bound[k].lo, run.out[k].lo);
+         bound[k].hi=fmin(bound[k].hi, run.out[k].hi);
+      }
+   }
+   printf("node   refdes  val  bound lo   bound hi\n");
+   for (int k=0; k<nodes; k++) {
+      nTy* node=ctx->plan.node[k];
+      printf("%-6s %-7s %-3s %10.6g %10.6g\n", node->name, node->refdes, (ctx->plan.type[k]==0) ? "P" : "Pd", bound[k].lo, bound[k].hi);
+   }
+   printf("\n");
+   done:
+   free(run.tol);
+   free(run.pieces);
+   free(run.full);
+   free(run.out);
+   free(bound);
+   free(weight);
+   free(box);
+   free(ivPtr);
+   return out;
+} // int worstCase(pbCtx* ctx, int refine, int threads)